@@ -0,0 +1,136 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Matrix.h"
+#include "Layer.h"
+#include "Network.h"
+#include "Activations.h"
+
+// Per-element cost and error of the activation kernels at Exact and Fast
+// precision, against the scalar function-pointer path they replace, and the
+// effect on training throughput of small networks where activations are a
+// noticeable share of the work.
+//
+//   bench_activations [elements] [reps]
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+double exact_value(ActivationKind kind, double x) {
+    switch (kind) {
+        case ActivationKind::ReLU: return x > 0 ? x : 0.0;
+        case ActivationKind::Sigmoid: return 1.0 / (1.0 + std::exp(-x));
+        case ActivationKind::Tanh: return std::tanh(x);
+        case ActivationKind::GELU: return 0.5 * x * (1.0 + std::erf(x / std::sqrt(2.0)));
+        default: return x;
+    }
+}
+
+void bench_kernels(size_t n, int reps) {
+    std::vector<double> z(n), out(n), grad(n, 1.0), d_z(n);
+    for (size_t i = 0; i < n; ++i) z[i] = 16.0 * static_cast<double>(rand()) / RAND_MAX - 8.0;
+
+    Matrix zm(1, static_cast<int>(n), 0.0);
+    std::copy(z.begin(), z.end(), zm.get_host_ptr());
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < reps; ++r) zm.applyFunction(Layer::sigmoid);
+    double pointer_ns = seconds_since(start) * 1e9 / (static_cast<double>(n) * reps);
+    std::cout << "Scalar Layer::sigmoid via applyFunction: " << std::fixed << std::setprecision(2)
+              << pointer_ns << " ns/element" << std::endl << std::endl;
+
+    std::cout << "  " << std::left << std::setw(10) << "function" << std::setw(8) << "mode" << std::right
+              << std::setw(14) << "forward ns" << std::setw(15) << "backward ns" << std::setw(14) << "max error" << std::endl;
+    ActivationKind kinds[] = {ActivationKind::ReLU, ActivationKind::Sigmoid, ActivationKind::Tanh, ActivationKind::GELU};
+    ActivationPrecision modes[] = {ActivationPrecision::Exact, ActivationPrecision::Fast};
+    for (ActivationKind kind : kinds) {
+        for (ActivationPrecision mode : modes) {
+            activations::setPrecision(mode);
+            start = Clock::now();
+            for (int r = 0; r < reps; ++r) activations::apply(kind, z.data(), out.data(), n);
+            double forward_ns = seconds_since(start) * 1e9 / (static_cast<double>(n) * reps);
+
+            start = Clock::now();
+            for (int r = 0; r < reps; ++r) {
+                if (activations::derivative_from_output(kind)) {
+                    activations::gradient_from_output(kind, out.data(), grad.data(), d_z.data(), n);
+                } else {
+                    activations::gradient_from_input(kind, z.data(), grad.data(), d_z.data(), n);
+                }
+            }
+            double backward_ns = seconds_since(start) * 1e9 / (static_cast<double>(n) * reps);
+
+            double max_error = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                max_error = std::max(max_error, std::fabs(out[i] - exact_value(kind, z[i])));
+            }
+            std::cout << "  " << std::left << std::setw(10) << activations::name(kind)
+                      << std::setw(8) << (mode == ActivationPrecision::Fast ? "fast" : "exact") << std::right
+                      << std::fixed << std::setprecision(2) << std::setw(14) << forward_ns << std::setw(15) << backward_ns
+                      << std::scientific << std::setprecision(1) << std::setw(14) << max_error << std::endl;
+        }
+    }
+    activations::setPrecision(ActivationPrecision::Exact);
+}
+
+void bench_training(const std::vector<int>& sizes, const std::vector<std::string>& acts, int reps) {
+    std::vector<Matrix> inputs;
+    std::vector<Matrix> targets;
+    for (int s = 0; s < 64; ++s) {
+        Matrix x(sizes.front(), 1, 0.0);
+        for (int i = 0; i < sizes.front(); ++i) x.setEntry(i, 0, static_cast<double>(rand()) / RAND_MAX);
+        Matrix y(sizes.back(), 1, 0.0);
+        y.setEntry(rand() % sizes.back(), 0, 1.0);
+        inputs.push_back(x);
+        targets.push_back(y);
+    }
+
+    std::cout << "  ";
+    for (size_t i = 0; i < sizes.size(); ++i) std::cout << (i ? "-" : "") << sizes[i];
+    std::cout << " (";
+    for (size_t i = 0; i < acts.size(); ++i) std::cout << (i ? ", " : "") << acts[i];
+    std::cout << "):";
+
+    ActivationPrecision modes[] = {ActivationPrecision::Exact, ActivationPrecision::Fast};
+    double exact_rate = 0.0;
+    for (ActivationPrecision mode : modes) {
+        activations::setPrecision(mode);
+        Network net(sizes, acts);
+        net.train_on_batch(inputs, targets, 0.01);
+        Clock::time_point start = Clock::now();
+        for (int r = 0; r < reps; ++r) net.train_on_batch(inputs, targets, 0.01);
+        double rate = static_cast<double>(reps) * inputs.size() / seconds_since(start);
+        std::cout << "  " << (mode == ActivationPrecision::Fast ? "fast " : "exact ")
+                  << std::fixed << std::setprecision(0) << rate << " samples/s";
+        if (mode == ActivationPrecision::Exact) exact_rate = rate;
+        else std::cout << " (" << std::setprecision(2) << rate / exact_rate << "x)";
+    }
+    std::cout << std::endl;
+    activations::setPrecision(ActivationPrecision::Exact);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t elements = (argc > 1) ? static_cast<size_t>(std::atol(argv[1])) : 1 << 16;
+    int reps = (argc > 2) ? std::atoi(argv[2]) : 200;
+    srand(42);
+
+    bench_kernels(elements, reps);
+
+    std::cout << std::endl << "Training throughput, batch 64:" << std::endl;
+    bench_training({64, 32, 32, 10}, {"sigmoid", "sigmoid", "sigmoid"}, reps);
+    bench_training({64, 32, 32, 10}, {"tanh", "tanh", "sigmoid"}, reps);
+    bench_training({64, 32, 32, 10}, {"gelu", "gelu", "sigmoid"}, reps);
+    bench_training({784, 100, 10}, {"relu", "sigmoid"}, reps / 10 + 1);
+    return 0;
+}
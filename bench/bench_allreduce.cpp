@@ -0,0 +1,160 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "Communicator.h"
+
+// Checks ShmCommunicator::allreduce_sum on forked ranks with a small slot, at
+// counts around multiples of the slot capacity with count % ranks != 0, where
+// the ring chunks differ in length by one and can need different numbers of
+// exchange rounds. Then reports the allreduce bandwidth with the default slot.
+// Every rank must return the exact sum within the time limit, or the program
+// fails.
+//
+//   bench_allreduce [ranks]
+
+namespace {
+
+const unsigned TIME_LIMIT_SECONDS = 30;
+
+// Small integers, so every summation order gives the exact sum.
+double value(int rank, size_t i) {
+    return static_cast<double>(rank * 1000 + static_cast<int>(i % 997));
+}
+
+// Runs in a child process; returns 0 when every element of every count matched.
+// seconds[c] receives the mean time of one allreduce of counts[c].
+int run_rank(int rank, int ranks, const std::string& name, size_t slot_capacity, const std::vector<size_t>& counts,
+             int repeats, double* seconds) {
+    ShmCommunicator comm(rank, ranks, name, slot_capacity);
+    for (size_t c = 0; c < counts.size(); ++c) {
+        size_t count = counts[c];
+        std::vector<double> data(count);
+        double total = 0.0;
+        for (int r = 0; r < repeats; ++r) {
+            for (size_t i = 0; i < count; ++i) data[i] = value(rank, i);
+            comm.barrier();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            comm.allreduce_sum(data.data(), count);
+            total += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        seconds[c] = total / repeats;
+        for (size_t i = 0; i < count; ++i) {
+            double expected = 0.0;
+            for (int k = 0; k < ranks; ++k) expected += value(k, i);
+            if (data[i] != expected) {
+                std::cerr << "  rank " << rank << ", count " << count << ": element " << i << " is " << data[i]
+                          << ", expected " << expected << std::endl;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Forks the ranks and waits for them. Returns false if any rank failed, crashed
+// or hung; otherwise seconds holds rank 0's mean time per count.
+bool run_job(int ranks, size_t slot_capacity, const std::vector<size_t>& counts, int repeats, std::vector<double>& seconds) {
+    static int job = 0;
+    std::string name = "/nn_bench_allreduce_" + std::to_string(getpid()) + "_" + std::to_string(job++);
+    size_t bytes = counts.size() * sizeof(double);
+    void* shared = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        std::cerr << "mmap failed" << std::endl;
+        return false;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<pid_t> children;
+    for (int rank = 0; rank < ranks; ++rank) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "fork failed" << std::endl;
+            break;
+        }
+        if (pid == 0) {
+            alarm(TIME_LIMIT_SECONDS);
+            std::vector<double> rank_seconds(counts.size(), 0.0);
+            int status = 1;
+            try {
+                status = run_rank(rank, ranks, name, slot_capacity, counts, repeats, rank_seconds.data());
+            } catch (const std::exception& e) {
+                std::cerr << "  rank " << rank << ": " << e.what() << std::endl;
+            }
+            if (rank == 0) std::copy(rank_seconds.begin(), rank_seconds.end(), static_cast<double*>(shared));
+            _exit(status);
+        }
+        children.push_back(pid);
+    }
+
+    bool ok = static_cast<int>(children.size()) == ranks;
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (WIFSIGNALED(status)) {
+            std::cerr << "  a rank was killed by signal " << WTERMSIG(status)
+                      << (WTERMSIG(status) == SIGALRM ? " (time limit; the ranks are stuck in a barrier)" : "") << std::endl;
+            ok = false;
+        } else if (WEXITSTATUS(status) != 0) {
+            ok = false;
+        }
+        if (!ok) {
+            for (pid_t other : children) kill(other, SIGKILL);
+        }
+    }
+    seconds.assign(static_cast<double*>(shared), static_cast<double*>(shared) + counts.size());
+    munmap(shared, bytes);
+    shm_unlink(name.c_str());
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int ranks = (argc > 1) ? std::atoi(argv[1]) : 3;
+    if (ranks < 2) {
+        std::cerr << "Usage: " << argv[0] << " [ranks >= 2]" << std::endl;
+        return 2;
+    }
+
+    bool all_ok = true;
+    const size_t small_slots[] = {1, 4, 7};
+    std::cout << "Exact sums on " << ranks << " ranks, counts around multiples of the slot capacity:" << std::endl;
+    for (size_t slot : small_slots) {
+        std::vector<size_t> counts;
+        for (size_t m = 0; m <= 3; ++m) {
+            size_t center = m * slot * static_cast<size_t>(ranks);
+            for (size_t c = (center > static_cast<size_t>(ranks) ? center - ranks : 1); c <= center + ranks; ++c) {
+                counts.push_back(c);
+            }
+        }
+        std::vector<double> seconds;
+        bool ok = run_job(ranks, slot, counts, 1, seconds);
+        std::cout << "  slot " << std::setw(2) << slot << ": counts " << counts.front() << ".." << counts.back()
+                  << (ok ? "  ok" : "  FAILED") << std::endl;
+        all_ok = all_ok && ok;
+    }
+
+    std::cout << "Bandwidth with the default slot (" << (1 << 20) << " doubles):" << std::endl;
+    std::vector<size_t> counts = {1000, 100000, 1000000, (size_t(1) << 20) * static_cast<size_t>(ranks) + 1};
+    std::vector<double> seconds;
+    bool ok = run_job(ranks, size_t(1) << 20, counts, 5, seconds);
+    for (size_t c = 0; c < counts.size() && ok; ++c) {
+        std::cout << "  " << std::setw(9) << counts[c] << " doubles: " << std::fixed << std::setprecision(3)
+                  << seconds[c] * 1e3 << " ms, " << std::setprecision(2)
+                  << counts[c] * sizeof(double) / seconds[c] / 1e9 << " GB/s" << std::endl;
+    }
+    if (!ok) std::cout << "  FAILED" << std::endl;
+    all_ok = all_ok && ok;
+
+    std::cout << (all_ok ? "All allreduce checks passed." : "Allreduce check FAILED.") << std::endl;
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+#include "Matrix.h"
+#include "SparseMatrix.h"
+#include "Network.h"
+#include "WeightInitializer.h"
+
+// Checks that activation checkpointing (Network::set_activation_checkpoint_interval)
+// leaves gradients bit-identical: for dense and CSR input, with activation
+// sparsity on and off, the delta_weights and delta_biases of one batch and the
+// weights after a few training steps must match the k = 1 run exactly. Also
+// reports the time per batch, i.e. the cost of the recomputation. Exits with 1
+// on any mismatch.
+//
+//   bench_checkpointing [batches]
+
+namespace {
+
+const int FEATURES = 64;
+const int CLASSES = 10;
+const int BATCH_SIZE = 16;
+
+struct Batch {
+    std::vector<Matrix> inputs;
+    std::vector<Matrix> targets;
+    SparseMatrix sparse_inputs;
+};
+
+// About 70% zero features, like blank pixels.
+Batch make_batch(std::mt19937& rng) {
+    std::uniform_real_distribution<double> value(0.0, 1.0);
+    std::uniform_int_distribution<int> label(0, CLASSES - 1);
+    Batch batch;
+    batch.sparse_inputs = SparseMatrix(FEATURES);
+    for (int s = 0; s < BATCH_SIZE; ++s) {
+        Matrix x(FEATURES, 1, 0.0);
+        double* v = x.get_host_ptr();
+        for (int i = 0; i < FEATURES; ++i) {
+            double r = value(rng);
+            v[i] = r < 0.7 ? 0.0 : value(rng);
+        }
+        Matrix y(CLASSES, 1, 0.0);
+        y.setEntry(label(rng), 0, 1.0);
+        batch.sparse_inputs.appendRow(v, FEATURES);
+        batch.inputs.push_back(x);
+        batch.targets.push_back(y);
+    }
+    return batch;
+}
+
+bool same(const Matrix& a, const Matrix& b) {
+    size_t n = static_cast<size_t>(a.getRow()) * a.getCol();
+    return a.getRow() == b.getRow() && a.getCol() == b.getCol() &&
+           std::memcmp(a.get_host_ptr(), b.get_host_ptr(), n * sizeof(double)) == 0;
+}
+
+// Empty when identical, else the first differing matrix.
+std::string compare(const Network& a, const Network& b, bool deltas) {
+    for (size_t l = 0; l < a.getLayers().size(); ++l) {
+        const Layer& x = a.getLayers()[l];
+        const Layer& y = b.getLayers()[l];
+        if (deltas) {
+            if (!same(x.delta_weights, y.delta_weights)) return "delta_weights of layer " + std::to_string(l);
+            if (!same(x.delta_biases, y.delta_biases)) return "delta_biases of layer " + std::to_string(l);
+        } else {
+            if (!same(x.weights, y.weights)) return "weights of layer " + std::to_string(l);
+            if (!same(x.biases, y.biases)) return "biases of layer " + std::to_string(l);
+        }
+    }
+    return std::string();
+}
+
+// Gradients of the first batch (returned), then one training step on each of
+// the other batches into after_steps.
+Network run(const Network& base, int k, bool sparse_input, bool activation_sparsity, const std::vector<Batch>& batches,
+            Network& after_steps, double& seconds_per_batch) {
+    Layer::setActivationSparsity(activation_sparsity);
+    Network net = base;
+    net.set_activation_checkpoint_interval(k);
+    if (sparse_input) net.accumulate_sparse_batch_gradients(batches[0].sparse_inputs, batches[0].targets);
+    else net.accumulate_batch_gradients(batches[0].inputs, batches[0].targets);
+
+    after_steps = base;
+    after_steps.set_activation_checkpoint_interval(k);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t b = 1; b < batches.size(); ++b) {
+        if (sparse_input) after_steps.train_on_sparse_batch(batches[b].sparse_inputs, batches[b].targets, 0.05);
+        else after_steps.train_on_batch(batches[b].inputs, batches[b].targets, 0.05);
+    }
+    seconds_per_batch = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() /
+                        static_cast<double>(batches.size() - 1);
+    Layer::setActivationSparsity(true);
+    return net;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int batch_count = (argc > 1) ? std::atoi(argv[1]) : 20;
+    if (batch_count < 1) {
+        std::cerr << "Usage: " << argv[0] << " [batches >= 1]" << std::endl;
+        return 2;
+    }
+
+    std::mt19937 rng(123);
+    std::vector<Batch> batches;
+    for (int b = 0; b <= batch_count; ++b) batches.push_back(make_batch(rng));
+
+    // Ten dense layers mixing activations that keep their output (relu, tanh,
+    // sigmoid) with one that keeps the pre-activation (gelu).
+    std::vector<int> sizes = {FEATURES, 48, 48, 40, 40, 32, 32, 32, 24, 24, CLASSES};
+    std::vector<std::string> acts = {"relu", "relu", "tanh", "relu", "gelu", "relu", "relu", "sigmoid", "relu", "sigmoid"};
+    Network base(sizes, acts, WeightInit(InitScheme::HeUniform), 11);
+    const int intervals[] = {1, 2, 3, 4, 7, 10};
+
+    bool all_ok = true;
+    std::cout << "Network of " << sizes.size() - 1 << " layers, batch " << BATCH_SIZE << ", " << batch_count
+              << " training steps; each run is compared bit for bit with k = 1 on the same input with activation sparsity on" << std::endl;
+    std::cout << "  " << std::left << std::setw(8) << "input" << std::setw(11) << "sparsity" << std::right << std::setw(4) << "k"
+              << std::setw(12) << "ms/batch" << "  result" << std::endl;
+    for (int input = 0; input < 2; ++input) {
+        bool sparse_input = (input == 1);
+        Network reference_steps = base;
+        double unused = 0.0;
+        Network reference = run(base, 1, sparse_input, true, batches, reference_steps, unused);
+        for (int sparsity = 1; sparsity >= 0; --sparsity) {
+            for (int k : intervals) {
+                Network steps = base;
+                double seconds = 0.0;
+                Network net = run(base, k, sparse_input, sparsity == 1, batches, steps, seconds);
+                std::string mismatch = compare(reference, net, true);
+                if (mismatch.empty()) mismatch = compare(reference_steps, steps, false);
+                bool ok = mismatch.empty();
+                all_ok = all_ok && ok;
+                std::cout << "  " << std::left << std::setw(8) << (sparse_input ? "csr" : "dense") << std::setw(11)
+                          << (sparsity ? "on" : "off") << std::right << std::setw(4) << k << std::setw(12) << std::fixed
+                          << std::setprecision(3) << seconds * 1e3 << "  " << (ok ? "identical" : "MISMATCH in " + mismatch)
+                          << std::endl;
+            }
+        }
+    }
+
+    std::cout << (all_ok ? "Checkpointed gradients are bit-identical." : "Checkpointed gradients DIFFER.") << std::endl;
+    return all_ok ? 0 : 1;
+}
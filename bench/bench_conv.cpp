@@ -0,0 +1,120 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "SpatialLayer.h"
+#include "MNISTLoader.h"
+
+// Training throughput, inference latency and accuracy of a small convolutional
+// model against the dense 784-100-10 model on MNIST.
+//
+//   bench_conv [data_dir] [train_items] [epochs] [learning_rate]
+
+namespace {
+
+size_t parameter_count(const Network& net) {
+    size_t total = 0;
+    for (const SpatialLayer& layer : net.getFeatureLayers()) {
+        total += static_cast<size_t>(layer.weights.getRow()) * layer.weights.getCol() + layer.biases.getRow();
+    }
+    for (const Layer& layer : net.getLayers()) {
+        total += static_cast<size_t>(layer.weights.getRow()) * layer.weights.getCol() + layer.biases.getRow();
+    }
+    return total;
+}
+
+int argmax(const Matrix& m) {
+    int best = 0;
+    for (int i = 1; i < m.getRow(); ++i) {
+        if (m.getEntry(i, 0) > m.getEntry(best, 0)) best = i;
+    }
+    return best;
+}
+
+void run(const std::string& name, Network net, const MNISTDataset& train, const MNISTDataset& test,
+         int epochs, double learning_rate) {
+    const size_t batch_size = 32;
+    std::default_random_engine rng(123);
+    std::vector<size_t> indices(train.images.size());
+
+    auto train_start = std::chrono::steady_clock::now();
+    double last_loss = 0.0;
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        std::iota(indices.begin(), indices.end(), 0);
+        std::shuffle(indices.begin(), indices.end(), rng);
+        double epoch_loss = 0.0;
+        for (size_t i = 0; i < indices.size(); i += batch_size) {
+            size_t end = std::min(i + batch_size, indices.size());
+            std::vector<Matrix> inputs, targets;
+            for (size_t j = i; j < end; ++j) {
+                inputs.push_back(train.images[indices[j]]);
+                targets.push_back(train.labels[indices[j]]);
+            }
+            epoch_loss += net.train_on_batch(inputs, targets, learning_rate) * static_cast<double>(end - i);
+        }
+        last_loss = epoch_loss / static_cast<double>(indices.size());
+    }
+    std::chrono::duration<double> train_elapsed = std::chrono::steady_clock::now() - train_start;
+
+    int correct = 0;
+    auto infer_start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < test.images.size(); ++k) {
+        if (test.labels[k].getEntry(argmax(net.infer(test.images[k].view())), 0) == 1.0) {
+            correct++;
+        }
+    }
+    std::chrono::duration<double, std::micro> infer_elapsed = std::chrono::steady_clock::now() - infer_start;
+
+    std::cout << "  " << std::left << std::setw(48) << name << std::right
+              << std::setw(10) << parameter_count(net)
+              << std::fixed << std::setprecision(0) << std::setw(14) << (train.images.size() * epochs) / train_elapsed.count()
+              << std::setprecision(1) << std::setw(14) << infer_elapsed.count() / test.images.size()
+              << std::setprecision(5) << std::setw(12) << last_loss
+              << std::setprecision(2) << std::setw(10) << 100.0 * correct / test.images.size() << "%" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string dir = (argc > 1) ? std::string(argv[1]) + "/" : "";
+    int train_items = (argc > 2) ? std::atoi(argv[2]) : 10000;
+    int epochs = (argc > 3) ? std::atoi(argv[3]) : 3;
+    double learning_rate = (argc > 4) ? std::atof(argv[4]) : 0.1;
+
+    MNISTDataset train = MNISTLoader::load(dir + "train-images-idx3-ubyte", dir + "train-labels-idx1-ubyte", train_items);
+    MNISTDataset test = MNISTLoader::load(dir + "t10k-images-idx3-ubyte", dir + "t10k-labels-idx1-ubyte", 2000);
+
+    std::cout << "\n" << train.images.size() << " training samples, " << epochs << " epochs, learning rate "
+              << learning_rate << ", batch 32:" << std::endl;
+    std::cout << "  " << std::left << std::setw(48) << "model" << std::right << std::setw(10) << "params"
+              << std::setw(14) << "train smp/s" << std::setw(14) << "infer us/smp" << std::setw(12) << "loss"
+              << std::setw(11) << "accuracy" << std::endl;
+
+    srand(123);
+    run("dense 784-100-10", Network({784, 100, 10}, {"relu", "sigmoid"}), train, test, epochs, learning_rate);
+
+    srand(123);
+    SpatialShape image(1, 28, 28);
+    SpatialLayer conv = SpatialLayer::conv2d(image, 8, 5, 1, 0, "relu");
+    SpatialLayer pool = SpatialLayer::max_pool(conv.getOutputShape(), 2);
+    run("conv 8@5x5 -> maxpool 2 -> 10", Network({conv, pool}, {pool.getOutputSize(), 10}, {"sigmoid"}),
+        train, test, epochs, learning_rate);
+
+    srand(123);
+    SpatialLayer conv_a = SpatialLayer::conv2d(image, 8, 3, 1, 1, "relu");
+    SpatialLayer pool_a = SpatialLayer::avg_pool(conv_a.getOutputShape(), 2);
+    SpatialLayer conv_b = SpatialLayer::conv2d(pool_a.getOutputShape(), 16, 3, 1, 1, "relu");
+    SpatialLayer pool_b = SpatialLayer::max_pool(conv_b.getOutputShape(), 2);
+    run("conv 8@3x3 -> avgpool -> 16@3x3 -> maxpool -> 10",
+        Network({conv_a, pool_a, conv_b, pool_b}, {pool_b.getOutputSize(), 10}, {"sigmoid"}),
+        train, test, epochs, learning_rate);
+    return 0;
+}
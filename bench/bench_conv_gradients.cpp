@@ -0,0 +1,152 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "SpatialLayer.h"
+
+// Finite-difference check of SpatialLayer backward (im2col/col2im convolution,
+// max and average pooling) and of a whole Network with feature layers. Each
+// analytic gradient is compared with a central difference of the loss; the
+// program exits with 1 if the max relative error exceeds the tolerance.
+// Smooth activations (tanh, sigmoid) and random real inputs keep the loss
+// differentiable: no ReLU kinks and no max-pool ties.
+//
+//   bench_conv_gradients
+
+namespace {
+
+const double STEP = 1e-5;
+const double TOLERANCE = 1e-5;
+
+std::mt19937 rng(2024);
+
+Matrix random_matrix(int rows, int cols, double scale) {
+    std::uniform_real_distribution<double> value(-scale, scale);
+    Matrix m(rows, cols, 0.0);
+    double* v = m.get_host_ptr();
+    for (size_t i = 0; i < static_cast<size_t>(rows) * cols; ++i) v[i] = value(rng);
+    return m;
+}
+
+double relative_error(double analytic, double numeric) {
+    return std::fabs(analytic - numeric) / std::max(1e-6, std::max(std::fabs(analytic), std::fabs(numeric)));
+}
+
+// Loss sum_i c_i * out_i of a single stage, so d_output = c.
+double stage_loss(const SpatialLayer& layer, const Matrix& x, const Matrix& c) {
+    Matrix out = layer.infer(x.view());
+    double loss = 0.0;
+    for (int i = 0; i < out.getRow(); ++i) loss += c.getEntry(i, 0) * out.getEntry(i, 0);
+    return loss;
+}
+
+// Max relative error over every weight, bias and input element of one stage.
+double check_stage(SpatialLayer layer) {
+    Matrix x = random_matrix(layer.getInputSize(), 1, 1.0);
+    Matrix c = random_matrix(layer.getOutputSize(), 1, 1.0);
+    if (layer.has_parameters()) layer.zero_deltas();
+    layer.forward(x.view());
+    Matrix d_input = layer.backward(c, true);
+
+    double worst = 0.0;
+    std::vector<std::pair<Matrix*, const Matrix*> > checked;
+    if (layer.has_parameters()) {
+        checked.push_back(std::make_pair(&layer.weights, &layer.delta_weights));
+        checked.push_back(std::make_pair(&layer.biases, &layer.delta_biases));
+    }
+    checked.push_back(std::make_pair(&x, &d_input));
+    for (const std::pair<Matrix*, const Matrix*>& p : checked) {
+        double* v = p.first->get_host_ptr();
+        for (size_t i = 0; i < static_cast<size_t>(p.first->getRow()) * p.first->getCol(); ++i) {
+            double saved = v[i];
+            v[i] = saved + STEP;
+            double plus = stage_loss(layer, x, c);
+            v[i] = saved - STEP;
+            double minus = stage_loss(layer, x, c);
+            v[i] = saved;
+            worst = std::max(worst, relative_error(p.second->get_host_ptr()[i], (plus - minus) / (2.0 * STEP)));
+        }
+    }
+    return worst;
+}
+
+// Max relative error over the parameters of every feature and dense layer,
+// with the gradients from Network::accumulate_batch_gradients on one sample.
+double check_network(Network net) {
+    Matrix x = random_matrix(net.getFeatureLayers().front().getInputSize(), 1, 1.0);
+    Matrix target = random_matrix(net.getLayers().back().weights.getRow(), 1, 1.0);
+    net.accumulate_batch_gradients({x}, {target});
+
+    std::vector<std::pair<Matrix*, const Matrix*> > checked;
+    for (SpatialLayer& layer : net.getFeatureLayers()) {
+        if (!layer.has_parameters()) continue;
+        checked.push_back(std::make_pair(&layer.weights, &layer.delta_weights));
+        checked.push_back(std::make_pair(&layer.biases, &layer.delta_biases));
+    }
+    for (Layer& layer : net.getLayers()) {
+        checked.push_back(std::make_pair(&layer.weights, &layer.delta_weights));
+        checked.push_back(std::make_pair(&layer.biases, &layer.delta_biases));
+    }
+    double worst = 0.0;
+    for (const std::pair<Matrix*, const Matrix*>& p : checked) {
+        double* v = p.first->get_host_ptr();
+        for (size_t i = 0; i < static_cast<size_t>(p.first->getRow()) * p.first->getCol(); ++i) {
+            double saved = v[i];
+            v[i] = saved + STEP;
+            double plus = net.meanSquaredError(net.infer(x.view()), target);
+            v[i] = saved - STEP;
+            double minus = net.meanSquaredError(net.infer(x.view()), target);
+            v[i] = saved;
+            worst = std::max(worst, relative_error(p.second->get_host_ptr()[i], (plus - minus) / (2.0 * STEP)));
+        }
+    }
+    return worst;
+}
+
+} // namespace
+
+int main() {
+    srand(7);
+    SpatialShape small(2, 7, 7);
+    SpatialShape even(3, 8, 8);
+
+    std::vector<std::pair<std::string, SpatialLayer> > stages = {
+        {"conv 4@3x3, 2x7x7", SpatialLayer::conv2d(small, 4, 3, 1, 0, "tanh")},
+        {"conv 4@3x3 stride 2 pad 1, 2x7x7", SpatialLayer::conv2d(small, 4, 3, 2, 1, "tanh")},
+        {"conv 5@2x2 stride 1 pad 1, 3x8x8", SpatialLayer::conv2d(even, 5, 2, 1, 1, "sigmoid")},
+        {"maxpool 2, 3x8x8", SpatialLayer::max_pool(even, 2)},
+        {"maxpool 3 stride 2, 2x7x7", SpatialLayer::max_pool(small, 3, 2)},
+        {"avgpool 2, 3x8x8", SpatialLayer::avg_pool(even, 2)},
+        {"avgpool 3 stride 2, 2x7x7", SpatialLayer::avg_pool(small, 3, 2)},
+    };
+
+    bool failed = false;
+    std::cout << "Max relative error of analytic vs central-difference gradients (step " << STEP << ", tolerance "
+              << TOLERANCE << "):" << std::endl;
+    for (const std::pair<std::string, SpatialLayer>& stage : stages) {
+        double error = check_stage(stage.second);
+        failed = failed || !(error <= TOLERANCE);
+        std::cout << "  " << std::left << std::setw(40) << stage.first << std::right << std::scientific << std::setprecision(2)
+                  << std::setw(10) << error << (error <= TOLERANCE ? "" : "  FAILED") << std::endl;
+    }
+
+    SpatialShape image(1, 12, 12);
+    SpatialLayer conv_a = SpatialLayer::conv2d(image, 3, 3, 1, 1, "tanh");
+    SpatialLayer pool_a = SpatialLayer::avg_pool(conv_a.getOutputShape(), 2);
+    SpatialLayer conv_b = SpatialLayer::conv2d(pool_a.getOutputShape(), 4, 3, 2, 1, "tanh");
+    SpatialLayer pool_b = SpatialLayer::max_pool(conv_b.getOutputShape(), 3, 1);
+    Network net({conv_a, pool_a, conv_b, pool_b}, {pool_b.getOutputSize(), 6, 3}, {"tanh", "sigmoid"});
+    double error = check_network(net);
+    failed = failed || !(error <= TOLERANCE);
+    std::cout << "  " << std::left << std::setw(40) << "network conv-avgpool-conv-maxpool-6-3" << std::right
+              << std::setw(10) << error << (error <= TOLERANCE ? "" : "  FAILED") << std::endl;
+
+    std::cout << (failed ? "Gradient check FAILED." : "All gradient checks passed.") << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "FusedNetwork.h"
+
+// Inference latency and throughput of Network::infer (one GEMM and one fresh
+// Matrix per layer for the whole batch) against FusedNetwork (tiles of the
+// batch run through all layers in cache-resident buffers) at several batch
+// sizes, plus the largest output difference between the two.
+//
+//   bench_fused [layers, e.g. 784,100,10] [seconds per measurement]
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Calls per round so that one round takes about round_seconds.
+template <typename F>
+int calibrate(F call, double round_seconds) {
+    call();
+    Clock::time_point start = Clock::now();
+    int calls = 0;
+    while (std::chrono::duration<double>(Clock::now() - start).count() < round_seconds || calls < 3) {
+        call();
+        ++calls;
+    }
+    return calls;
+}
+
+template <typename F>
+double time_round(F call, int repeats) {
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < repeats; ++r) call();
+    return std::chrono::duration<double>(Clock::now() - start).count() / repeats;
+}
+
+// Median seconds per call of a and b over 9 alternating rounds, so drift in
+// machine speed affects both alike.
+template <typename A, typename B>
+void time_pair(A a, B b, double total_seconds, double& a_seconds, double& b_seconds) {
+    int a_repeats = calibrate(a, total_seconds / 20);
+    int b_repeats = calibrate(b, total_seconds / 20);
+    std::vector<double> a_samples, b_samples;
+    for (int round = 0; round < 9; ++round) {
+        a_samples.push_back(time_round(a, a_repeats));
+        b_samples.push_back(time_round(b, b_repeats));
+    }
+    std::sort(a_samples.begin(), a_samples.end());
+    std::sort(b_samples.begin(), b_samples.end());
+    a_seconds = a_samples[4];
+    b_seconds = b_samples[4];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<int> sizes = {784, 100, 10};
+    if (argc > 1) {
+        sizes.clear();
+        std::stringstream ss(argv[1]);
+        std::string part;
+        while (std::getline(ss, part, ',')) sizes.push_back(std::atoi(part.c_str()));
+    }
+    double seconds = (argc > 2) ? std::atof(argv[2]) : 0.5;
+    if (sizes.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " [layers] [seconds]" << std::endl;
+        return 2;
+    }
+
+    std::vector<std::string> acts(sizes.size() - 1, "relu");
+    acts.back() = "sigmoid";
+    srand(5);
+    Network net(sizes, acts);
+    FusedNetwork fused(net);
+
+    std::cout << "Topology";
+    for (size_t i = 0; i < sizes.size(); ++i) std::cout << (i ? "-" : " ") << sizes[i];
+    std::cout << ", fused tile " << fused.tile_size() << " samples" << std::endl;
+    std::cout << "  " << std::setw(6) << "batch" << std::setw(16) << "layered us" << std::setw(14) << "fused us"
+              << std::setw(16) << "layered/s" << std::setw(14) << "fused/s" << std::setw(10) << "speedup"
+              << std::setw(14) << "max |diff|" << std::endl;
+
+    for (int batch : {1, 4, 16, 64, 256, 1024}) {
+        Matrix input(sizes.front(), batch, 0.0);
+        for (int i = 0; i < sizes.front(); ++i) {
+            for (int j = 0; j < batch; ++j) input.setEntry(i, j, static_cast<double>(rand()) / RAND_MAX);
+        }
+        MatrixView view = input.view();
+        double layered = 0.0;
+        double fused_time = 0.0;
+        time_pair([&] { volatile double sink = net.infer(view).getEntry(0, 0); (void)sink; },
+                  [&] { volatile double sink = fused.infer(view).getEntry(0, 0); (void)sink; },
+                  seconds, layered, fused_time);
+
+        Matrix a = net.infer(view);
+        Matrix b = fused.infer(view);
+        double diff = 0.0;
+        for (int i = 0; i < a.getRow(); ++i) {
+            for (int j = 0; j < a.getCol(); ++j) diff = std::max(diff, std::fabs(a.getEntry(i, j) - b.getEntry(i, j)));
+        }
+        std::cout << "  " << std::setw(6) << batch << std::fixed << std::setprecision(2)
+                  << std::setw(16) << layered * 1e6 << std::setw(14) << fused_time * 1e6
+                  << std::setprecision(0) << std::setw(16) << batch / layered << std::setw(14) << batch / fused_time
+                  << std::setprecision(2) << std::setw(9) << layered / fused_time << "x"
+                  << std::scientific << std::setw(14) << diff << std::endl;
+    }
+
+    std::cout << "  Tile sweep at batch 1024:";
+    Matrix input(sizes.front(), 1024, 0.0);
+    for (int i = 0; i < sizes.front(); ++i) {
+        for (int j = 0; j < 1024; ++j) input.setEntry(i, j, static_cast<double>(rand()) / RAND_MAX);
+    }
+    for (int tile : {4, 8, 16, 32, 64}) {
+        FusedNetwork tiled(net, tile);
+        auto call = [&] { volatile double sink = tiled.infer(input.view()).getEntry(0, 0); (void)sink; };
+        int repeats = calibrate(call, seconds / 10);
+        std::vector<double> rounds;
+        for (int round = 0; round < 5; ++round) rounds.push_back(time_round(call, repeats));
+        std::sort(rounds.begin(), rounds.end());
+        double t = rounds[2];
+        std::cout << "  " << tile << ": " << std::fixed << std::setprecision(0) << 1024 / t << "/s";
+    }
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "WeightInitializer.h"
+
+// Construction time of a wide MLP with the rand()-based Layer constructor
+// against the Philox WeightInitializer at increasing thread counts, a check
+// that every thread count yields bit-identical weights, and the sample mean
+// and standard deviation of each scheme against its target. Exits with 1 if the
+// generator misses a Random123 known-answer vector or a thread count differs.
+//
+//   bench_init [width] [layers]
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Best of three, so page faults on the first allocation do not count.
+template <typename F>
+double best_of_three(F build) {
+    double best = 1e30;
+    for (int run = 0; run < 3; ++run) {
+        Clock::time_point start = Clock::now();
+        build();
+        best = std::min(best, seconds_since(start));
+    }
+    return best;
+}
+
+bool same_weights(const Network& a, const Network& b) {
+    for (size_t l = 0; l < a.getLayers().size(); ++l) {
+        const Matrix& x = a.getLayers()[l].weights;
+        const Matrix& y = b.getLayers()[l].weights;
+        size_t n = static_cast<size_t>(x.getRow()) * x.getCol();
+        if (std::memcmp(x.get_host_ptr(), y.get_host_ptr(), n * sizeof(double)) != 0) return false;
+    }
+    return true;
+}
+
+// Random123 known-answer vectors for philox4x32-10: counter, key, expected.
+struct PhiloxVector {
+    uint32_t counter[4];
+    uint32_t key[2];
+    uint32_t expected[4];
+};
+
+const PhiloxVector PHILOX_VECTORS[] = {
+    {{0x00000000, 0x00000000, 0x00000000, 0x00000000}, {0x00000000, 0x00000000},
+     {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+    {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff},
+     {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+    {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0},
+     {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+};
+
+bool philox_matches_known_answers() {
+    bool ok = true;
+    for (const PhiloxVector& v : PHILOX_VECTORS) {
+        uint32_t block[4] = {v.counter[0], v.counter[1], v.counter[2], v.counter[3]};
+        WeightInitializer::philox4x32_10(block, v.key[0], v.key[1]);
+        ok = ok && std::equal(block, block + 4, v.expected);
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int width = (argc > 1) ? std::atoi(argv[1]) : 2048;
+    int depth = (argc > 2) ? std::atoi(argv[2]) : 4;
+    std::vector<int> sizes(static_cast<size_t>(depth) + 1, width);
+    std::vector<std::string> acts(static_cast<size_t>(depth), "relu");
+    double parameters = static_cast<double>(width) * width * depth;
+
+    bool failed = !philox_matches_known_answers();
+    std::cout << "Philox4x32-10 known-answer vectors: " << (failed ? "MISMATCH" : "ok") << std::endl;
+
+    std::cout << depth << " layers of " << width << "x" << width << " (" << std::fixed << std::setprecision(1)
+              << parameters / 1e6 << "M weights), " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+    srand(1);
+    double legacy_seconds = best_of_three([&] { Network legacy(sizes, acts); });
+    std::cout << "  rand() Layer constructor: " << std::setprecision(3) << legacy_seconds << " s ("
+              << std::setprecision(0) << parameters / legacy_seconds / 1e6 << "M weights/s)" << std::endl;
+
+    WeightInit xavier(InitScheme::XavierUniform);
+    Network reference(sizes, acts, xavier, 42, 1);
+    unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; threads <= max_threads * 2; threads *= 2) {
+        double t = best_of_three([&] { Network net(sizes, acts, xavier, 42, static_cast<int>(threads)); });
+        Network net(sizes, acts, xavier, 42, static_cast<int>(threads));
+        bool identical = same_weights(reference, net);
+        failed = failed || !identical;
+        std::cout << "  Philox, " << std::setw(2) << threads << " threads: " << std::setprecision(3) << t << " s ("
+                  << std::setprecision(0) << parameters / t / 1e6 << "M weights/s, " << std::setprecision(1)
+                  << legacy_seconds / t << "x), " << (identical ? "identical" : "DIFFERENT") << std::endl;
+    }
+
+    std::cout << "  Scheme statistics on " << width << "x" << width << ":" << std::endl;
+    std::vector<double> w(static_cast<size_t>(width) * width);
+    WeightInitializer rng(7);
+    const WeightInit schemes[] = {WeightInit(InitScheme::Uniform, -0.5, 1.5), WeightInit(InitScheme::Normal, 0.25, 2.0),
+                                  WeightInit(InitScheme::XavierUniform), WeightInit(InitScheme::XavierNormal),
+                                  WeightInit(InitScheme::HeUniform), WeightInit(InitScheme::HeNormal)};
+    for (const WeightInit& init : schemes) {
+        rng.fill(w.data(), w.size(), init, width, width, 0);
+        double mean = 0.0;
+        for (double v : w) mean += v;
+        mean /= w.size();
+        double var = 0.0;
+        for (double v : w) var += (v - mean) * (v - mean);
+        double stddev = std::sqrt(var / w.size());
+
+        double expected_mean = 0.0;
+        double expected_stddev = 0.0;
+        switch (init.scheme) {
+        case InitScheme::Uniform: expected_mean = (init.a + init.b) / 2; expected_stddev = (init.b - init.a) / std::sqrt(12.0); break;
+        case InitScheme::Normal: expected_mean = init.a; expected_stddev = init.b; break;
+        case InitScheme::XavierUniform:
+        case InitScheme::XavierNormal: expected_stddev = std::sqrt(2.0 / (2.0 * width)); break;
+        case InitScheme::HeUniform:
+        case InitScheme::HeNormal: expected_stddev = std::sqrt(2.0 / width); break;
+        }
+        std::cout << "    " << std::left << std::setw(18) << init.to_string() << std::right << std::scientific << std::setprecision(3)
+                  << " mean " << std::setw(11) << mean << " (" << std::setw(10) << expected_mean << ")"
+                  << "  stddev " << stddev << " (" << expected_stddev << ")" << std::fixed << std::endl;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+
+#include "Matrix.h"
+#include "MatrixView.h"
+#include "AlignedAllocator.h"
+
+// Effect of Matrix host storage alignment, padded leading dimensions and huge
+// page backing on the CPU GEMM and elementwise kernels.
+
+namespace {
+
+double median_ms(int reps, const std::function<void()>& fn) {
+    std::vector<double> times;
+    fn();
+    for (int i = 0; i < reps; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        times.push_back(elapsed.count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+void fill(double* data, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        data[i] = static_cast<double>(rand()) / RAND_MAX - 0.5;
+    }
+}
+
+void print_row(const std::string& name, double ms) {
+    std::cout << "  " << std::left << std::setw(52) << name << std::right << std::fixed
+              << std::setprecision(3) << std::setw(10) << ms << " ms" << std::endl;
+}
+
+// Copies a packed rows x cols matrix into buffer with the given leading dimension,
+// starting offset_doubles past a 64-byte boundary.
+MatrixView place(std::vector<double, AlignedAllocator<double> >& buffer, const Matrix& m, int ld, int offset_doubles) {
+    buffer.assign(static_cast<size_t>(m.getRow()) * ld + offset_doubles, 0.0);
+    double* base = buffer.data() + offset_doubles;
+    const double* src = m.get_host_ptr();
+    for (int i = 0; i < m.getRow(); ++i) {
+        std::copy(src + static_cast<size_t>(i) * m.getCol(), src + static_cast<size_t>(i + 1) * m.getCol(),
+                  base + static_cast<size_t>(i) * ld);
+    }
+    return MatrixView(base, m.getRow(), m.getCol(), ld);
+}
+
+void bench_layout(int m, int k, int n, int reps) {
+    Matrix a(m, k), b(k, n);
+    fill(a.get_host_ptr(), static_cast<size_t>(m) * k);
+    fill(b.get_host_ptr(), static_cast<size_t>(k) * n);
+
+    std::cout << "GEMM " << m << "x" << k << " * " << k << "x" << n << " and elementwise " << k << "x" << n << ":" << std::endl;
+
+    struct Layout { std::string name; int offset; bool padded; };
+    Layout layouts[] = {
+        {"64-byte aligned, packed", 0, false},
+        {"64-byte aligned, padded leading dimension", 0, true},
+        {"misaligned by 8 bytes, packed", 1, false},
+    };
+    for (const Layout& layout : layouts) {
+        std::vector<double, AlignedAllocator<double> > a_buf, b_buf, c_buf;
+        int lda = layout.padded ? aligned_memory::paddedLeadingDimension<double>(k) : k;
+        int ldb = layout.padded ? aligned_memory::paddedLeadingDimension<double>(n) : n;
+        MatrixView av = place(a_buf, a, lda, layout.offset);
+        MatrixView bv = place(b_buf, b, ldb, layout.offset);
+        MatrixView cv = place(c_buf, b, ldb, layout.offset);
+
+        print_row("multiply  [" + layout.name + "]", median_ms(reps, [&] { Matrix::multiply(av, bv); }));
+        print_row("add       [" + layout.name + "]", median_ms(reps, [&] { Matrix::add(bv, cv); }));
+        print_row("elemwise* [" + layout.name + "]", median_ms(reps, [&] { Matrix::multiplyElements(bv, cv); }));
+    }
+}
+
+void bench_huge_pages(int rows, int cols, int reps) {
+    std::cout << "Huge page backing, " << rows << "x" << cols << " matrices ("
+              << static_cast<double>(rows) * cols * sizeof(double) / (1024.0 * 1024.0) << " MiB each):" << std::endl;
+
+    struct Policy { std::string name; HugePagePolicy policy; };
+    Policy policies[] = {
+        {"none", HugePagePolicy::None},
+        {"transparent", HugePagePolicy::Transparent},
+        {"explicit", HugePagePolicy::Explicit},
+    };
+    HugePagePolicy previous = aligned_memory::getHugePagePolicy();
+    for (const Policy& p : policies) {
+        aligned_memory::setHugePagePolicy(p.policy);
+        double alloc_ms = median_ms(reps, [&] { Matrix fresh(rows, cols, 1.0); });
+        Matrix x(rows, cols, 0.0), y(rows, cols, 0.0);
+        fill(x.get_host_ptr(), static_cast<size_t>(rows) * cols);
+        fill(y.get_host_ptr(), static_cast<size_t>(rows) * cols);
+
+        print_row("allocate + first touch [" + p.name + "]", alloc_ms);
+        print_row("add                    [" + p.name + "]", median_ms(reps, [&] { x.add(y); }));
+        print_row("transpose              [" + p.name + "]", median_ms(reps, [&] { x.transpose(); }));
+        print_row("multiply by 256 cols   [" + p.name + "]", median_ms(reps, [&] {
+            Matrix::multiply(x.view(), y.view().colRange(0, std::min(256, cols)).rowRange(0, cols));
+        }));
+    }
+    aligned_memory::setHugePagePolicy(previous);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int reps = (argc > 1) ? std::atoi(argv[1]) : 5;
+    srand(42);
+
+    bench_layout(100, 784, 256, reps);
+    bench_layout(100, 100, 250, reps);
+    bench_huge_pages(1024, 1024, reps);
+    return 0;
+}
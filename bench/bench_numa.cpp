@@ -0,0 +1,110 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <set>
+#include <chrono>
+#include <cstdlib>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "NumaTopology.h"
+#include "ThreadPool.h"
+#include "NumaParallelTrainer.h"
+
+// Training and inference throughput of NumaParallelTrainer as workers are added,
+// per affinity policy. Compact fills one socket before using the next, so its
+// rows show per-socket scaling; Scatter spreads workers across sockets at once.
+//
+//   bench_numa [samples] [max_threads]
+
+namespace {
+
+std::vector<Matrix> random_inputs(int count, int features) {
+    std::vector<Matrix> inputs;
+    for (int s = 0; s < count; ++s) {
+        Matrix x(features, 1, 0.0);
+        double* data = x.get_host_ptr();
+        for (int i = 0; i < features; ++i) {
+            data[i] = (rand() % 4 == 0) ? static_cast<double>(rand()) / RAND_MAX : 0.0;
+        }
+        inputs.push_back(x);
+    }
+    return inputs;
+}
+
+std::vector<Matrix> random_targets(int count, int classes) {
+    std::vector<Matrix> targets;
+    for (int s = 0; s < count; ++s) {
+        Matrix y(classes, 1, 0.0);
+        y.setEntry(rand() % classes, 0, 1.0);
+        targets.push_back(y);
+    }
+    return targets;
+}
+
+const char* policy_name(AffinityPolicy policy) {
+    switch (policy) {
+        case AffinityPolicy::None: return "none";
+        case AffinityPolicy::Compact: return "compact";
+        default: return "scatter";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int samples = (argc > 1) ? std::atoi(argv[1]) : 4096;
+    const NumaTopology& topology = NumaTopology::system();
+    int max_threads = (argc > 2) ? std::atoi(argv[2]) : topology.cpu_count();
+
+    std::cout << topology.describe() << std::endl;
+    srand(42);
+    std::vector<Matrix> inputs = random_inputs(samples, 784);
+    std::vector<Matrix> targets = random_targets(samples, 10);
+    Network net({784, 256, 10}, {"relu", "sigmoid"});
+
+    std::vector<int> thread_counts;
+    for (int t = 1; t < max_threads; t *= 2) thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    std::cout << "784-256-10, " << samples << " samples, 32 samples per worker per step:" << std::endl;
+    std::cout << "  " << std::left << std::setw(10) << "policy" << std::right << std::setw(8) << "threads"
+              << std::setw(8) << "nodes" << std::setw(16) << "train smp/s" << std::setw(10) << "speedup"
+              << std::setw(16) << "infer smp/s" << std::setw(10) << "speedup" << std::endl;
+
+    AffinityPolicy policies[] = {AffinityPolicy::None, AffinityPolicy::Compact, AffinityPolicy::Scatter};
+    for (AffinityPolicy policy : policies) {
+        double base_train = 0.0;
+        double base_infer = 0.0;
+        for (int threads : thread_counts) {
+            ThreadPool pool(threads, policy, topology);
+            NumaParallelTrainer trainer(net, pool, inputs, targets);
+
+            std::set<int> nodes;
+            for (int w = 0; w < threads; ++w) nodes.insert(pool.node_of(w));
+
+            auto start = std::chrono::steady_clock::now();
+            trainer.train_epoch(32, 0.01);
+            std::chrono::duration<double> train_elapsed = std::chrono::steady_clock::now() - start;
+
+            start = std::chrono::steady_clock::now();
+            trainer.infer(inputs);
+            std::chrono::duration<double> infer_elapsed = std::chrono::steady_clock::now() - start;
+
+            double train_rate = samples / train_elapsed.count();
+            double infer_rate = samples / infer_elapsed.count();
+            if (threads == 1) {
+                base_train = train_rate;
+                base_infer = infer_rate;
+            }
+            std::cout << "  " << std::left << std::setw(10) << policy_name(policy) << std::right << std::setw(8) << threads
+                      << std::setw(8) << (policy == AffinityPolicy::None ? std::string("-") : std::to_string(nodes.size()))
+                      << std::fixed << std::setprecision(0) << std::setw(16) << train_rate
+                      << std::setprecision(2) << std::setw(9) << train_rate / base_train << "x"
+                      << std::setprecision(0) << std::setw(16) << infer_rate
+                      << std::setprecision(2) << std::setw(9) << infer_rate / base_infer << "x" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "ThreadPool.h"
+#include "PipelineParallelTrainer.h"
+
+// Training throughput of a deep, wide MLP split into pipeline stages (one per
+// thread) for GPipe and 1F1B schedules at several microbatch sizes, against
+// the same microbatches on a single stage. Reports the measured bubble next to
+// the ideal (S - 1) / (M + S - 1) and the largest parameter difference from the
+// single-threaded run after the same batches.
+//
+//   bench_pipeline [stages] [batches] [batch_size]
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double max_difference(const Network& a, const Network& b) {
+    double diff = 0.0;
+    for (size_t l = 0; l < a.getLayers().size(); ++l) {
+        const Matrix* pairs[2][2] = {{&a.getLayers()[l].weights, &b.getLayers()[l].weights},
+                                     {&a.getLayers()[l].biases, &b.getLayers()[l].biases}};
+        for (int p = 0; p < 2; ++p) {
+            const double* x = pairs[p][0]->get_host_ptr();
+            const double* y = pairs[p][1]->get_host_ptr();
+            size_t n = static_cast<size_t>(pairs[p][0]->getRow()) * pairs[p][0]->getCol();
+            for (size_t i = 0; i < n; ++i) {
+                diff = std::max(diff, std::fabs(x[i] - y[i]));
+            }
+        }
+    }
+    return diff;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int stages = (argc > 1) ? std::atoi(argv[1]) : 4;
+    int batches = (argc > 2) ? std::atoi(argv[2]) : 8;
+    int batch_size = (argc > 3) ? std::atoi(argv[3]) : 64;
+
+    std::vector<int> sizes = {256, 512, 512, 512, 512, 10};
+    std::vector<std::string> acts = {"relu", "relu", "relu", "relu", "sigmoid"};
+    srand(11);
+    Network net(sizes, acts);
+
+    std::vector<std::vector<Matrix> > inputs(static_cast<size_t>(batches));
+    std::vector<std::vector<Matrix> > targets(static_cast<size_t>(batches));
+    for (int b = 0; b < batches; ++b) {
+        for (int s = 0; s < batch_size; ++s) {
+            Matrix x(sizes.front(), 1, 0.0);
+            for (int i = 0; i < sizes.front(); ++i) x.setEntry(i, 0, static_cast<double>(rand()) / RAND_MAX);
+            Matrix y(sizes.back(), 1, 0.0);
+            y.setEntry(rand() % sizes.back(), 0, 1.0);
+            inputs[static_cast<size_t>(b)].push_back(x);
+            targets[static_cast<size_t>(b)].push_back(y);
+        }
+    }
+
+    Network reference = net;
+    Clock::time_point start = Clock::now();
+    for (int b = 0; b < batches; ++b) {
+        reference.train_on_batch(inputs[static_cast<size_t>(b)], targets[static_cast<size_t>(b)], 0.05);
+    }
+    double baseline = static_cast<double>(batches) * batch_size / std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << "256-512x4-10, " << batches << " batches of " << batch_size << ", " << stages << " stages" << std::endl;
+    std::cout << "  Network::train_on_batch (per sample): " << std::fixed << std::setprecision(0) << baseline << " samples/s" << std::endl;
+    std::cout << "  Speedups are against the same microbatches run as a single stage." << std::endl;
+    std::cout << "  " << std::left << std::setw(8) << "schedule" << std::right << std::setw(12) << "microbatch"
+              << std::setw(14) << "samples/s" << std::setw(10) << "speedup" << std::setw(10) << "bubble"
+              << std::setw(10) << "ideal" << std::setw(14) << "max |diff|" << std::endl;
+
+    ThreadPool single(1);
+    ThreadPool pool(stages, AffinityPolicy::Compact);
+    for (int microbatch : {batch_size, 16, 8, 4}) {
+        double single_rate = 0.0;
+        for (int variant = 0; variant < 3; ++variant) {
+            PipelineSchedule schedule = (variant == 1) ? PipelineSchedule::GPipe : PipelineSchedule::OneFOneB;
+            PipelineParallelTrainer trainer(net, variant == 0 ? single : pool);
+            start = Clock::now();
+            for (int b = 0; b < batches; ++b) {
+                trainer.train_batch(inputs[static_cast<size_t>(b)], targets[static_cast<size_t>(b)], microbatch, 0.05, schedule);
+            }
+            double rate = static_cast<double>(batches) * batch_size / std::chrono::duration<double>(Clock::now() - start).count();
+            if (variant == 0) single_rate = rate;
+            Network trained = net;
+            trainer.copy_parameters_to(trained);
+            const char* name = (variant == 0) ? "1 stage" : (variant == 1 ? "gpipe" : "1f1b");
+            std::cout << "  " << std::left << std::setw(8) << name
+                      << std::right << std::setw(12) << microbatch << std::fixed << std::setprecision(0) << std::setw(14) << rate
+                      << std::setprecision(2) << std::setw(9) << rate / single_rate << "x"
+                      << std::setprecision(1) << std::setw(9) << 100.0 * trainer.stats().bubble_fraction() << "%"
+                      << std::setw(9) << 100.0 * trainer.stats().ideal_bubble_fraction() << "%"
+                      << std::scientific << std::setprecision(2) << std::setw(14) << max_difference(reference, trained) << std::endl;
+        }
+    }
+    return 0;
+}
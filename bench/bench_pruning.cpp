@@ -0,0 +1,95 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstdlib>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "Pruner.h"
+#include "PrunedNetwork.h"
+
+// Inference latency and weight memory of magnitude-pruned networks stored as
+// dense Layers versus CSR SparseLayers.
+
+namespace {
+
+double median_ms(int reps, const std::function<void()>& fn) {
+    std::vector<double> times;
+    fn();
+    for (int i = 0; i < reps; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        times.push_back(elapsed.count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+Matrix random_input(int rows, int cols) {
+    Matrix m(rows, cols, 0.0);
+    double* data = m.get_host_ptr();
+    for (size_t i = 0; i < static_cast<size_t>(rows) * cols; ++i) {
+        data[i] = static_cast<double>(rand()) / RAND_MAX;
+    }
+    return m;
+}
+
+double max_abs_diff(const Matrix& a, const Matrix& b) {
+    double diff = 0.0;
+    const double* pa = a.get_host_ptr();
+    const double* pb = b.get_host_ptr();
+    for (size_t i = 0; i < static_cast<size_t>(a.getRow()) * a.getCol(); ++i) {
+        diff = std::max(diff, std::fabs(pa[i] - pb[i]));
+    }
+    return diff;
+}
+
+void bench_network(const std::vector<int>& sizes, const std::vector<std::string>& activations, int reps) {
+    srand(7);
+    Network base(sizes, activations);
+    Matrix single = random_input(sizes[0], 1);
+    Matrix batch = random_input(sizes[0], 64);
+
+    std::cout << "Network";
+    for (int s : sizes) std::cout << " " << s;
+    std::cout << ", dense weights " << PrunedNetwork::dense_storage_bytes(base) / 1024 << " KiB:" << std::endl;
+    std::cout << "  " << std::left << std::setw(10) << "sparsity" << std::right
+              << std::setw(12) << "CSR KiB" << std::setw(14) << "dense b=1" << std::setw(14) << "CSR b=1"
+              << std::setw(14) << "dense b=64" << std::setw(14) << "CSR b=64" << std::setw(12) << "max diff" << std::endl;
+
+    double sparsities[] = {0.0, 0.5, 0.8, 0.9, 0.95};
+    for (double sparsity : sparsities) {
+        Network net = base;
+        Pruner pruner(sparsity, PruningScope::Global);
+        pruner.prune(net);
+        PrunedNetwork pruned(net);
+
+        double dense_1 = median_ms(reps, [&] { net.infer(single.view()); });
+        double sparse_1 = median_ms(reps, [&] { pruned.infer(single.view()); });
+        double dense_64 = median_ms(reps, [&] { net.infer(batch.view()); });
+        double sparse_64 = median_ms(reps, [&] { pruned.infer(batch.view()); });
+        double diff = max_abs_diff(net.infer(batch.view()), pruned.infer(batch.view()));
+
+        std::cout << "  " << std::left << std::setw(10) << std::fixed << std::setprecision(2) << Pruner::sparsity(net)
+                  << std::right << std::setw(12) << pruned.storage_bytes() / 1024
+                  << std::setprecision(3) << std::setw(11) << dense_1 << " ms" << std::setw(11) << sparse_1 << " ms"
+                  << std::setw(11) << dense_64 << " ms" << std::setw(11) << sparse_64 << " ms"
+                  << std::scientific << std::setprecision(1) << std::setw(12) << diff << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int reps = (argc > 1) ? std::atoi(argv[1]) : 20;
+
+    bench_network({784, 100, 10}, {"relu", "sigmoid"}, reps);
+    bench_network({784, 1024, 1024, 10}, {"relu", "relu", "sigmoid"}, reps);
+    return 0;
+}
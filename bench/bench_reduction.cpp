@@ -0,0 +1,115 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "ThreadPool.h"
+#include "NumaParallelTrainer.h"
+
+// Cost of NumaParallelTrainer's reproducible tree reduction against the default
+// per-worker reduction, and a check that its parameters are bit-identical for
+// 1, 4 and 16 threads while the default mode drifts with the thread count.
+// Exits with 1 if a tree-mode run is not identical.
+//
+//   bench_reduction [samples] [epochs]
+
+namespace {
+
+const int GLOBAL_BATCH = 64;
+
+// Largest absolute parameter difference; 0 means bit-identical up to signed zeros.
+double max_difference(const ParameterSnapshot& a, const ParameterSnapshot& b) {
+    double diff = 0.0;
+    for (size_t l = 0; l < a.weights.size(); ++l) {
+        const Matrix* pairs[2][2] = {{&a.weights[l], &b.weights[l]}, {&a.biases[l], &b.biases[l]}};
+        for (int p = 0; p < 2; ++p) {
+            const double* x = pairs[p][0]->get_host_ptr();
+            const double* y = pairs[p][1]->get_host_ptr();
+            size_t n = static_cast<size_t>(pairs[p][0]->getRow()) * pairs[p][0]->getCol();
+            for (size_t i = 0; i < n; ++i) {
+                diff = std::max(diff, std::fabs(x[i] - y[i]));
+            }
+        }
+    }
+    return diff;
+}
+
+struct RunResult {
+    double seconds;
+    double loss;
+    ParameterSnapshot parameters;
+};
+
+RunResult run(const Network& net, const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets,
+              int threads, bool deterministic, int leaf_size, int epochs) {
+    ThreadPool pool(threads);
+    NumaParallelTrainer trainer(net, pool, inputs, targets);
+    RunResult result;
+    result.loss = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int e = 0; e < epochs; ++e) {
+        result.loss = deterministic ? trainer.train_epoch_deterministic(GLOBAL_BATCH, 0.05, leaf_size)
+                                    : trainer.train_epoch(std::max(1, GLOBAL_BATCH / threads), 0.05);
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Network trained = net;
+    trainer.copy_parameters_to(trained);
+    trained.snapshot_parameters(result.parameters);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int samples = (argc > 1) ? std::atoi(argv[1]) : 2048;
+    int epochs = (argc > 2) ? std::atoi(argv[2]) : 2;
+
+    srand(7);
+    std::vector<Matrix> inputs;
+    std::vector<Matrix> targets;
+    for (int s = 0; s < samples; ++s) {
+        Matrix x(196, 1, 0.0);
+        for (int i = 0; i < 196; ++i) x.setEntry(i, 0, static_cast<double>(rand()) / RAND_MAX);
+        Matrix y(10, 1, 0.0);
+        y.setEntry(rand() % 10, 0, 1.0);
+        inputs.push_back(x);
+        targets.push_back(y);
+    }
+    Network net({196, 64, 10}, {"relu", "sigmoid"});
+
+    std::cout << "196-64-10, " << samples << " samples, global batch " << GLOBAL_BATCH << ", "
+              << epochs << " epochs" << std::endl;
+    std::cout << "  " << std::left << std::setw(22) << "mode" << std::right << std::setw(8) << "threads"
+              << std::setw(12) << "seconds" << std::setw(12) << "overhead" << std::setw(14) << "final loss"
+              << std::setw(24) << "max |diff| vs 1 thread" << std::endl;
+
+    int thread_counts[] = {1, 4, 16};
+    bool failed = false;
+    for (int leaf_size : {0, 8, 1}) {
+        bool deterministic = leaf_size > 0;
+        std::string mode = deterministic ? "tree, leaf " + std::to_string(leaf_size) : "per-worker (default)";
+        ParameterSnapshot reference;
+        bool identical = true;
+        for (int threads : thread_counts) {
+            RunResult fast = run(net, inputs, targets, threads, false, 0, epochs);
+            RunResult result = deterministic ? run(net, inputs, targets, threads, true, leaf_size, epochs) : fast;
+            if (threads == 1) reference = result.parameters;
+            double diff = max_difference(reference, result.parameters);
+            identical = identical && diff == 0.0;
+            std::cout << "  " << std::left << std::setw(22) << mode << std::right << std::setw(8) << threads
+                      << std::fixed << std::setprecision(3) << std::setw(12) << result.seconds
+                      << std::setw(11) << std::setprecision(1) << 100.0 * (result.seconds / fast.seconds - 1.0) << "%"
+                      << std::setw(14) << std::setprecision(8) << result.loss
+                      << std::scientific << std::setprecision(2) << std::setw(24) << diff << std::endl;
+        }
+        std::cout << "  -> " << (identical ? "bit-identical" : "NOT identical") << " across thread counts" << std::endl;
+        failed = failed || (deterministic && !identical);
+    }
+    return failed ? 1 : 0;
+}
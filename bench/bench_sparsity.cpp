@@ -0,0 +1,158 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "MNISTLoader.h"
+#include "WeightInitializer.h"
+
+// Training and per-sample inference throughput on MNIST with
+// Layer::setActivationSparsity off and on. With it on, the forward pass skips
+// zero inputs (blank pixels, zero ReLU outputs) and the backward pass skips
+// units with a zero d_z and the error of inputs nobody reads. Each topology is
+// first trained for an epoch so the ReLU layers reach a realistic activity,
+// then both settings train the same copy of it on the same batches; the
+// resulting parameters and the inference outputs must match bit for bit, or the
+// program exits with 1.
+//
+//   bench_sparsity [data dir] [training samples]
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void train(Network& net, const MNISTDataset& data, size_t samples, int batch_size) {
+    for (size_t i = 0; i < samples; i += static_cast<size_t>(batch_size)) {
+        size_t end = std::min(samples, i + static_cast<size_t>(batch_size));
+        std::vector<Matrix> inputs(data.images.begin() + static_cast<long>(i), data.images.begin() + static_cast<long>(end));
+        std::vector<Matrix> targets(data.labels.begin() + static_cast<long>(i), data.labels.begin() + static_cast<long>(end));
+        net.train_on_batch(inputs, targets, 0.01);
+    }
+}
+
+bool same(const Matrix& x, const Matrix& y) {
+    size_t n = static_cast<size_t>(x.getRow()) * x.getCol();
+    return x.getRow() == y.getRow() && x.getCol() == y.getCol() &&
+           std::memcmp(x.get_host_ptr(), y.get_host_ptr(), n * sizeof(double)) == 0;
+}
+
+bool same_parameters(const Network& a, const Network& b) {
+    for (size_t l = 0; l < a.getLayers().size(); ++l) {
+        if (!same(a.getLayers()[l].weights, b.getLayers()[l].weights) ||
+            !same(a.getLayers()[l].biases, b.getLayers()[l].biases)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Fraction of non-zero outputs of each hidden layer over the samples.
+std::vector<double> hidden_activity(const Network& net, const MNISTDataset& data, size_t samples) {
+    const std::vector<Layer>& layers = net.getLayers();
+    std::vector<double> active(layers.size() - 1, 0.0);
+    for (size_t s = 0; s < samples; ++s) {
+        Matrix x = data.images[s];
+        for (size_t l = 0; l + 1 < layers.size(); ++l) {
+            x = layers[l].infer(x.view());
+            const double* v = x.get_host_ptr();
+            for (int i = 0; i < x.getRow(); ++i) active[l] += v[i] != 0.0 ? 1.0 : 0.0;
+        }
+    }
+    for (size_t l = 0; l + 1 < layers.size(); ++l) active[l] /= static_cast<double>(samples) * layers[l].weights.getRow();
+    return active;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string dir = (argc > 1) ? std::string(argv[1]) + "/" : std::string();
+    int max_samples = (argc > 2) ? std::atoi(argv[2]) : 5000;
+    MNISTDataset data = MNISTLoader::load(dir + "train-images-idx3-ubyte", dir + "train-labels-idx1-ubyte", max_samples);
+    size_t samples = data.images.size();
+    size_t infer_samples = std::min<size_t>(samples, 1000);
+    int batch_size = 32;
+
+    double pixels = 0.0;
+    for (size_t s = 0; s < samples; ++s) {
+        const double* v = data.images[s].get_host_ptr();
+        for (int i = 0; i < data.images[s].getRow(); ++i) pixels += v[i] != 0.0 ? 1.0 : 0.0;
+    }
+    std::cout << samples << " samples, " << std::fixed << std::setprecision(1)
+              << 100.0 * pixels / (static_cast<double>(samples) * data.images[0].getRow()) << "% non-zero pixels" << std::endl;
+    std::cout << "  " << std::left << std::setw(20) << "topology" << std::right << std::setw(18) << "hidden active %"
+              << std::setw(14) << "train/s off" << std::setw(13) << "train/s on" << std::setw(9) << "speedup"
+              << std::setw(14) << "infer/s off" << std::setw(13) << "infer/s on" << std::setw(9) << "speedup"
+              << "  results" << std::endl;
+
+    bool all_identical = true;
+    std::vector<std::vector<int> > topologies = {{784, 100, 10}, {784, 256, 128, 10}, {784, 512, 512, 10}};
+    for (const std::vector<int>& sizes : topologies) {
+        std::vector<std::string> acts(sizes.size() - 1, "relu");
+        acts.back() = "sigmoid";
+        Network warm(sizes, acts, WeightInit(InitScheme::HeUniform), 7);
+        Layer::setActivationSparsity(true);
+        train(warm, data, samples, batch_size);
+        std::vector<double> activity = hidden_activity(warm, data, infer_samples);
+
+        double train_seconds[2] = {1e30, 1e30};
+        double infer_seconds[2] = {1e30, 1e30};
+        Network trained[2] = {warm, warm};
+        std::vector<Matrix> outputs[2];
+        for (int round = 0; round < 3; ++round) {
+            for (int on = 0; on < 2; ++on) {
+                Layer::setActivationSparsity(on == 1);
+                Network net = warm;
+                Clock::time_point start = Clock::now();
+                train(net, data, samples, batch_size);
+                train_seconds[on] = std::min(train_seconds[on], seconds_since(start));
+                trained[on] = net;
+
+                start = Clock::now();
+                std::vector<Matrix> round_outputs;
+                round_outputs.reserve(infer_samples);
+                for (size_t s = 0; s < infer_samples; ++s) {
+                    round_outputs.push_back(warm.infer(data.images[s].view()));
+                }
+                infer_seconds[on] = std::min(infer_seconds[on], seconds_since(start));
+                outputs[on].swap(round_outputs);
+            }
+        }
+        Layer::setActivationSparsity(true);
+        bool identical = same_parameters(trained[0], trained[1]);
+        for (size_t s = 0; s < infer_samples && identical; ++s) {
+            identical = same(outputs[0][s], outputs[1][s]);
+        }
+        all_identical = all_identical && identical;
+
+        std::string name;
+        for (size_t i = 0; i < sizes.size(); ++i) name += (i ? "-" : "") + std::to_string(sizes[i]);
+        std::string active;
+        for (size_t l = 0; l < activity.size(); ++l) {
+            std::ostringstream pct;
+            pct << std::fixed << std::setprecision(0) << activity[l] * 100.0;
+            active += (l ? "/" : "") + pct.str();
+        }
+        std::cout << "  " << std::left << std::setw(20) << name << std::right << std::setw(18) << active
+                  << std::setprecision(0) << std::setw(14) << samples / train_seconds[0] << std::setw(13) << samples / train_seconds[1]
+                  << std::setprecision(2) << std::setw(8) << train_seconds[0] / train_seconds[1] << "x"
+                  << std::setprecision(0) << std::setw(14) << infer_samples / infer_seconds[0] << std::setw(13) << infer_samples / infer_seconds[1]
+                  << std::setprecision(2) << std::setw(8) << infer_seconds[0] / infer_seconds[1] << "x"
+                  << "  " << (identical ? "identical" : "DIFFERENT") << std::endl;
+    }
+    if (!all_identical) {
+        std::cout << "Activation sparsity changed the results." << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef ACTIVATIONS_H
+#define ACTIVATIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+enum class ActivationKind { ReLU, Sigmoid, Tanh, GELU, Linear };
+
+enum class ActivationPrecision {
+    Exact,   // std::exp, std::erf; matches Layer::sigmoid bit for bit
+    Fast     // the polynomial/rational approximations below
+};
+
+// Array kernels for the elementwise activations, used by Layer, SpatialLayer and
+// SparseLayer. The loops are branch-free over plain arrays so the compiler can
+// vectorize them; Fast precision replaces std::exp with fast_exp.
+namespace activations {
+
+void setPrecision(ActivationPrecision precision);
+ActivationPrecision getPrecision();
+
+// "relu", "sigmoid", "tanh", "gelu" or "linear"; throws std::invalid_argument otherwise.
+ActivationKind parse(const std::string& name);
+const char* name(ActivationKind kind);
+
+// True when f'(z) can be computed from f(z) alone (all but GELU), so layers can
+// keep the forward output instead of the pre-activation for the backward pass.
+bool derivative_from_output(ActivationKind kind);
+// True when the backward pass ignores the incoming gradient wherever f(z) == 0
+// (ReLU), so the layer after it need not compute the error of its zero inputs.
+bool zero_output_blocks_gradient(ActivationKind kind);
+
+// out[i] = f(z[i]); out may alias z.
+void apply(ActivationKind kind, const double* z, double* out, size_t n);
+// out[i] = f'(z[i]).
+void derivative(ActivationKind kind, const double* z, double* out, size_t n);
+// d_z[i] = grad[i] * f'(z[i]), from the pre-activation.
+void gradient_from_input(ActivationKind kind, const double* z, const double* grad, double* d_z, size_t n);
+// d_z[i] = grad[i] * f'(z[i]), from a[i] = f(z[i]); requires derivative_from_output(kind).
+void gradient_from_output(ActivationKind kind, const double* a, const double* grad, double* d_z, size_t n);
+
+// exp(x) by Cody-Waite reduction x = k*ln2 + r, |r| <= ln2/2, a degree-7 Taylor
+// polynomial for exp(r) and 2^k assembled in the exponent bits. Max relative
+// error 7.1e-9. x must lie in [-708, 709]; fast_exp clamps, callers that bound
+// their argument themselves use this directly so the compiler does not
+// specialize the loop on clamp bounds they never reach.
+inline double fast_exp_in_range(double x) {
+    const double LOG2E = 1.4426950408889634;
+    const double LN2_HI = 6.93147180369123816490e-01;
+    const double LN2_LO = 1.90821492927058770002e-10;
+    const double SHIFTER = 6755399441055744.0;   // 1.5 * 2^52: adding it rounds to an integer
+    double kd = x * LOG2E + SHIFTER;
+    double k = kd - SHIFTER;
+    double r = (x - k * LN2_HI) - k * LN2_LO;
+    double p = 1.0 + r * (1.0 + r * (1.0 / 2 + r * (1.0 / 6 + r * (1.0 / 24 + r * (1.0 / 120 +
+               r * (1.0 / 720 + r * (1.0 / 5040)))))));
+    uint64_t bits;
+    std::memcpy(&bits, &kd, sizeof(bits));   // low mantissa bits of kd hold k
+    bits = (bits + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+inline double fast_exp(double x) {
+    x = x < -708.0 ? -708.0 : x;   // two plain selects so the loop stays branch-free
+    x = x > 709.0 ? 709.0 : x;
+    return fast_exp_in_range(x);
+}
+
+// Max absolute error 1.8e-9. Arguments are clamped to [-40, 40], where the
+// result is within 4.3e-18 of 0 or 1. The narrow clamp also keeps GELU, which
+// multiplies x by this, from producing subnormals in clamped vector lanes.
+inline double fast_sigmoid(double x) {
+    x = x < -40.0 ? -40.0 : x;
+    x = x > 40.0 ? 40.0 : x;
+    return 1.0 / (1.0 + fast_exp_in_range(-x));
+}
+
+// tanh(x) = 2 * sigmoid(2x) - 1. Max absolute error 3.5e-9 (relative error grows near 0).
+inline double fast_tanh(double x) { return 2.0 * fast_sigmoid(2.0 * x) - 1.0; }
+
+// The tanh form of GELU, 0.5x(1 + tanh(sqrt(2/pi)(x + 0.044715x^3))), written as
+// x * sigmoid(2u). Max absolute error 4.7e-4 against the erf definition.
+inline double fast_gelu(double x) {
+    const double TWO_SQRT_2_OVER_PI = 1.5957691216057308;
+    return x * fast_sigmoid(TWO_SQRT_2_OVER_PI * (x + 0.044715 * x * x * x));
+}
+
+} // namespace activations
+
+#endif
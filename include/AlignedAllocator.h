@@ -0,0 +1,75 @@
+#ifndef ALIGNEDALLOCATOR_H
+#define ALIGNEDALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <limits>
+
+enum class HugePagePolicy {
+    None,          // 64-byte aligned heap memory only
+    Transparent,   // large buffers are 2 MiB aligned and madvise(MADV_HUGEPAGE)d
+    Explicit       // large buffers come from MAP_HUGETLB, falling back to Transparent
+};
+
+namespace aligned_memory {
+
+const size_t ALIGNMENT = 64;
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+void* allocate(size_t bytes);
+void deallocate(void* p) noexcept;
+
+void setHugePagePolicy(HugePagePolicy policy);
+HugePagePolicy getHugePagePolicy();
+
+// Number of elements per row so that every row starts on a 64-byte boundary.
+template <typename T>
+int paddedLeadingDimension(int cols) {
+    const int per_line = static_cast<int>(ALIGNMENT / sizeof(T));
+    return per_line > 1 ? ((cols + per_line - 1) / per_line) * per_line : cols;
+}
+
+} // namespace aligned_memory
+
+// Allocator for Matrix host storage: every buffer starts on a 64-byte boundary
+// and buffers of at least HUGE_PAGE_SIZE are backed by huge pages per the
+// current HugePagePolicy.
+template <typename T>
+class AlignedAllocator {
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind { typedef AlignedAllocator<U> other; };
+
+    AlignedAllocator() noexcept {}
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(aligned_memory::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        aligned_memory::deallocate(p);
+    }
+
+    size_t max_size() const noexcept { return std::numeric_limits<size_t>::max() / sizeof(T); }
+};
+
+template <typename T, typename U>
+bool operator==(const AlignedAllocator<T>&, const AlignedAllocator<U>&) noexcept { return true; }
+
+template <typename T, typename U>
+bool operator!=(const AlignedAllocator<T>&, const AlignedAllocator<U>&) noexcept { return false; }
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef BACKGROUNDEVALUATOR_H
+#define BACKGROUNDEVALUATOR_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "Network.h"
+
+struct EvaluationResult {
+    int epoch;
+    long long step;
+    long long samples;
+    long long correct;
+    double loss;                        // mean of Network::meanSquaredError
+    int classes;
+    std::vector<long long> confusion;   // row = actual class, column = predicted
+    double seconds;                     // submit until the result was ready
+
+    EvaluationResult() : epoch(0), step(0), samples(0), correct(0), loss(0.0), classes(0), seconds(0.0) {}
+    double accuracy() const { return samples ? static_cast<double>(correct) / samples : 0.0; }
+    long long confusion_at(int actual, int predicted) const {
+        return confusion[static_cast<size_t>(actual) * classes + predicted];
+    }
+    std::string confusion_to_string() const;
+};
+
+// Evaluates a test set on parameter snapshots while training goes on. submit()
+// only copies the parameters on the calling thread; worker threads rebuild a
+// replica from the copy and share its test set in chunks, so one evaluation
+// uses all of them. Snapshots finish in submission order. Classes are the
+// argmax of the target and of the prediction. The test set is referenced, not
+// copied, and must outlive the evaluator.
+class BackgroundEvaluator {
+public:
+    // Results go to on_result, called on a worker thread, if it is set and
+    // are otherwise kept for take_completed(). on_result must not call wait().
+    typedef std::function<void(const EvaluationResult&)> Callback;
+
+    // At most max_pending snapshots wait or run at a time; submit() blocks
+    // beyond that rather than letting memory grow.
+    BackgroundEvaluator(const Network& model, const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets,
+                        int threads = 2, int max_pending = 2, const Callback& on_result = Callback());
+    ~BackgroundEvaluator();
+
+    BackgroundEvaluator(const BackgroundEvaluator&) = delete;
+    BackgroundEvaluator& operator=(const BackgroundEvaluator&) = delete;
+
+    void submit(const Network& net, int epoch, long long step);
+    // Results finished since the last call, oldest first.
+    std::vector<EvaluationResult> take_completed();
+    // Blocks until every submitted snapshot has been evaluated. Rethrows the
+    // first evaluation error.
+    void wait();
+
+    // Single-threaded evaluation of the same metrics.
+    static EvaluationResult evaluate(const Network& net, const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets);
+
+private:
+    struct Job;
+
+    void worker_loop();
+    void publish_finished();
+    void deliver();
+    static void evaluate_range(const Network& net, const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets,
+                               size_t begin, size_t end, double& loss, long long& correct, std::vector<long long>& confusion);
+
+    Network model;
+    const std::vector<Matrix>& inputs;
+    const std::vector<Matrix>& targets;
+    int max_pending;
+    Callback on_result;
+    int classes;
+    size_t chunk_size;
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    std::deque<std::shared_ptr<Job> > jobs;
+    std::deque<EvaluationResult> undelivered;
+    std::vector<EvaluationResult> completed;
+    bool stop_requested;
+    std::string error;
+    std::mutex callback_mutex;
+    std::vector<std::thread> workers;
+};
+
+#endif
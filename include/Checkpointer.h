@@ -0,0 +1,66 @@
+#ifndef CHECKPOINTER_H
+#define CHECKPOINTER_H
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "Network.h"
+
+struct TrainingState {
+    long long step;
+    int epoch;
+    long long next_sample;
+    double learning_rate;
+    std::string rng_state;
+
+    TrainingState() : step(0), epoch(0), next_sample(0), learning_rate(0.0) {}
+};
+
+// Periodic checkpointing that keeps disk I/O off the training thread. The
+// trainer only copies parameters into a staging snapshot; a background writer
+// serializes it to "<path>.tmp", fsyncs and renames it over <path>.
+class Checkpointer {
+public:
+    Checkpointer(const std::string& path, long long every_n_batches, double every_seconds = 0.0);
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    bool maybe_checkpoint(const Network& net, const TrainingState& state);
+    void checkpoint(const Network& net, const TrainingState& state);
+    void flush();
+
+    long long checkpoints_written() const;
+    std::string last_error() const;
+
+    static void save(const std::string& path, const ParameterSnapshot& params, const TrainingState& state);
+    static bool load(const std::string& path, Network& net, TrainingState& state);
+
+private:
+    void writer_loop();
+
+    std::string path;
+    long long every_n_batches;
+    double every_seconds;
+    long long batches_since_checkpoint;
+    std::chrono::steady_clock::time_point last_checkpoint_time;
+
+    ParameterSnapshot pending_params;
+    TrainingState pending_state;
+    ParameterSnapshot writing_params;
+    TrainingState writing_state;
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    bool has_pending;
+    bool writing;
+    bool stop_requested;
+    long long written_count;
+    std::string error_message;
+    std::thread writer;
+};
+
+#endif
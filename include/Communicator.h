@@ -0,0 +1,78 @@
+#ifndef COMMUNICATOR_H
+#define COMMUNICATOR_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Ring transport between the worker processes of a data-parallel job. Each
+// rank only ever sends to rank + 1 and receives from rank - 1 (mod size);
+// allreduce_sum is built on that single primitive.
+class Communicator {
+public:
+    Communicator(int rank, int size);
+    virtual ~Communicator() {}
+
+    int rank() const { return rank_val; }
+    int size() const { return size_val; }
+    int next_rank() const { return (rank_val + 1) % size_val; }
+    int prev_rank() const { return (rank_val + size_val - 1) % size_val; }
+
+    // Sends send_count doubles to the next rank while receiving recv_count
+    // doubles from the previous rank.
+    virtual void exchange(const double* send, size_t send_count, double* recv, size_t recv_count) = 0;
+    virtual void barrier();
+
+    // Ring allreduce (reduce-scatter followed by allgather).
+    void allreduce_sum(double* data, size_t count);
+
+protected:
+    int rank_val;
+    int size_val;
+
+private:
+    std::vector<double> scratch;
+};
+
+// Ring over TCP. endpoints[r] is "host:port" where rank r listens; loopback
+// endpoints work for single-host runs and tests.
+class TcpCommunicator : public Communicator {
+public:
+    TcpCommunicator(int rank, const std::vector<std::string>& endpoints, double connect_timeout_seconds = 30.0);
+    ~TcpCommunicator();
+
+    static std::vector<std::string> local_endpoints(int size, int base_port);
+
+    void exchange(const double* send, size_t send_count, double* recv, size_t recv_count);
+
+private:
+    int send_fd;
+    int recv_fd;
+};
+
+// Ring over a POSIX shared memory segment for ranks on the same host. Rank 0
+// creates the segment; every rank owns one slot of slot_capacity doubles.
+class ShmCommunicator : public Communicator {
+public:
+    ShmCommunicator(int rank, int size, const std::string& name, size_t slot_capacity = 1 << 20,
+                    double connect_timeout_seconds = 30.0);
+    ~ShmCommunicator();
+
+    void exchange(const double* send, size_t send_count, double* recv, size_t recv_count);
+    void barrier();
+
+private:
+    struct Header;
+
+    double* slot(int r) const;
+
+    std::string name;
+    size_t slot_capacity;
+    size_t mapped_bytes;
+    void* mapping;
+    Header* header;
+    int local_sense;
+    int round_parity;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef DATAPARALLELTRAINER_H
+#define DATAPARALLELTRAINER_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Network.h"
+#include "Communicator.h"
+
+// Synchronous data-parallel SGD. Every rank holds a replica of the network and
+// is handed the same global batch; it trains on its contiguous shard and the
+// summed gradients are allreduced before the update, so all replicas stay
+// identical. Gradients of a layer are reduced on a communication thread as soon
+// as its backward pass finishes, overlapping with the backward of the layers
+// below it.
+class DataParallelTrainer {
+public:
+    DataParallelTrainer(Network& net, Communicator& comm, bool overlap_communication = true);
+    ~DataParallelTrainer();
+
+    DataParallelTrainer(const DataParallelTrainer&) = delete;
+    DataParallelTrainer& operator=(const DataParallelTrainer&) = delete;
+
+    // Copies rank 0's parameters to every rank.
+    void broadcast_parameters();
+
+    // Both return the mean loss over the global batch.
+    double train_on_batch(const std::vector<Matrix>& batch_inputs,
+                          const std::vector<Matrix>& batch_targets,
+                          double learning_rate);
+    double train_on_sparse_batch(const SparseMatrix& batch_inputs,
+                                 const std::vector<Matrix>& batch_targets,
+                                 double learning_rate);
+
+    static void shard_range(size_t total, int rank, int size, size_t& begin, size_t& end);
+
+private:
+    void reduce_layer(size_t layer_index);
+    void submit_layer(size_t layer_index);
+    double finish_step(double local_loss, size_t global_batch_size, double learning_rate);
+    void comm_loop();
+
+    Network& net;
+    Communicator& comm;
+    bool overlap;
+    std::vector<bool> layer_submitted;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<size_t> queue;
+    size_t in_flight;
+    bool stop_requested;
+    std::string error_message;
+    std::thread comm_thread;
+};
+
+#endif
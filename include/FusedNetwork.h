@@ -0,0 +1,48 @@
+#ifndef FUSEDNETWORK_H
+#define FUSEDNETWORK_H
+
+#include <vector>
+#include "Matrix.h"
+#include "MatrixView.h"
+#include "AlignedAllocator.h"
+#include "Activations.h"
+#include "Network.h"
+
+// Inference-only copy of a dense Network that runs a tile of tile_size samples
+// through all layers back to back. The tile's activations live in two small
+// ping-pong buffers that stay in L1/L2, instead of a fresh Matrix per layer for
+// the whole batch, and the weights are packed once into aligned row-major
+// arrays. Every output is summed in the same order as Layer::infer, so results
+// match Network::infer exactly. infer() is const and thread-safe.
+class FusedNetwork {
+public:
+    // tile_size 0 picks the largest multiple of 4 (at most 64) for which the
+    // two activation buffers of the widest adjacent layer pair fit in 128 KiB.
+    explicit FusedNetwork(const Network& net, int tile_size = 0);
+
+    // input is features x samples, like Network::infer; returns outputs x samples.
+    Matrix infer(const MatrixView& input) const;
+
+    int tile_size() const { return tile; }
+    int input_size() const { return layers.front().inputs; }
+    int output_size() const { return layers.back().outputs; }
+
+    static int default_tile_size(const Network& net);
+
+private:
+    struct FusedLayer {
+        int inputs;
+        int outputs;
+        ActivationKind activation;
+        std::vector<double, AlignedAllocator<double> > weights;   // outputs x inputs
+        std::vector<double, AlignedAllocator<double> > biases;
+    };
+
+    static void run_layer(const FusedLayer& layer, const double* x, double* z, int columns, int stride);
+
+    std::vector<FusedLayer> layers;
+    int tile;
+    int max_width;
+};
+
+#endif
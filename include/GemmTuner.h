@@ -0,0 +1,74 @@
+#ifndef GEMMTUNER_H
+#define GEMMTUNER_H
+
+#include <string>
+#include <vector>
+#include "Matrix.h"
+#include "Network.h"
+
+struct GemmShape {
+    int m;
+    int k;
+    int n;
+
+    GemmShape(int m = 0, int k = 0, int n = 0) : m(m), k(k), n(n) {}
+    bool operator<(const GemmShape& other) const {
+        if (m != other.m) return m < other.m;
+        if (k != other.k) return k < other.k;
+        return n < other.n;
+    }
+    bool operator==(const GemmShape& other) const { return m == other.m && k == other.k && n == other.n; }
+};
+
+struct GemmTuningResult {
+    GemmShape shape;
+    GemmBlocking blocking;
+    double speedup;     // default blocking time / tuned time when it was measured
+    bool from_cache;
+};
+
+// Picks Matrix::multiply cache blocking per shape by timing candidate
+// blockings on this host. Winners are kept in a text cache file keyed by CPU
+// model and shape, so later runs only install them; entries for other CPU
+// models in the same file are preserved.
+class GemmTuner {
+public:
+    explicit GemmTuner(const std::string& cache_path, double seconds_per_candidate = 0.01);
+
+    // Installs the cached blocking of every shape for this CPU and benchmarks
+    // the ones not cached, appending them to the cache file.
+    std::vector<GemmTuningResult> tune(const std::vector<GemmShape>& shapes);
+    // Installs every cached blocking for this CPU without benchmarking.
+    int load();
+
+    // Times each candidate on a random m x k by k x n product and returns the
+    // fastest, or the default unless something beats it by more than 2%.
+    GemmBlocking benchmark(const GemmShape& shape, double* speedup = nullptr) const;
+
+    // GEMM shapes of the dense layers' forward and backward passes at the given
+    // batch sizes. Shapes with n == 1 are left out since the blocked kernel does
+    // not run for them.
+    static std::vector<GemmShape> network_shapes(const Network& net, const std::vector<int>& batch_sizes);
+    static std::vector<GemmBlocking> candidates(const GemmShape& shape);
+    static std::string cpu_model();
+
+    const std::string& cpu() const { return cpu_name; }
+
+private:
+    struct CacheEntry {
+        std::string cpu;
+        GemmShape shape;
+        GemmBlocking blocking;
+        double speedup;
+    };
+
+    void read_cache();
+    void write_cache() const;
+
+    std::string cache_path;
+    double seconds_per_candidate;
+    std::string cpu_name;
+    std::vector<CacheEntry> entries;
+};
+
+#endif
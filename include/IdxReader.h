@@ -0,0 +1,81 @@
+#ifndef IDXREADER_H
+#define IDXREADER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+
+enum class IdxType : unsigned char {
+    UInt8 = 0x08,
+    Int8 = 0x09,
+    Int16 = 0x0B,
+    Int32 = 0x0C,
+    Float32 = 0x0D,
+    Float64 = 0x0E
+};
+
+// Sequential reader for IDX files of any element type and rank, plain or
+// gzip-compressed (detected from the content, not the name). A background
+// thread reads and inflates the file in chunk_bytes pieces into a ring of
+// chunks_in_flight buffers, so decompression overlaps with the caller parsing
+// the elements it has already received.
+class IdxReader {
+public:
+    explicit IdxReader(const std::string& path, size_t chunk_bytes = 1 << 20, int chunks_in_flight = 4);
+    ~IdxReader();
+
+    IdxReader(const IdxReader&) = delete;
+    IdxReader& operator=(const IdxReader&) = delete;
+
+    IdxType type() const { return element_type; }
+    int rank() const { return static_cast<int>(dimensions.size()); }
+    const std::vector<int>& dims() const { return dimensions; }
+    // The big-endian magic number, e.g. 0x00000803 for a rank-3 UInt8 file.
+    uint32_t magic() const { return (static_cast<uint32_t>(element_type) << 8) | static_cast<uint32_t>(dimensions.size()); }
+    bool compressed() const { return gzip; }
+    const std::string& path() const { return file_path; }
+
+    // Copies the next n bytes of element data as stored (big-endian).
+    void read_bytes(void* destination, size_t n);
+    // Reads the next count elements converted to double.
+    void read_values(double* destination, size_t count);
+
+    static size_t element_size(IdxType type);
+    // path if it exists, else path + ".gz" if that exists, else path.
+    static std::string resolve(const std::string& path);
+
+private:
+    struct Chunk {
+        std::vector<unsigned char> data;
+        size_t size;
+    };
+
+    void producer_loop();
+
+    std::string file_path;
+    void* file;     // gzFile; kept opaque so users need no zlib header
+    bool gzip;
+    IdxType element_type;
+    std::vector<int> dimensions;
+
+    std::vector<Chunk> chunks;
+    std::deque<int> filled;
+    std::deque<int> free_chunks;
+    int current;
+    size_t offset;
+
+    std::thread producer;
+    std::mutex mutex;
+    std::condition_variable filled_cv;
+    std::condition_variable free_cv;
+    bool stop_requested;
+    bool finished;
+    std::string error;
+};
+
+#endif
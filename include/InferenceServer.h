@@ -0,0 +1,140 @@
+#ifndef INFERENCESERVER_H
+#define INFERENCESERVER_H
+
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <atomic>
+#include "Network.h"
+
+struct InferenceServerConfig {
+    std::string socket_path;
+    int max_batch_size;        // a batch runs as soon as this many requests are queued
+    int max_queue_delay_us;    // ... or when the oldest queued request has waited this long
+    int send_timeout_ms;       // a connection that accepts no response data for this long is closed
+
+    InferenceServerConfig() : max_batch_size(32), max_queue_delay_us(2000), send_timeout_ms(100) {}
+};
+
+struct InferenceServerStats {
+    unsigned long long requests;      // answered predictions
+    unsigned long long batches;
+    unsigned long long rejected;      // malformed requests
+    double uptime_seconds;
+    double requests_per_second;
+    double mean_batch_size;
+    double mean_queue_us;             // arrival until its batch starts
+    double max_queue_us;
+    double mean_latency_us;           // arrival until the response is written
+    double max_latency_us;
+    double mean_compute_us;           // forward pass per batch
+
+    InferenceServerStats();
+    std::string to_string() const;
+};
+
+// Serves Network::infer over a Unix domain socket. Requests from all connections
+// go into one queue; a batcher thread takes up to max_batch_size of them once the
+// batch is full or the oldest has waited max_queue_delay_us, runs one batched
+// forward pass and writes each result back to its connection.
+//
+// Wire format (host byte order, local use only). Requests are
+// {uint32 op, uint32 count} followed by count doubles for OP_PREDICT and nothing
+// for OP_STATS. Responses are {uint32 status, uint32 count} followed by count
+// doubles (predictions, or the InferenceServerStats fields in declaration order)
+// or, when status is STATUS_ERROR, count bytes of message. A connection may
+// pipeline predictions; they are answered in order. Responses are written by the
+// batcher, so a client that stops reading is disconnected after send_timeout_ms
+// rather than stalling every other connection.
+class InferenceServer {
+public:
+    static const uint32_t OP_PREDICT = 1;
+    static const uint32_t OP_STATS = 2;
+    static const uint32_t STATUS_OK = 0;
+    static const uint32_t STATUS_ERROR = 1;
+
+    InferenceServer(const Network& net, const InferenceServerConfig& config);
+    ~InferenceServer();
+
+    InferenceServer(const InferenceServer&) = delete;
+    InferenceServer& operator=(const InferenceServer&) = delete;
+
+    void start();
+    // Closes the socket and all connections; queued requests are dropped.
+    void stop();
+
+    InferenceServerStats stats() const;
+    int input_size() const { return input_features; }
+    int output_size() const { return output_features; }
+
+private:
+    struct Connection;
+    struct Request {
+        std::shared_ptr<Connection> connection;
+        std::vector<double> input;
+        std::chrono::steady_clock::time_point arrival;
+    };
+
+    void accept_loop();
+    void connection_loop(std::shared_ptr<Connection> connection);
+    void reap_connections();
+    void batch_loop();
+    void run_batch(std::vector<Request>& batch);
+
+    Network net;
+    InferenceServerConfig config;
+    int input_features;
+    int output_features;
+    int listen_fd;
+    std::atomic<bool> running;
+
+    std::thread acceptor;
+    std::thread batcher;
+    std::mutex connections_mutex;
+    std::vector<std::shared_ptr<Connection> > connections;   // each owns its reader thread
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<Request> queue;
+    bool stop_requested;
+
+    mutable std::mutex stats_mutex;
+    std::chrono::steady_clock::time_point start_time;
+    unsigned long long request_count;
+    unsigned long long batch_count;
+    unsigned long long rejected_count;
+    double total_queue_us;
+    double max_queue_us;
+    double total_latency_us;
+    double max_latency_us;
+    double total_compute_us;
+};
+
+// Blocking client for InferenceServer. send_predict/receive_prediction allow
+// several requests in flight on one connection.
+class InferenceClient {
+public:
+    explicit InferenceClient(const std::string& socket_path);
+    ~InferenceClient();
+
+    InferenceClient(const InferenceClient&) = delete;
+    InferenceClient& operator=(const InferenceClient&) = delete;
+
+    // input is one sample as a column vector; returns the output column.
+    Matrix predict(const Matrix& input);
+    void send_predict(const double* input, int n);
+    Matrix receive_prediction();
+
+    InferenceServerStats stats();
+
+private:
+    int fd;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// HDR-style histogram of non-negative integer values (latencies in nanoseconds).
+// Values below 2^(precision_bits + 1) are counted exactly; above that every
+// power-of-two range is split into 2^precision_bits linear buckets, so recorded
+// values keep a relative error below 2^-precision_bits (0.8% at the default 7)
+// across the whole range at fixed memory. Values above max_value are clamped
+// to it. Recording is not synchronized: give each thread its own histogram and
+// merge them afterwards.
+class LatencyHistogram {
+public:
+    explicit LatencyHistogram(uint64_t max_value = 60000000000ULL, int precision_bits = 7);
+
+    void record(uint64_t value);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? min_value : 0; }
+    uint64_t max() const { return max_recorded; }
+    double mean() const;
+    // Smallest bucket upper bound at or below which percentile% of the values
+    // fall, capped at max(). percentile is in [0, 100].
+    uint64_t percentile(double percentile) const;
+
+private:
+    size_t bucket_of(uint64_t value) const;
+    uint64_t bucket_upper_bound(size_t bucket) const;
+
+    int precision_bits;
+    uint64_t max_value;
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t min_value;
+    uint64_t max_recorded;
+    double sum;
+};
+
+#endif
@@ -2,6 +2,9 @@
 #define LAYER_H
 
 #include "Matrix.h"
+#include "SparseMatrix.h"
+#include "Activations.h"
+#include "WeightInitializer.h"
 #include <string>
 #include <vector>
 #include <stdexcept>
@@ -11,9 +14,12 @@ public:
     Matrix weights;
     Matrix biases;
     std::string activationName;
+    ActivationKind activation;
 
     Matrix last_input;      
-    Matrix last_z;          
+    SparseMatrix last_sparse_input; 
+    Matrix last_z;          // pre-activation, kept only when the derivative needs it (GELU)
+    Matrix last_output;     // activation output, kept for the other activations
     Matrix grad_weights;    
     Matrix grad_biases;     
 
@@ -21,12 +27,31 @@ public:
     Matrix delta_biases;    
 
     Layer(int inputSize, int outputSize, std::string _activationName);
+    // Weights from rng's stream instead of the global rand().
+    Layer(int inputSize, int outputSize, std::string _activationName,
+          const WeightInit& init, const WeightInitializer& rng, uint64_t stream);
+
+    // Redraws the weights and resets the biases to their initial values.
+    void initialize_parameters(const WeightInit& init, const WeightInitializer& rng, uint64_t stream);
 
     Matrix forward(Matrix& input);
+    Matrix forward(const SparseMatrix& input); 
+    Matrix forward(const MatrixView& input); 
+    Matrix infer(const MatrixView& input) const; 
     Matrix activate(Matrix& z) const;
     Matrix activatePrime(Matrix& z_values) const; 
 
     Matrix backward(const Matrix& d_output_error); 
+    // Training form of backward + accumulate_gradients: the gradients go straight
+    // into delta_weights and delta_biases (grad_weights is not written). With
+    // skip_zero_inputs the returned error is left 0 for inputs that were zero,
+    // which is exact when nothing reads it there (see
+    // activations::zero_output_blocks_gradient).
+    Matrix backward_accumulate(const Matrix& d_output_error, bool skip_zero_inputs);
+    void backward_sparse(const Matrix& d_output_error); 
+
+    bool has_cached_activations() const { return last_z.getRow() > 0 || last_output.getRow() > 0; }
+    void release_activations(bool keep_input); 
 
     void zero_deltas(); 
     void accumulate_gradients();
@@ -34,10 +59,34 @@ public:
 
     void printWeights() const;
 
+    static Matrix sum_columns(const Matrix& m);
+
+    // Whether forward and backward skip zero inputs and units with a zero d_z
+    // (on by default). Results are bit-identical either way.
+    static void setActivationSparsity(bool enabled);
+    static bool getActivationSparsity();
+
     static double sigmoid(double x);
     static double sigmoidPrime(double x); 
     static double relu(double x);
     static double reluPrime(double x); 
+
+private:
+    struct Unfilled {};
+    Layer(int inputSize, int outputSize, std::string _activationName, Unfilled);
+
+    void reset_biases();
+    void add_biases(Matrix& z) const;
+    Matrix multiply_weights(const MatrixView& input, std::vector<int>& active) const;
+    bool find_active(const Matrix& d_z);
+    void add_outer_product(const Matrix& d_z, Matrix& target) const;
+    Matrix propagate_error(const Matrix& d_z, bool skip_zero_inputs) const;
+    Matrix cache_and_activate(Matrix z);
+    Matrix activation_gradient(const Matrix& d_output_error) const;
+
+    // Rows of d_z and of last_input with a non-zero entry, from the last backward pass.
+    std::vector<int> active_units;
+    std::vector<int> active_inputs;
 };
 
 #endif  
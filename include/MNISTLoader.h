@@ -5,6 +5,7 @@
 #include <vector>
 #include <fstream> 
 #include "Matrix.h" 
+#include "SparseMatrix.h"
 
 struct MNISTDataset {
     std::vector<Matrix> images;   
@@ -14,13 +15,24 @@ struct MNISTDataset {
     int image_cols;
 };
 
+struct MNISTSparseDataset {
+    SparseMatrix images;          
+    std::vector<Matrix> labels;   
+    int number_of_items;
+    int image_rows;
+    int image_cols;
+};
+
+// Reads MNIST-style IDX image/label pairs, plain or gzip-compressed (see
+// IdxReader). A path that does not exist is retried with a .gz suffix.
 class MNISTLoader {
 public:
     static MNISTDataset load(const std::string& image_path, const std::string& label_path, int max_items = 0);
+    static MNISTSparseDataset load_sparse(const std::string& image_path, const std::string& label_path, int max_items = 0);
 
 private:
-    static int32_t read_int_big_endian(std::ifstream& ifs);
     static std::vector<Matrix> load_images(const std::string& path, int& number_of_images, int& image_rows, int& image_cols, int max_items);
+    static SparseMatrix load_images_sparse(const std::string& path, int& number_of_images, int& image_rows, int& image_cols, int max_items);
     static std::vector<Matrix> load_labels(const std::string& path, int& number_of_labels, int max_items);
 };
 
@@ -6,6 +6,8 @@
 #include <iostream>
 #include <iomanip>
 #include <stdexcept> 
+#include "MatrixView.h"
+#include "AlignedAllocator.h"
 
 #include <cuda_runtime.h>
 #include <cublas_v2.h>
@@ -28,11 +30,24 @@
         } \
     } while(0)
 
+// Cache blocking of the CPU GEMM in Matrix::multiply. Every output entry is
+// still summed in k order, so the blocking changes speed, never results.
+struct GemmBlocking {
+    int block_m;    // rows of lhs per pass; 0 means all rows
+    int block_k;
+    int block_n;
+
+    GemmBlocking(int m = 0, int k = 128, int n = 256) : block_m(m), block_k(k), block_n(n) {}
+    bool operator==(const GemmBlocking& other) const {
+        return block_m == other.block_m && block_k == other.block_k && block_n == other.block_n;
+    }
+};
+
 class Matrix {
 private:
     int rows_val; 
     int cols_val; 
-    std::vector<double> h_data; 
+    std::vector<double, AlignedAllocator<double> > h_data; 
     double* d_data;             
     bool data_on_device;        
 
@@ -54,6 +69,8 @@ public:
     Matrix(int r, int c, bool on_gpu_default = false);
     Matrix(int r, int c, double val, bool on_gpu_default = false);
 
+    explicit Matrix(const MatrixView& view);
+
     Matrix(const Matrix& other);
     Matrix& operator=(const Matrix& other);
 
@@ -67,12 +84,17 @@ public:
     double getEntry(int r, int c) const; 
 
     void setEntry(int r, int c, double entry); 
+    void reshape(int r, int c); 
 
     void to_device();    
     void to_host();      
     bool is_on_device() const { return data_on_device; }
     double* get_device_ptr() { return d_data; } 
     const double* get_device_ptr() const { return d_data; } 
+    double* get_host_ptr(); 
+    const double* get_host_ptr() const { return h_data.empty() ? nullptr : h_data.data(); } 
+
+    MatrixView view() const; 
 
     void display() const; 
     Matrix applyFunction(double (*f)(double x)); 
@@ -84,6 +106,21 @@ public:
     Matrix multiplyScalar(double scalar) const;    
     Matrix transpose() const;                 
 
+    static Matrix multiply(const MatrixView& lhs, const MatrixView& rhs);
+    static Matrix multiply(const MatrixView& lhs, const MatrixView& rhs, const GemmBlocking& blocking);
+    static Matrix add(const MatrixView& lhs, const MatrixView& rhs);
+    static Matrix subtract(const MatrixView& lhs, const MatrixView& rhs);
+    static Matrix multiplyElements(const MatrixView& lhs, const MatrixView& rhs);
+    static Matrix multiplyScalar(const MatrixView& m, double scalar);
+    static Matrix transpose(const MatrixView& m);
+    static Matrix applyFunction(const MatrixView& m, double (*f)(double x));
+
+    // Blocking the CPU multiply uses for an m x k by k x n product: the one set
+    // for that shape (normally by GemmTuner), else the default.
+    static GemmBlocking gemmBlocking(int m, int k, int n);
+    static void setGemmBlocking(int m, int k, int n, const GemmBlocking& blocking);
+    static void clearGemmBlocking();
+
     Matrix operator+(const Matrix& m) const { return this->add(m); }
     Matrix operator-(const Matrix& m) const { return this->subtract(m); }
     Matrix operator*(const Matrix& m) const { return this->multiply(m); }
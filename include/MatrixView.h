@@ -0,0 +1,72 @@
+#ifndef MATRIXVIEW_H
+#define MATRIXVIEW_H
+
+#include <string>
+#include <stdexcept>
+
+// Non-owning, strided view of row-major host memory. Element (r, c) lives at
+// data[r * row_stride + c * col_stride]; a plain view has row_stride equal to
+// the leading dimension and col_stride 1, and transpose() just swaps strides.
+class MatrixView {
+private:
+    const double* data_ptr;
+    int rows_val;
+    int cols_val;
+    long row_stride;
+    long col_stride;
+
+    MatrixView(const double* data, int r, int c, long rs, long cs)
+        : data_ptr(data), rows_val(r), cols_val(c), row_stride(rs), col_stride(cs) {}
+
+public:
+    MatrixView() : data_ptr(nullptr), rows_val(0), cols_val(0), row_stride(0), col_stride(1) {}
+
+    MatrixView(const double* data, int r, int c)
+        : data_ptr(data), rows_val(r), cols_val(c), row_stride(c), col_stride(1) {
+        if (r < 0 || c < 0) {
+            throw std::invalid_argument("MatrixView dimensions cannot be negative.");
+        }
+    }
+
+    MatrixView(const double* data, int r, int c, int leading_dimension)
+        : data_ptr(data), rows_val(r), cols_val(c), row_stride(leading_dimension), col_stride(1) {
+        if (r < 0 || c < 0) {
+            throw std::invalid_argument("MatrixView dimensions cannot be negative.");
+        }
+        if (leading_dimension < c) {
+            throw std::invalid_argument("MatrixView: Leading dimension " + std::to_string(leading_dimension) +
+                                        " is smaller than column count " + std::to_string(c));
+        }
+    }
+
+    int getRow() const { return rows_val; }
+    int getCol() const { return cols_val; }
+    long getRowStride() const { return row_stride; }
+    long getColStride() const { return col_stride; }
+    const double* data() const { return data_ptr; }
+
+    bool is_empty() const { return rows_val == 0 || cols_val == 0; }
+    bool has_unit_col_stride() const { return col_stride == 1 || cols_val <= 1; }
+    bool is_contiguous() const { return has_unit_col_stride() && (row_stride == cols_val || rows_val <= 1); }
+
+    double operator()(int r, int c) const { return data_ptr[r * row_stride + c * col_stride]; }
+
+    MatrixView block(int r0, int c0, int r, int c) const {
+        if (r0 < 0 || c0 < 0 || r < 0 || c < 0 || r0 + r > rows_val || c0 + c > cols_val) {
+            throw std::out_of_range("MatrixView::block: Block (" + std::to_string(r0) + "," + std::to_string(c0) + ") " +
+                                    std::to_string(r) + "x" + std::to_string(c) + " out of bounds for " +
+                                    std::to_string(rows_val) + "x" + std::to_string(cols_val) + " view.");
+        }
+        const double* start = (r == 0 || c == 0) ? data_ptr : data_ptr + r0 * row_stride + c0 * col_stride;
+        return MatrixView(start, r, c, row_stride, col_stride);
+    }
+
+    MatrixView rowRange(int r0, int r) const { return block(r0, 0, r, cols_val); }
+    MatrixView colRange(int c0, int c) const { return block(0, c0, rows_val, c); }
+    MatrixView column(int c) const { return block(0, c, rows_val, 1); }
+    MatrixView row(int r) const { return block(r, 0, 1, cols_val); }
+
+    MatrixView transpose() const { return MatrixView(data_ptr, cols_val, rows_val, col_stride, row_stride); }
+};
+
+#endif
@@ -3,14 +3,36 @@
 
 #include <vector>
 #include <string>
+#include <functional>
 #include "Layer.h"
 #include "Matrix.h"
+#include "MatrixView.h"
+#include "SparseMatrix.h"
+#include "SpatialLayer.h"
+
+struct ParameterSnapshot {
+    std::vector<Matrix> weights;
+    std::vector<Matrix> biases;
+};
 
 class Network {
 public:
+    typedef std::function<void(size_t layer_index)> LayerReadyCallback;
+
     Network(const std::vector<int>& layerSizes, const std::vector<std::string>& activations);
+    // Weights from a WeightInitializer(seed, threads) instead of rand(): the same
+    // seed gives the same network for any thread count or construction order.
+    Network(const std::vector<int>& layerSizes, const std::vector<std::string>& activations,
+            const WeightInit& init, uint64_t seed, int threads = 0);
+    // Convolution/pooling stages run first; layerSizes[0] must equal the flattened
+    // output size of the last feature layer.
+    Network(const std::vector<SpatialLayer>& featureLayers, const std::vector<int>& layerSizes,
+            const std::vector<std::string>& activations);
 
     Matrix predict(Matrix& input);
+    Matrix predict(const SparseMatrix& input);
+    Matrix predict(const MatrixView& input);
+    Matrix infer(const MatrixView& input) const;
 
     double meanSquaredError(const Matrix& predicted, const Matrix& actual) const;
     Matrix meanSquaredErrorDerivative(const Matrix& predicted, const Matrix& actual) const;
@@ -20,12 +42,53 @@ public:
     double train_on_batch(const std::vector<Matrix>& batch_inputs, 
                           const std::vector<Matrix>& batch_targets, 
                           double learningRate);
+    double train_on_sparse_batch(const SparseMatrix& batch_inputs,
+                                 const std::vector<Matrix>& batch_targets,
+                                 double learningRate);
+
+    // Split form of train_on_batch: accumulates the summed gradients of the batch
+    // into each layer's deltas and returns the summed loss. on_layer_ready fires
+    // once per layer, during the last sample's backward pass, as soon as that
+    // layer's deltas are final.
+    double accumulate_batch_gradients(const std::vector<Matrix>& batch_inputs,
+                                      const std::vector<Matrix>& batch_targets,
+                                      const LayerReadyCallback& on_layer_ready = LayerReadyCallback());
+    double accumulate_sparse_batch_gradients(const SparseMatrix& batch_inputs,
+                                             const std::vector<Matrix>& batch_targets,
+                                             const LayerReadyCallback& on_layer_ready = LayerReadyCallback());
+    void apply_gradients(double learning_rate, int batch_size);
+
+    // Activation checkpointing: with interval k > 1 only every k-th layer keeps its
+    // input during training and the layers in between are recomputed in backward.
+    void set_activation_checkpoint_interval(int k);
+    int get_activation_checkpoint_interval() const { return checkpoint_interval; }
+
+    // Redraws every weight (dense layer i uses stream i, feature layer f stream
+    // 2^32 + f) and resets the biases.
+    void initialize_parameters(const WeightInit& init, uint64_t seed, int threads = 0);
+
+    void snapshot_parameters(ParameterSnapshot& snapshot) const;
+    void restore_parameters(const ParameterSnapshot& snapshot);
+
+    const std::vector<Layer>& getLayers() const { return layers; }
+    std::vector<Layer>& getLayers() { return layers; }
+    const std::vector<SpatialLayer>& getFeatureLayers() const { return feature_layers; }
+    std::vector<SpatialLayer>& getFeatureLayers() { return feature_layers; }
 private:
+    Matrix forward_features(const MatrixView& input);
+    Matrix infer_features(const MatrixView& input) const;
+
+    void release_after_forward(size_t layer_index);
+    void recompute_segment(size_t begin, size_t end);
+    void backpropagate(const Matrix& output_error_gradient, bool sparse_input, bool accumulate,
+                       const LayerReadyCallback& on_layer_ready);
+
     void zero_all_layer_deltas();
-    void accumulate_all_layer_gradients();
     void update_all_layer_parameters(double learning_rate, int batch_size);
 
+    std::vector<SpatialLayer> feature_layers;
     std::vector<Layer> layers; 
+    int checkpoint_interval;
 };
 
 #endif
@@ -0,0 +1,73 @@
+#ifndef NUMAPARALLELTRAINER_H
+#define NUMAPARALLELTRAINER_H
+
+#include <vector>
+#include <memory>
+#include <random>
+#include "Network.h"
+#include "ThreadPool.h"
+
+// Multithreaded data-parallel training inside one process. Every ThreadPool
+// worker owns a replica of the network, its gradient buffers and a shard of the
+// dataset, all allocated and first touched by that (pinned) worker so they live
+// on its NUMA node. Each step the workers accumulate gradients on their shards,
+// sum them slice by slice into a shared buffer, and apply the same update to
+// their own replica.
+class NumaParallelTrainer {
+public:
+    NumaParallelTrainer(const Network& net, ThreadPool& pool,
+                        const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets,
+                        unsigned int seed = 123);
+    NumaParallelTrainer(const Network& net, ThreadPool& pool,
+                        const SparseMatrix& inputs, const std::vector<Matrix>& targets,
+                        unsigned int seed = 123);
+    ~NumaParallelTrainer();
+
+    NumaParallelTrainer(const NumaParallelTrainer&) = delete;
+    NumaParallelTrainer& operator=(const NumaParallelTrainer&) = delete;
+
+    // One pass over every shard. A step takes up to per_worker_batch samples
+    // from each shard; returns the mean loss over the epoch. Each worker sums its
+    // own samples and the workers are then summed in order, so results are
+    // reproducible for a fixed thread count only.
+    double train_epoch(int per_worker_batch, double learning_rate);
+
+    // Reproducible variant: steps take global_batch samples from one shuffle of
+    // the whole dataset, gradients are summed sequentially within leaves of
+    // leaf_size consecutive samples, and the leaves are combined in a fixed
+    // pairwise tree. Nothing depends on which worker computes what, so the
+    // parameters are bit-identical for any thread count and schedule.
+    double train_epoch_deterministic(int global_batch, double learning_rate, int leaf_size = 8);
+
+    // Runs inputs through the replicas, split across workers.
+    std::vector<Matrix> infer(const std::vector<Matrix>& inputs);
+
+    void copy_parameters_to(Network& net) const;
+    size_t shard_size(int worker) const;
+
+private:
+    struct Replica;
+
+    void create_replicas(const Network& net, const std::vector<Matrix>* inputs, const SparseMatrix* sparse_inputs,
+                         const std::vector<Matrix>& targets, unsigned int seed);
+    void reduce_slice(int worker);
+    void tree_reduce_slice(int worker, size_t leaves);
+    void apply_reduced(int worker, size_t global_batch, double learning_rate);
+    void compute_leaf(Replica& replica, size_t leaf, size_t first, size_t last);
+    void slice_bounds(int worker, size_t& begin, size_t& end) const;
+
+    ThreadPool& pool;
+    std::vector<std::unique_ptr<Replica> > replicas;
+    std::vector<size_t> parameter_offsets;   // start of each delta matrix in reduced
+    double* reduced;
+    size_t reduced_count;
+
+    std::vector<size_t> shard_begin;         // global index of each shard's first sample
+    std::vector<size_t> global_order;        // deterministic mode: shuffle of all samples
+    std::default_random_engine global_rng;
+    double* leaf_gradients;                  // deterministic mode: one reduced_count block per leaf
+    size_t leaf_capacity;
+    std::vector<double> leaf_losses;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef NUMATOPOLOGY_H
+#define NUMATOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+// CPUs per NUMA node, read from sysfs and restricted to the CPUs this process
+// may run on. Hosts without NUMA information are reported as a single node.
+class NumaTopology {
+public:
+    static NumaTopology detect(const std::string& sysfs_node_root = "/sys/devices/system/node");
+    static const NumaTopology& system();
+
+    // Parses sysfs cpu lists such as "0-3,8-11".
+    static std::vector<int> parse_cpu_list(const std::string& list);
+
+    int node_count() const { return static_cast<int>(node_cpus.size()); }
+    int cpu_count() const;
+    const std::vector<int>& cpus_of(int node) const { return node_cpus[static_cast<size_t>(node)]; }
+    const std::vector<int>& node_ids() const { return ids; }
+    int node_of_cpu(int cpu) const;
+    std::string describe() const;
+
+private:
+    std::vector<int> ids;                    // sysfs node number of each entry
+    std::vector<std::vector<int> > node_cpus;
+};
+
+namespace thread_affinity {
+
+bool pin_current_thread(int cpu);
+bool pin_current_thread(const std::vector<int>& cpus);
+void unpin_current_thread();
+int current_cpu();
+
+} // namespace thread_affinity
+
+#endif
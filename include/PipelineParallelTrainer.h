@@ -0,0 +1,96 @@
+#ifndef PIPELINEPARALLELTRAINER_H
+#define PIPELINEPARALLELTRAINER_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+#include "Network.h"
+#include "ThreadPool.h"
+
+enum class PipelineSchedule {
+    GPipe,      // all forwards, then all backwards; stashes every microbatch
+    OneFOneB    // warm up, then alternate one forward with one backward
+};
+
+// Busy time per stage against wall time, accumulated over train_batch calls.
+// The bubble is the share of stage-time spent waiting; the ideal bubble is
+// (S - 1) / (M + S - 1) for S stages and M equal microbatches.
+struct PipelineStats {
+    int batches;
+    double wall_seconds;
+    std::vector<double> stage_busy_seconds;
+    double ideal_bubble_sum;
+
+    PipelineStats() : batches(0), wall_seconds(0.0), ideal_bubble_sum(0.0) {}
+    double bubble_fraction() const;
+    double ideal_bubble_fraction() const { return batches ? ideal_bubble_sum / batches : 0.0; }
+    std::string to_string() const;
+};
+
+// Pipeline-parallel training of a dense Network. The layers are split into
+// contiguous stages of roughly equal parameter count, one per ThreadPool worker,
+// and each stage's layers are copied (and first touched) by that pinned worker,
+// so a stage's weights stay in its core's cache. A batch is cut into
+// microbatches of microbatch_size samples that flow forward through the stages
+// and back; every stage sums its gradients over the whole batch and applies
+// the same SGD step as Network::train_on_batch. Results match it up to
+// floating-point summation order.
+class PipelineParallelTrainer {
+public:
+    PipelineParallelTrainer(const Network& net, ThreadPool& pool);
+    ~PipelineParallelTrainer();
+
+    PipelineParallelTrainer(const PipelineParallelTrainer&) = delete;
+    PipelineParallelTrainer& operator=(const PipelineParallelTrainer&) = delete;
+
+    // Returns the mean loss over the batch.
+    double train_batch(const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets,
+                       int microbatch_size, double learning_rate,
+                       PipelineSchedule schedule = PipelineSchedule::OneFOneB);
+
+    void copy_parameters_to(Network& net) const;
+
+    int stage_count() const { return static_cast<int>(stage_begin.size()); }
+    // Layers [first_layer(s), first_layer(s + 1)) belong to stage s.
+    size_t first_layer(int stage) const;
+
+    const PipelineStats& stats() const { return pipeline_stats; }
+    void reset_stats();
+
+private:
+    struct Stage;
+
+    // Hand-off between stage s and s + 1: activations go forward, errors back.
+    struct Boundary {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<Matrix> activations;
+        std::vector<Matrix> errors;
+        std::vector<char> activation_ready;
+        std::vector<char> error_ready;
+    };
+
+    void run_stage(int s, const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets,
+                   int microbatch_size, double learning_rate, PipelineSchedule schedule);
+    Matrix take(Boundary& boundary, std::vector<Matrix> Boundary::* slots, std::vector<char> Boundary::* ready, int microbatch);
+    void put(Boundary& boundary, std::vector<Matrix> Boundary::* slots, std::vector<char> Boundary::* ready, int microbatch, Matrix value);
+    void abort(std::exception_ptr error);
+
+    ThreadPool& pool;
+    size_t layer_count;
+    std::vector<size_t> stage_begin;
+    std::vector<std::unique_ptr<Stage> > stages;
+    std::vector<std::unique_ptr<Boundary> > boundaries;
+
+    std::mutex abort_mutex;
+    std::atomic<bool> aborted;
+    std::exception_ptr first_error;
+
+    PipelineStats pipeline_stats;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef PRUNEDNETWORK_H
+#define PRUNEDNETWORK_H
+
+#include <vector>
+#include <string>
+#include "Matrix.h"
+#include "MatrixView.h"
+#include "SparseMatrix.h"
+#include "Network.h"
+
+// Inference-only copy of a Layer whose weights are stored in CSR form (one row
+// per output neuron), so zeros left by pruning cost neither memory nor FLOPs.
+class SparseLayer {
+public:
+    explicit SparseLayer(const Layer& layer);
+
+    Matrix infer(const MatrixView& input) const;
+
+    int getInputSize() const { return weights.getCol(); }
+    int getOutputSize() const { return weights.getRow(); }
+    size_t nonZeros() const { return weights.nonZeros(); }
+    size_t storage_bytes() const;
+
+    const SparseMatrix& getWeights() const { return weights; }
+
+private:
+    SparseMatrix weights;
+    Matrix biases;
+    std::string activationName;
+    ActivationKind activation;
+};
+
+class PrunedNetwork {
+public:
+    explicit PrunedNetwork(const Network& net);
+
+    Matrix infer(const MatrixView& input) const;
+
+    const std::vector<SparseLayer>& getLayers() const { return layers; }
+    size_t storage_bytes() const;
+    static size_t dense_storage_bytes(const Network& net);
+
+private:
+    std::vector<SparseLayer> layers;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef PRUNER_H
+#define PRUNER_H
+
+#include <vector>
+#include "Network.h"
+
+enum class PruningScope {
+    Global,     // one magnitude threshold across the weights of all layers
+    PerLayer    // every layer loses the same fraction of its own weights
+};
+
+// Magnitude pruning of a trained Network. prune() zeros the smallest weights
+// and remembers which ones it removed; the fine_tune_* calls train with that
+// mask held fixed so pruned weights stay at zero. Biases are never pruned.
+class Pruner {
+public:
+    explicit Pruner(double sparsity, PruningScope scope = PruningScope::Global);
+
+    void prune(Network& net);
+    void apply_mask(Network& net) const;
+    bool has_mask() const { return !masks.empty(); }
+
+    double fine_tune_on_batch(Network& net,
+                              const std::vector<Matrix>& batch_inputs,
+                              const std::vector<Matrix>& batch_targets,
+                              double learning_rate) const;
+    double fine_tune_on_sparse_batch(Network& net,
+                                     const SparseMatrix& batch_inputs,
+                                     const std::vector<Matrix>& batch_targets,
+                                     double learning_rate) const;
+
+    // Fraction of weights (biases excluded) that are exactly zero.
+    static double sparsity(const Network& net);
+    static double layer_sparsity(const Layer& layer);
+
+private:
+    double target_sparsity;
+    PruningScope scope;
+    std::vector<std::vector<unsigned char> > masks;
+};
+
+#endif
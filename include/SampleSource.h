@@ -0,0 +1,111 @@
+#ifndef SAMPLESOURCE_H
+#define SAMPLESOURCE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <istream>
+#include "Matrix.h"
+
+class IdxReader;
+
+// A possibly unbounded stream of (input, target) column vectors. next() fills
+// the next sample and returns false once the stream has ended; it throws on
+// malformed data. Sources are read from a single thread.
+class SampleSource {
+public:
+    virtual ~SampleSource() {}
+    virtual bool next(Matrix& input, Matrix& target) = 0;
+    virtual int input_size() const = 0;
+    virtual int output_size() const = 0;
+};
+
+// One sample per line: input_size values then output_size target values,
+// separated by spaces or commas. With output_size > 1 a line may instead end in
+// a single class index, which is one-hot encoded. Blank lines and lines starting
+// with '#' are skipped. The path "-" reads stdin, so pipes work as sources.
+class TextSampleSource : public SampleSource {
+public:
+    TextSampleSource(const std::string& path, int input_size, int output_size);
+
+    bool next(Matrix& input, Matrix& target);
+    int input_size() const { return inputs; }
+    int output_size() const { return outputs; }
+
+private:
+    std::string path;
+    std::unique_ptr<std::istream> file;
+    std::istream* in;
+    int inputs;
+    int outputs;
+    long long line_number;
+    std::vector<double> values;
+};
+
+// Fixed-size records of input_size + output_size native-endian doubles, read
+// in large blocks. The path "-" reads stdin.
+class BinarySampleSource : public SampleSource {
+public:
+    BinarySampleSource(const std::string& path, int input_size, int output_size);
+    ~BinarySampleSource();
+
+    BinarySampleSource(const BinarySampleSource&) = delete;
+    BinarySampleSource& operator=(const BinarySampleSource&) = delete;
+
+    bool next(Matrix& input, Matrix& target);
+    int input_size() const { return inputs; }
+    int output_size() const { return outputs; }
+
+private:
+    bool fill(size_t need);
+
+    std::string path;
+    int fd;
+    bool owns_fd;
+    int inputs;
+    int outputs;
+    std::vector<char> buffer;
+    size_t begin;
+    size_t end;
+};
+
+// MNIST-style IDX images and labels (plain or gzip) streamed one sample at a
+// time; UInt8 images are scaled to [0, 1] and labels one-hot encoded.
+class IdxSampleSource : public SampleSource {
+public:
+    IdxSampleSource(const std::string& image_path, const std::string& label_path, int classes = 10);
+    ~IdxSampleSource();
+
+    bool next(Matrix& input, Matrix& target);
+    int input_size() const { return inputs; }
+    int output_size() const { return classes; }
+
+private:
+    std::unique_ptr<IdxReader> images;
+    std::unique_ptr<IdxReader> labels;
+    int inputs;
+    int classes;
+    long long remaining;
+    std::vector<unsigned char> pixels;
+};
+
+// Wraps a callable, e.g. a simulator or a data-augmentation loop.
+class GeneratorSampleSource : public SampleSource {
+public:
+    typedef std::function<bool(Matrix& input, Matrix& target)> Generator;
+
+    GeneratorSampleSource(const Generator& generator, int input_size, int output_size)
+        : generator(generator), inputs(input_size), outputs(output_size) {}
+
+    bool next(Matrix& input, Matrix& target) { return generator(input, target); }
+    int input_size() const { return inputs; }
+    int output_size() const { return outputs; }
+
+private:
+    Generator generator;
+    int inputs;
+    int outputs;
+};
+
+#endif
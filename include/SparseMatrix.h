@@ -0,0 +1,50 @@
+#ifndef SPARSEMATRIX_H
+#define SPARSEMATRIX_H
+
+#include <vector>
+#include <cstddef>
+#include "Matrix.h"
+#include "MatrixView.h"
+
+// Compressed sparse row storage. Each row holds one sample, so a batch of B
+// inputs with K features is a B x K SparseMatrix.
+class SparseMatrix {
+private:
+    int rows_val;
+    int cols_val;
+    std::vector<int> row_ptr;
+    std::vector<int> col_indices;
+    std::vector<double> values;
+
+public:
+    SparseMatrix();
+    explicit SparseMatrix(int c);
+
+    static SparseMatrix fromDense(const Matrix& m);
+
+    int getRow() const { return rows_val; }
+    int getCol() const { return cols_val; }
+    size_t nonZeros() const { return values.size(); }
+
+    const std::vector<int>& getRowPtr() const { return row_ptr; }
+    const std::vector<int>& getColIndices() const { return col_indices; }
+    const std::vector<double>& getValues() const { return values; }
+
+    void reserve(size_t rows, size_t non_zeros);
+    void appendRow(const double* dense_row, int n);
+    void appendRow(const unsigned char* dense_row, int n, double scale);
+    void appendRow(const SparseMatrix& source, int r);
+
+    SparseMatrix row(int r) const;
+    SparseMatrix gatherRows(const std::vector<size_t>& indices, size_t begin, size_t end) const;
+    Matrix toDense() const;
+
+    // this (M x K) * dense (K x B) -> M x B, for CSR weight matrices
+    Matrix multiply(const MatrixView& dense) const;
+    // dense (M x K) * this^T (K x B) -> M x B
+    Matrix leftMultiply(const Matrix& dense) const;
+    // target (M x K) += d_z (M x B) * this (B x K), touching only non-zero columns
+    void accumulateOuterProduct(const Matrix& d_z, Matrix& target) const;
+};
+
+#endif
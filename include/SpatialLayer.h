@@ -0,0 +1,99 @@
+#ifndef SPATIALLAYER_H
+#define SPATIALLAYER_H
+
+#include "Matrix.h"
+#include "MatrixView.h"
+#include "Activations.h"
+#include "WeightInitializer.h"
+#include <string>
+#include <vector>
+
+enum class SpatialLayerType {
+    Conv2D,
+    MaxPool2D,
+    AvgPool2D
+};
+
+struct SpatialShape {
+    int channels;
+    int height;
+    int width;
+
+    SpatialShape() : channels(0), height(0), width(0) {}
+    SpatialShape(int c, int h, int w) : channels(c), height(h), width(w) {}
+
+    int size() const { return channels * height * width; }
+};
+
+// Convolution or pooling stage that runs in front of the dense layers of a
+// Network. A sample is a column vector holding a channels x height x width
+// image in channel-major order, so stages chain with each other and with Layer.
+// Convolution is im2col followed by Matrix::multiply; backward uses col2im.
+class SpatialLayer {
+public:
+    Matrix weights;         // out_channels x (in_channels * kernel * kernel); empty for pooling
+    Matrix biases;          // out_channels x 1; empty for pooling
+    std::string activationName;
+
+    Matrix delta_weights;
+    Matrix delta_biases;
+
+    static SpatialLayer conv2d(const SpatialShape& input, int out_channels, int kernel_size,
+                               int stride = 1, int padding = 0, const std::string& activation = "relu");
+    // stride 0 means non-overlapping windows (stride == window).
+    static SpatialLayer max_pool(const SpatialShape& input, int window, int stride = 0);
+    static SpatialLayer avg_pool(const SpatialShape& input, int window, int stride = 0);
+
+    SpatialLayerType getType() const { return type; }
+    const SpatialShape& getInputShape() const { return input_shape; }
+    const SpatialShape& getOutputShape() const { return output_shape; }
+    int getInputSize() const { return input_shape.size(); }
+    int getOutputSize() const { return output_shape.size(); }
+    bool has_parameters() const { return type == SpatialLayerType::Conv2D; }
+
+    // Training path, one sample (getInputSize() x 1) at a time.
+    Matrix forward(const MatrixView& input);
+    // Returns the gradient w.r.t. the last input; adds parameter gradients to
+    // the deltas when accumulate is set.
+    Matrix backward(const Matrix& d_output, bool accumulate = true);
+    // Any number of samples, one per column.
+    Matrix infer(const MatrixView& input) const;
+
+    bool has_cached_activations() const { return last_z.getRow() > 0; }
+    void release_activations();
+
+    void zero_deltas();
+    void update_parameters_from_deltas(double learning_rate, int batch_size);
+
+    // Redraws convolution weights (fan-out = out_channels * kernel * kernel)
+    // and resets the biases; no-op for pooling.
+    void initialize_parameters(const WeightInit& init, const WeightInitializer& rng, uint64_t stream);
+
+    // image: channels x height x width; cols: (channels * kernel * kernel) x (out_h * out_w)
+    static void im2col(const double* image, const SpatialShape& shape, int kernel, int stride, int padding,
+                       int out_h, int out_w, double* cols);
+    // Adds cols back into image (which must be zeroed by the caller).
+    static void col2im(const double* cols, const SpatialShape& shape, int kernel, int stride, int padding,
+                       int out_h, int out_w, double* image);
+
+private:
+    SpatialLayer(SpatialLayerType type, const SpatialShape& input, int out_channels, int kernel_size,
+                 int stride, int padding, const std::string& activation);
+
+    void forward_sample(const double* image, double* output, Matrix* cols_out, Matrix* z_out,
+                        std::vector<int>* argmax_out) const;
+
+    SpatialLayerType type;
+    ActivationKind activation_kind;
+    SpatialShape input_shape;
+    SpatialShape output_shape;
+    int kernel;
+    int stride;
+    int padding;
+
+    Matrix last_cols;               // conv: im2col of the last input
+    Matrix last_z;                  // conv: pre-activation; pooling: the last output
+    std::vector<int> last_argmax;   // max pooling: input index of each output
+};
+
+#endif
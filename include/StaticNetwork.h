@@ -0,0 +1,334 @@
+#ifndef STATICNETWORK_H
+#define STATICNETWORK_H
+
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "Network.h"
+
+// Fixed-topology networks whose layer sizes and activations are template
+// parameters, e.g. StaticNetwork<784, Dense<100, ReLU>, Dense<10, Sigmoid>>.
+// All buffers live inside the object with 64-byte alignment and every loop has
+// a compile-time trip count, so the compiler can unroll and vectorize them.
+// Weights use the same row-major layout as Layer and can be copied to and from
+// a dynamic Network with the same topology.
+
+struct ReLU {
+    static const char* name() { return "relu"; }
+    static double apply(double x) { return x > 0 ? x : 0.0; }
+    static double prime(double x) { return x <= 0 ? 0.0 : 1.0; }
+};
+
+struct Sigmoid {
+    static const char* name() { return "sigmoid"; }
+    static double apply(double x) { return 1.0 / (1.0 + std::exp(-x)); }
+    static double prime(double x) { double s = apply(x); return s * (1.0 - s); }
+};
+
+template <int Outputs, typename Activation>
+struct Dense {
+    static const int outputs = Outputs;
+    typedef Activation activation;
+};
+
+namespace static_network_detail {
+
+inline void* aligned_allocate(size_t size) {
+    void* p = nullptr;
+    if (posix_memalign(&p, 64, size) != 0) throw std::bad_alloc();
+    return p;
+}
+
+inline void aligned_release(void* p) { std::free(p); }
+
+inline void copy_from_matrix(const Matrix& m, double* dst, int rows, int cols, const std::string& what) {
+    if (m.getRow() != rows || m.getCol() != cols) {
+        throw std::invalid_argument("StaticNetwork: Shape mismatch for " + what + ": expected " +
+                                    std::to_string(rows) + "x" + std::to_string(cols) + ", got " +
+                                    std::to_string(m.getRow()) + "x" + std::to_string(m.getCol()));
+    }
+    Matrix temp_host;
+    const Matrix* src = &m;
+    if (m.is_on_device() && m.get_device_ptr()) { temp_host = m; temp_host.to_host(); src = &temp_host; }
+    std::memcpy(dst, src->get_host_ptr(), sizeof(double) * static_cast<size_t>(rows) * cols);
+}
+
+inline Matrix copy_to_matrix(const double* src, int rows, int cols) {
+    Matrix m(rows, cols, 0.0);
+    std::memcpy(m.get_host_ptr(), src, sizeof(double) * static_cast<size_t>(rows) * cols);
+    return m;
+}
+
+template <int In, int Out, typename Act>
+struct DenseStage {
+    alignas(64) double weights[Out * In];
+    alignas(64) double biases[Out];
+    alignas(64) double delta_weights[Out * In];
+    alignas(64) double delta_biases[Out];
+
+    alignas(64) double input[In];
+    alignas(64) double z[Out];
+    alignas(64) double output[Out];
+    alignas(64) double d_input[In];
+
+    // Same Xavier-uniform scheme and rand() call order as the Layer constructor.
+    void initialize() {
+        double limit = std::sqrt(6.0 / (static_cast<double>(In) + static_cast<double>(Out)));
+        for (int i = 0; i < Out * In; ++i) {
+            weights[i] = -limit + (static_cast<double>(rand()) / RAND_MAX) * (2.0 * limit);
+        }
+        double bias_init_val = (std::string(Act::name()) == "relu") ? 0.01 : 0.0;
+        for (int o = 0; o < Out; ++o) {
+            biases[o] = bias_init_val;
+        }
+    }
+
+    void forward(const double* x) {
+        std::memcpy(input, x, sizeof(input));
+        for (int o = 0; o < Out; ++o) {
+            const double* w_row = weights + o * In;
+            double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+            int k = 0;
+            for (; k + 4 <= In; k += 4) {
+                s0 += w_row[k] * x[k];
+                s1 += w_row[k + 1] * x[k + 1];
+                s2 += w_row[k + 2] * x[k + 2];
+                s3 += w_row[k + 3] * x[k + 3];
+            }
+            for (; k < In; ++k) {
+                s0 += w_row[k] * x[k];
+            }
+            z[o] = (s0 + s1) + (s2 + s3) + biases[o];
+        }
+        for (int o = 0; o < Out; ++o) {
+            output[o] = Act::apply(z[o]);
+        }
+    }
+
+    template <bool Propagate>
+    const double* backward(const double* d_output) {
+        alignas(64) double d_z[Out];
+        for (int o = 0; o < Out; ++o) {
+            d_z[o] = d_output[o] * Act::prime(z[o]);
+        }
+        for (int o = 0; o < Out; ++o) {
+            double g = d_z[o];
+            double* dw_row = delta_weights + o * In;
+            for (int k = 0; k < In; ++k) {
+                dw_row[k] += g * input[k];
+            }
+            delta_biases[o] += g;
+        }
+        if (!Propagate) {
+            return nullptr;
+        }
+        std::memset(d_input, 0, sizeof(d_input));
+        for (int o = 0; o < Out; ++o) {
+            double g = d_z[o];
+            const double* w_row = weights + o * In;
+            for (int k = 0; k < In; ++k) {
+                d_input[k] += w_row[k] * g;
+            }
+        }
+        return d_input;
+    }
+
+    void zero_deltas() {
+        std::memset(delta_weights, 0, sizeof(delta_weights));
+        std::memset(delta_biases, 0, sizeof(delta_biases));
+    }
+
+    void update(double scale) {
+        for (int i = 0; i < Out * In; ++i) {
+            weights[i] -= scale * delta_weights[i];
+        }
+        for (int o = 0; o < Out; ++o) {
+            biases[o] -= scale * delta_biases[o];
+        }
+    }
+};
+
+template <int In, typename... Layers>
+struct Stack;
+
+template <int In>
+struct Stack<In> {
+    static const int inputs = In;
+    static const int outputs = In;
+    static const size_t depth = 0;
+
+    void initialize() {}
+    const double* forward(const double* x) { return x; }
+    template <bool Propagate>
+    const double* backward(const double* d_output) { return d_output; }
+    void zero_deltas() {}
+    void update(double) {}
+    void load_from(const std::vector<Layer>&, size_t) {}
+    void store_to(ParameterSnapshot&, size_t) const {}
+};
+
+template <int In, typename L, typename... Rest>
+struct Stack<In, L, Rest...> {
+    typedef Stack<L::outputs, Rest...> Tail;
+    static const int inputs = In;
+    static const int outputs = Tail::outputs;
+    static const size_t depth = Tail::depth + 1;
+
+    DenseStage<In, L::outputs, typename L::activation> head;
+    Tail tail;
+
+    const double* forward(const double* x) {
+        head.forward(x);
+        return tail.forward(head.output);
+    }
+
+    template <bool Propagate>
+    const double* backward(const double* d_output) {
+        const double* d_head_output = tail.template backward<true>(d_output);
+        return head.template backward<Propagate>(d_head_output);
+    }
+
+    void initialize() { head.initialize(); tail.initialize(); }
+    void zero_deltas() { head.zero_deltas(); tail.zero_deltas(); }
+    void update(double scale) { head.update(scale); tail.update(scale); }
+
+    void load_from(const std::vector<Layer>& layers, size_t index) {
+        const Layer& layer = layers[index];
+        if (layer.activationName != L::activation::name()) {
+            throw std::invalid_argument("StaticNetwork: Activation mismatch in layer " + std::to_string(index) +
+                                        ": expected " + L::activation::name() + ", got " + layer.activationName);
+        }
+        copy_from_matrix(layer.weights, head.weights, L::outputs, In, "weights of layer " + std::to_string(index));
+        copy_from_matrix(layer.biases, head.biases, L::outputs, 1, "biases of layer " + std::to_string(index));
+        tail.load_from(layers, index + 1);
+    }
+
+    void store_to(ParameterSnapshot& snapshot, size_t index) const {
+        snapshot.weights[index] = copy_to_matrix(head.weights, L::outputs, In);
+        snapshot.biases[index] = copy_to_matrix(head.biases, L::outputs, 1);
+        tail.store_to(snapshot, index + 1);
+    }
+};
+
+} // namespace static_network_detail
+
+template <int Inputs, typename... Layers>
+class StaticNetwork {
+    typedef static_network_detail::Stack<Inputs, Layers...> StackType;
+
+public:
+    static const int inputs = Inputs;
+    static const int outputs = StackType::outputs;
+    static const size_t depth = StackType::depth;
+
+    typedef std::array<double, Inputs> InputArray;
+    typedef std::array<double, StackType::outputs> OutputArray;
+
+    // Over-aligned members are only honoured by plain new since C++17.
+    static void* operator new(size_t size) { return static_network_detail::aligned_allocate(size); }
+    static void operator delete(void* p) { static_network_detail::aligned_release(p); }
+
+    StaticNetwork() {
+        stack.initialize();
+        stack.zero_deltas();
+    }
+
+    void predict(const double* input, double* output) {
+        const double* result = stack.forward(input);
+        std::memcpy(output, result, sizeof(double) * outputs);
+    }
+
+    OutputArray predict(const InputArray& input) {
+        OutputArray output;
+        predict(input.data(), output.data());
+        return output;
+    }
+
+    Matrix predict(const Matrix& input) {
+        if (input.getRow() != Inputs || input.getCol() != 1) {
+            throw std::invalid_argument("StaticNetwork::predict: Expected " + std::to_string(Inputs) + "x1 input, got " +
+                                        std::to_string(input.getRow()) + "x" + std::to_string(input.getCol()));
+        }
+        alignas(64) double x[Inputs];
+        static_network_detail::copy_from_matrix(input, x, Inputs, 1, "input");
+        Matrix output(outputs, 1, 0.0);
+        predict(x, output.get_host_ptr());
+        return output;
+    }
+
+    double train_sample(const double* input, const double* target) {
+        const double* predicted = stack.forward(input);
+        alignas(64) double d_output[outputs];
+        double sum_sq_error = 0.0;
+        double scale = 2.0 / static_cast<double>(outputs);
+        for (int o = 0; o < outputs; ++o) {
+            double diff = predicted[o] - target[o];
+            sum_sq_error += diff * diff;
+            d_output[o] = diff * scale;
+        }
+        stack.template backward<false>(d_output);
+        return sum_sq_error / static_cast<double>(outputs);
+    }
+
+    void zero_deltas() { stack.zero_deltas(); }
+
+    void apply_update(double learning_rate, int batch_size) {
+        if (batch_size <= 0) {
+            throw std::invalid_argument("Batch size must be positive for updating parameters.");
+        }
+        stack.update(learning_rate / static_cast<double>(batch_size));
+        stack.zero_deltas();
+    }
+
+    double train_on_batch(const std::vector<Matrix>& batch_inputs,
+                          const std::vector<Matrix>& batch_targets,
+                          double learning_rate) {
+        if (batch_inputs.empty() || batch_targets.empty()) {
+            throw std::invalid_argument("Batch inputs or targets cannot be empty.");
+        }
+        if (batch_inputs.size() != batch_targets.size()) {
+            throw std::invalid_argument("Batch inputs and targets size mismatch.");
+        }
+        alignas(64) double x[Inputs];
+        alignas(64) double t[outputs];
+        double total_batch_loss = 0.0;
+        stack.zero_deltas();
+        for (size_t i = 0; i < batch_inputs.size(); ++i) {
+            static_network_detail::copy_from_matrix(batch_inputs[i], x, Inputs, 1, "input");
+            static_network_detail::copy_from_matrix(batch_targets[i], t, outputs, 1, "target");
+            total_batch_loss += train_sample(x, t);
+        }
+        apply_update(learning_rate, static_cast<int>(batch_inputs.size()));
+        return total_batch_loss / static_cast<double>(batch_inputs.size());
+    }
+
+    void load_from(const Network& net) {
+        const std::vector<Layer>& layers = net.getLayers();
+        if (!net.getFeatureLayers().empty()) {
+            throw std::invalid_argument("StaticNetwork::load_from: Networks with convolution/pooling layers are not supported.");
+        }
+        if (layers.size() != depth) {
+            throw std::invalid_argument("StaticNetwork::load_from: Network has " + std::to_string(layers.size()) +
+                                        " layers, expected " + std::to_string(depth));
+        }
+        stack.load_from(layers, 0);
+    }
+
+    void store_to(Network& net) const {
+        ParameterSnapshot snapshot;
+        snapshot.weights.resize(depth);
+        snapshot.biases.resize(depth);
+        stack.store_to(snapshot, 0);
+        net.restore_parameters(snapshot);
+    }
+
+private:
+    StackType stack;
+};
+
+#endif
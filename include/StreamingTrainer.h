@@ -0,0 +1,99 @@
+#ifndef STREAMINGTRAINER_H
+#define STREAMINGTRAINER_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+#include <random>
+#include <functional>
+#include "Network.h"
+#include "SampleSource.h"
+
+struct StreamingConfig {
+    int batch_size;
+    double learning_rate;
+    // Samples held for shuffling; 0 trains in arrival order. Each incoming
+    // sample replaces a uniformly chosen slot, whose old sample is emitted.
+    int shuffle_buffer;
+    // Samples read ahead of training by the prefetch thread.
+    int prefetch;
+    // Stop after this many samples; 0 trains until the source ends or stop().
+    long long max_samples;
+    // Call on_report every this many batches; 0 disables reports.
+    int report_every;
+    unsigned int seed;
+
+    StreamingConfig()
+        : batch_size(16), learning_rate(0.1), shuffle_buffer(0), prefetch(1024),
+          max_samples(0), report_every(100), seed(42) {}
+};
+
+struct StreamingStats {
+    long long samples;
+    long long batches;
+    double window_loss;      // mean batch loss since the previous report
+    double seconds;
+    double wait_seconds;     // time training waited on the source
+    double samples_per_second() const { return seconds > 0.0 ? samples / seconds : 0.0; }
+    std::string to_string() const;
+
+    StreamingStats() : samples(0), batches(0), window_loss(0.0), seconds(0.0), wait_seconds(0.0) {}
+};
+
+// Trains a Network from a SampleSource of unbounded length with memory bounded
+// by prefetch + shuffle_buffer + batch_size samples. A prefetch thread parses
+// samples while the calling thread trains, so when the source keeps up the
+// loop runs at the speed of Network::train_on_batch on in-memory data. Errors
+// thrown by the source are rethrown from run(). A source blocked inside next()
+// (e.g. an idle pipe) delays the end of run() until it returns.
+class StreamingTrainer {
+public:
+    typedef std::function<void(const StreamingStats&)> Reporter;
+
+    StreamingTrainer(Network& net, SampleSource& source, const StreamingConfig& config = StreamingConfig());
+    ~StreamingTrainer();
+
+    StreamingTrainer(const StreamingTrainer&) = delete;
+    StreamingTrainer& operator=(const StreamingTrainer&) = delete;
+
+    // Trains until the source ends, max_samples is reached or stop() is
+    // called; the last partial batch is trained too. Returns the totals.
+    StreamingStats run(const Reporter& on_report = Reporter());
+
+    // Safe to call from any thread, including on_report.
+    void stop();
+
+private:
+    struct Sample {
+        Matrix input;
+        Matrix target;
+    };
+
+    void prefetch_loop();
+    bool pop(Sample& sample, double& waited);
+    bool next_shuffled(Sample& sample, double& waited);
+    void join_prefetch();
+
+    Network& net;
+    SampleSource& source;
+    StreamingConfig config;
+
+    std::thread prefetcher;
+    std::mutex mutex;
+    std::condition_variable ready_cv;
+    std::condition_variable space_cv;
+    std::deque<Sample> queue;
+    bool source_done;
+    std::exception_ptr source_error;
+    std::atomic<bool> stop_requested;
+
+    std::vector<Sample> shuffle;
+    std::mt19937 rng;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef SWEEPRUNNER_H
+#define SWEEPRUNNER_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "Network.h"
+#include "ThreadPool.h"
+#include "WeightInitializer.h"
+
+struct TrialConfig {
+    std::vector<int> layer_sizes;
+    std::vector<std::string> activations;
+    double learning_rate;
+    int batch_size;
+    int epochs;
+    uint64_t seed;      // weights (WeightInitializer) and the per-epoch shuffle
+    WeightInit init;
+
+    TrialConfig() : learning_rate(0.01), batch_size(32), epochs(10), seed(1) {}
+    std::string layers_to_string() const;   // "784-100-10"
+};
+
+// Successive halving: when every surviving trial has trained first_rung epochs,
+// only the best 1/reduction of them (by best validation accuracy so far, ties
+// to the lower index) go on; the next cut is at first_rung * reduction epochs,
+// and so on. A cut waits for all survivors to reach it, so which trials are
+// stopped depends only on their results, not on timing or thread count.
+struct EarlyStopping {
+    int first_rung;     // 0 disables the cuts
+    int reduction;
+    int min_survivors;
+    int patience;       // > 0: also stop a trial after this many epochs without a new best
+
+    EarlyStopping() : first_rung(1), reduction(3), min_survivors(1), patience(0) {}
+};
+
+enum class TrialStatus { Pending, Running, Completed, Stopped, Failed };
+
+struct TrialResult {
+    int index;
+    TrialConfig config;
+    TrialStatus status;
+    std::string note;                           // why the trial stopped or failed
+    std::vector<double> train_loss;             // per epoch, mean over samples
+    std::vector<double> validation_loss;
+    std::vector<double> validation_accuracy;
+    int best_epoch;                             // -1 before the first epoch
+    double seconds;                             // training and validation time of this trial
+
+    TrialResult() : index(0), status(TrialStatus::Pending), best_epoch(-1), seconds(0.0) {}
+    int epochs_run() const { return static_cast<int>(train_loss.size()); }
+    double best_accuracy() const { return best_epoch >= 0 ? validation_accuracy[static_cast<size_t>(best_epoch)] : 0.0; }
+};
+
+std::string to_string(TrialStatus status);
+
+// Trains independent network configurations concurrently on one in-memory
+// dataset. The training and validation sets are referenced, not copied, and
+// only read, so every trial shares them and must not outlive them. Each trial
+// owns its network, built on first use with WeightInitializer(seed), and its
+// shuffle. Pool workers take one epoch of one trial at a time, least-trained
+// trial first, so all trials advance at the same rate and a worker freed by a
+// stopped trial moves on to the others. A trial's results do not depend on
+// the thread count; only the sweep's wall time does.
+class SweepRunner {
+public:
+    // Called after each epoch of a trial and when a cut stops it, one call at a time.
+    typedef std::function<void(const TrialResult&)> Callback;
+
+    SweepRunner(const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets,
+                const std::vector<Matrix>& validation_inputs, const std::vector<Matrix>& validation_targets);
+    SweepRunner(const SparseMatrix& inputs, const std::vector<Matrix>& targets,
+                const std::vector<Matrix>& validation_inputs, const std::vector<Matrix>& validation_targets);
+    ~SweepRunner();
+
+    SweepRunner(const SweepRunner&) = delete;
+    SweepRunner& operator=(const SweepRunner&) = delete;
+
+    // Runs every trial to completion or until it is stopped; results are in
+    // trial order. A trial that throws is marked Failed and the others go on.
+    std::vector<TrialResult> run(const std::vector<TrialConfig>& configs, ThreadPool& pool,
+                                 const EarlyStopping& early_stopping = EarlyStopping(), const Callback& callback = Callback());
+
+    // Results ranked by best validation accuracy, one line per trial.
+    static std::string format_table(const std::vector<TrialResult>& results);
+    static void write_csv(const std::string& path, const std::vector<TrialResult>& results);
+
+private:
+    struct Trial;
+
+    void validate(const TrialConfig& config) const;
+    void worker_loop();
+    Trial* next_trial();
+    bool all_done() const;
+    bool rung_reached() const;
+    void train_epoch(Trial& trial, double& train_loss, double& validation_loss, double& validation_accuracy);
+    void finish_epoch(Trial& trial, double train_loss, double validation_loss, double validation_accuracy,
+                      std::vector<TrialResult>& updates);
+    void resolve_rung(std::vector<TrialResult>& updates);
+    void report(const std::vector<TrialResult>& updates);
+
+    const std::vector<Matrix>* inputs;
+    const SparseMatrix* sparse_inputs;
+    const std::vector<Matrix>& targets;
+    const std::vector<Matrix>& validation_inputs;
+    const std::vector<Matrix>& validation_targets;
+    size_t sample_count;
+
+    EarlyStopping stopping;
+    Callback on_update;
+    std::vector<std::unique_ptr<Trial> > trials;
+    long long next_rung;        // epoch of the next cut; 0 when there is none
+    int running;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::mutex callback_mutex;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include "NumaTopology.h"
+
+enum class AffinityPolicy {
+    None,       // threads float; the scheduler decides
+    Compact,    // fill the CPUs of one NUMA node before moving to the next
+    Scatter     // round-robin workers across NUMA nodes
+};
+
+// Fixed set of worker threads, each pinned to one CPU per the policy. run()
+// executes a task on every worker and returns when all have finished, so work
+// that must happen on a given node (first-touch initialization, per-replica
+// compute) is simply done inside the task.
+class ThreadPool {
+public:
+    explicit ThreadPool(int num_threads, AffinityPolicy policy = AffinityPolicy::Scatter,
+                        const NumaTopology& topology = NumaTopology::system());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers.size()); }
+    AffinityPolicy policy() const { return affinity; }
+    // CPU and topology node index each worker is pinned to; -1 with AffinityPolicy::None.
+    int cpu_of(int worker) const { return worker_cpus[static_cast<size_t>(worker)]; }
+    int node_of(int worker) const { return worker_nodes[static_cast<size_t>(worker)]; }
+
+    // Runs task(worker_index) on every worker. The first exception thrown by a
+    // task is rethrown here after all workers are done.
+    void run(const std::function<void(int)>& task);
+
+private:
+    void worker_loop(int index);
+
+    AffinityPolicy affinity;
+    std::vector<int> worker_cpus;
+    std::vector<int> worker_nodes;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::condition_variable done_cv;
+    const std::function<void(int)>* current_task;
+    unsigned long long generation;
+    int remaining;
+    bool stop_requested;
+    std::exception_ptr first_error;
+};
+
+#endif
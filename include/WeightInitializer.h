@@ -0,0 +1,54 @@
+#ifndef WEIGHTINITIALIZER_H
+#define WEIGHTINITIALIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class InitScheme {
+    Uniform,        // U[a, b)
+    Normal,         // N(a, b^2): mean a, standard deviation b
+    XavierUniform,  // U[-sqrt(6 / (fan_in + fan_out)), +...)
+    XavierNormal,   // N(0, 2 / (fan_in + fan_out))
+    HeUniform,      // U[-sqrt(6 / fan_in), +...)
+    HeNormal        // N(0, 2 / fan_in)
+};
+
+struct WeightInit {
+    InitScheme scheme;
+    double a;
+    double b;
+
+    WeightInit(InitScheme s = InitScheme::XavierUniform, double _a = 0.0, double _b = 0.0) : scheme(s), a(_a), b(_b) {}
+
+    // "xavier_uniform", "xavier_normal", "he_uniform", "he_normal",
+    // "uniform:A,B" or "normal:MEAN,STDDEV"; throws std::invalid_argument otherwise.
+    static WeightInit parse(const std::string& spec);
+    std::string to_string() const;
+};
+
+// Counter-based weight initialization with Philox4x32-10. Element pair
+// (2j, 2j + 1) of a tensor is computed from the counter (j, stream) under the
+// seed key alone, so the values do not depend on how the tensor is split
+// across threads, on construction order or on any global RNG state. Different
+// tensors drawn from one seed use different streams.
+class WeightInitializer {
+public:
+    // threads 0 uses std::thread::hardware_concurrency().
+    explicit WeightInitializer(uint64_t seed, int threads = 0);
+
+    uint64_t seed() const { return key; }
+    int threads() const { return thread_count; }
+
+    // Fills data[0, n) per init for a layer with the given fan-in and fan-out.
+    void fill(double* data, size_t n, const WeightInit& init, int fan_in, int fan_out, uint64_t stream) const;
+
+    // One Philox4x32-10 block: counter in, random words out (in place).
+    static void philox4x32_10(uint32_t counter[4], uint32_t key0, uint32_t key1);
+
+private:
+    uint64_t key;
+    int thread_count;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "Activations.h"
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+
+namespace activations {
+
+namespace {
+
+std::atomic<int> activation_precision(static_cast<int>(ActivationPrecision::Exact));
+
+const double INV_SQRT_2 = 0.70710678118654752440;
+const double INV_SQRT_2PI = 0.39894228040143267794;
+const double TWO_SQRT_2_OVER_PI = 1.5957691216057308;
+const double GELU_CUBIC = 0.044715;
+
+// Each kernel is instantiated per precision so the inner loop has no branch on it.
+template <bool Fast>
+inline double exp_of(double x) { return Fast ? fast_exp(x) : std::exp(x); }
+
+template <bool Fast>
+void apply_kernel(ActivationKind kind, const double* z, double* out, size_t n) {
+    switch (kind) {
+        case ActivationKind::ReLU:
+            for (size_t i = 0; i < n; ++i) out[i] = z[i] > 0 ? z[i] : 0.0;
+            break;
+        case ActivationKind::Sigmoid:
+            for (size_t i = 0; i < n; ++i) out[i] = 1.0 / (1.0 + exp_of<Fast>(-z[i]));
+            break;
+        case ActivationKind::Tanh:
+            if (Fast) {
+                for (size_t i = 0; i < n; ++i) out[i] = fast_tanh(z[i]);
+            } else {
+                for (size_t i = 0; i < n; ++i) out[i] = std::tanh(z[i]);
+            }
+            break;
+        case ActivationKind::GELU:
+            if (Fast) {
+                for (size_t i = 0; i < n; ++i) out[i] = fast_gelu(z[i]);
+            } else {
+                for (size_t i = 0; i < n; ++i) out[i] = 0.5 * z[i] * (1.0 + std::erf(z[i] * INV_SQRT_2));
+            }
+            break;
+        case ActivationKind::Linear:
+            if (out != z) std::memcpy(out, z, n * sizeof(double));
+            break;
+    }
+}
+
+template <bool Fast>
+inline double gelu_prime(double x) {
+    if (Fast) {
+        // Derivative of fast_gelu, so training differentiates the function it evaluates.
+        double x2 = x * x;
+        double s = fast_sigmoid(TWO_SQRT_2_OVER_PI * (x + GELU_CUBIC * x2 * x));
+        return s + x * s * (1.0 - s) * TWO_SQRT_2_OVER_PI * (1.0 + 3.0 * GELU_CUBIC * x2);
+    }
+    return 0.5 * (1.0 + std::erf(x * INV_SQRT_2)) + x * INV_SQRT_2PI * std::exp(-0.5 * x * x);
+}
+
+template <bool Fast>
+void gradient_from_input_kernel(ActivationKind kind, const double* z, const double* grad, double* d_z, size_t n) {
+    switch (kind) {
+        case ActivationKind::ReLU:
+            for (size_t i = 0; i < n; ++i) d_z[i] = z[i] <= 0 ? 0.0 : grad[i];
+            break;
+        case ActivationKind::Sigmoid:
+            for (size_t i = 0; i < n; ++i) {
+                double s = 1.0 / (1.0 + exp_of<Fast>(-z[i]));
+                d_z[i] = grad[i] * (s * (1.0 - s));
+            }
+            break;
+        case ActivationKind::Tanh:
+            for (size_t i = 0; i < n; ++i) {
+                double t = Fast ? fast_tanh(z[i]) : std::tanh(z[i]);
+                d_z[i] = grad[i] * (1.0 - t * t);
+            }
+            break;
+        case ActivationKind::GELU:
+            for (size_t i = 0; i < n; ++i) d_z[i] = grad[i] * gelu_prime<Fast>(z[i]);
+            break;
+        case ActivationKind::Linear:
+            if (d_z != grad) std::memcpy(d_z, grad, n * sizeof(double));
+            break;
+    }
+}
+
+} // namespace
+
+void setPrecision(ActivationPrecision precision) {
+    activation_precision.store(static_cast<int>(precision));
+}
+
+ActivationPrecision getPrecision() {
+    return static_cast<ActivationPrecision>(activation_precision.load());
+}
+
+ActivationKind parse(const std::string& name) {
+    if (name == "relu") return ActivationKind::ReLU;
+    if (name == "sigmoid") return ActivationKind::Sigmoid;
+    if (name == "tanh") return ActivationKind::Tanh;
+    if (name == "gelu") return ActivationKind::GELU;
+    if (name == "linear") return ActivationKind::Linear;
+    throw std::invalid_argument("Unsupported activation function: " + name);
+}
+
+const char* name(ActivationKind kind) {
+    switch (kind) {
+        case ActivationKind::ReLU: return "relu";
+        case ActivationKind::Sigmoid: return "sigmoid";
+        case ActivationKind::Tanh: return "tanh";
+        case ActivationKind::GELU: return "gelu";
+        default: return "linear";
+    }
+}
+
+bool derivative_from_output(ActivationKind kind) {
+    return kind != ActivationKind::GELU;
+}
+
+bool zero_output_blocks_gradient(ActivationKind kind) {
+    return kind == ActivationKind::ReLU;
+}
+
+void apply(ActivationKind kind, const double* z, double* out, size_t n) {
+    if (getPrecision() == ActivationPrecision::Fast) {
+        apply_kernel<true>(kind, z, out, n);
+    } else {
+        apply_kernel<false>(kind, z, out, n);
+    }
+}
+
+void derivative(ActivationKind kind, const double* z, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = 1.0;
+    gradient_from_input(kind, z, out, out, n);
+}
+
+void gradient_from_input(ActivationKind kind, const double* z, const double* grad, double* d_z, size_t n) {
+    if (getPrecision() == ActivationPrecision::Fast) {
+        gradient_from_input_kernel<true>(kind, z, grad, d_z, n);
+    } else {
+        gradient_from_input_kernel<false>(kind, z, grad, d_z, n);
+    }
+}
+
+void gradient_from_output(ActivationKind kind, const double* a, const double* grad, double* d_z, size_t n) {
+    switch (kind) {
+        case ActivationKind::ReLU:
+            for (size_t i = 0; i < n; ++i) d_z[i] = a[i] > 0 ? grad[i] : 0.0;
+            break;
+        case ActivationKind::Sigmoid:
+            for (size_t i = 0; i < n; ++i) d_z[i] = grad[i] * (a[i] * (1.0 - a[i]));
+            break;
+        case ActivationKind::Tanh:
+            for (size_t i = 0; i < n; ++i) d_z[i] = grad[i] * (1.0 - a[i] * a[i]);
+            break;
+        case ActivationKind::Linear:
+            if (d_z != grad) std::memcpy(d_z, grad, n * sizeof(double));
+            break;
+        case ActivationKind::GELU:
+            throw std::invalid_argument("activations::gradient_from_output: GELU derivative needs the pre-activation.");
+    }
+}
+
+} // namespace activations
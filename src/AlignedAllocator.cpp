@@ -0,0 +1,87 @@
+#include "AlignedAllocator.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <sys/mman.h>
+
+namespace {
+
+// Every block carries a 64-byte header in front of the returned pointer so
+// deallocate() knows how the block was obtained.
+enum class BlockKind : uint32_t { Heap = 1, Mapped = 2 };
+
+struct BlockHeader {
+    BlockKind kind;
+    void* base;
+    size_t mapped_bytes;
+};
+
+static_assert(sizeof(BlockHeader) <= aligned_memory::ALIGNMENT, "BlockHeader must fit in the alignment padding.");
+
+std::atomic<int> huge_page_policy(static_cast<int>(HugePagePolicy::Transparent));
+
+void* finish_block(void* base, BlockKind kind, size_t mapped_bytes) {
+    char* data = static_cast<char*>(base) + aligned_memory::ALIGNMENT;
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(data - sizeof(BlockHeader));
+    header->kind = kind;
+    header->base = base;
+    header->mapped_bytes = mapped_bytes;
+    return data;
+}
+
+void* allocate_heap(size_t total, size_t alignment) {
+    void* base = nullptr;
+    if (posix_memalign(&base, alignment, total) != 0) {
+        throw std::bad_alloc();
+    }
+    return base;
+}
+
+} // namespace
+
+namespace aligned_memory {
+
+void setHugePagePolicy(HugePagePolicy policy) {
+    huge_page_policy.store(static_cast<int>(policy));
+}
+
+HugePagePolicy getHugePagePolicy() {
+    return static_cast<HugePagePolicy>(huge_page_policy.load());
+}
+
+void* allocate(size_t bytes) {
+    size_t total = bytes + ALIGNMENT;
+    HugePagePolicy policy = getHugePagePolicy();
+
+    if (policy == HugePagePolicy::None || total < HUGE_PAGE_SIZE) {
+        return finish_block(allocate_heap(total, ALIGNMENT), BlockKind::Heap, 0);
+    }
+
+    size_t rounded = ((total + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+    if (policy == HugePagePolicy::Explicit) {
+        void* base = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) {
+            return finish_block(base, BlockKind::Mapped, rounded);
+        }
+    }
+#endif
+
+    void* base = allocate_heap(rounded, HUGE_PAGE_SIZE);
+#ifdef MADV_HUGEPAGE
+    madvise(base, rounded, MADV_HUGEPAGE);
+#endif
+    return finish_block(base, BlockKind::Heap, 0);
+}
+
+void deallocate(void* p) noexcept {
+    if (p == nullptr) return;
+    const BlockHeader* header = reinterpret_cast<const BlockHeader*>(static_cast<char*>(p) - sizeof(BlockHeader));
+    if (header->kind == BlockKind::Mapped) {
+        munmap(header->base, header->mapped_bytes);
+    } else {
+        std::free(header->base);
+    }
+}
+
+} // namespace aligned_memory
@@ -0,0 +1,253 @@
+#include "BackgroundEvaluator.h"
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int argmax(const Matrix& m) {
+    int best = 0;
+    for (int i = 1; i < m.getRow(); ++i) {
+        if (m.getEntry(i, 0) > m.getEntry(best, 0)) best = i;
+    }
+    return best;
+}
+
+} // namespace
+
+struct BackgroundEvaluator::Job {
+    ParameterSnapshot params;
+    int epoch;
+    long long step;
+    Clock::time_point submitted;
+
+    std::once_flag replica_once;
+    std::unique_ptr<Network> replica;
+
+    size_t chunks;
+    size_t next_chunk;
+    size_t chunks_done;
+    std::vector<double> chunk_loss;     // summed in chunk order, so the loss is deterministic
+    long long correct;
+    std::vector<long long> confusion;
+    bool failed;
+};
+
+std::string EvaluationResult::confusion_to_string() const {
+    std::ostringstream out;
+    out << "actual\\pred";
+    for (int p = 0; p < classes; ++p) out << std::setw(7) << p;
+    out << "\n";
+    for (int a = 0; a < classes; ++a) {
+        out << std::setw(11) << a;
+        for (int p = 0; p < classes; ++p) out << std::setw(7) << confusion_at(a, p);
+        out << "\n";
+    }
+    return out.str();
+}
+
+BackgroundEvaluator::BackgroundEvaluator(const Network& _model, const std::vector<Matrix>& _inputs,
+                                         const std::vector<Matrix>& _targets, int threads, int _max_pending,
+                                         const Callback& _on_result)
+    : model(_model), inputs(_inputs), targets(_targets), max_pending(_max_pending), on_result(_on_result),
+      classes(0), chunk_size(256), stop_requested(false) {
+    if (threads <= 0 || max_pending <= 0) {
+        throw std::invalid_argument("BackgroundEvaluator: threads and max_pending must be positive.");
+    }
+    if (inputs.size() != targets.size()) {
+        throw std::invalid_argument("BackgroundEvaluator: " + std::to_string(inputs.size()) + " inputs but " +
+                                    std::to_string(targets.size()) + " targets.");
+    }
+    if (model.getLayers().empty()) {
+        throw std::invalid_argument("BackgroundEvaluator: Network has no dense layers.");
+    }
+    classes = model.getLayers().back().weights.getRow();
+    for (int t = 0; t < threads; ++t) {
+        workers.push_back(std::thread(&BackgroundEvaluator::worker_loop, this));
+    }
+}
+
+BackgroundEvaluator::~BackgroundEvaluator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_requested = true;
+    }
+    work_cv.notify_all();
+    done_cv.notify_all();
+    for (std::thread& t : workers) t.join();
+}
+
+void BackgroundEvaluator::submit(const Network& net, int epoch, long long step) {
+    std::shared_ptr<Job> job(new Job());
+    net.snapshot_parameters(job->params);
+    job->epoch = epoch;
+    job->step = step;
+    job->submitted = Clock::now();
+    job->chunks = (inputs.size() + chunk_size - 1) / chunk_size;
+    job->next_chunk = 0;
+    job->chunks_done = 0;
+    job->chunk_loss.assign(job->chunks, 0.0);
+    job->correct = 0;
+    job->confusion.assign(static_cast<size_t>(classes) * classes, 0);
+    job->failed = false;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [this] { return stop_requested || jobs.size() < static_cast<size_t>(max_pending); });
+        if (stop_requested) return;
+        jobs.push_back(job);
+        if (job->chunks > 0) {
+            work_cv.notify_all();
+            return;
+        }
+        // An empty test set leaves nothing for the workers to claim.
+        publish_finished();
+    }
+    deliver();
+}
+
+// Caller holds mutex. Moves finished jobs at the front of the queue to the
+// undelivered results, so results leave in submission order.
+void BackgroundEvaluator::publish_finished() {
+    while (!jobs.empty() && jobs.front()->chunks_done == jobs.front()->chunks) {
+        std::shared_ptr<Job> job = jobs.front();
+        jobs.pop_front();
+        if (!job->failed) {
+            EvaluationResult result;
+            result.epoch = job->epoch;
+            result.step = job->step;
+            result.samples = static_cast<long long>(inputs.size());
+            result.correct = job->correct;
+            double loss = 0.0;
+            for (double l : job->chunk_loss) loss += l;
+            result.loss = inputs.empty() ? 0.0 : loss / inputs.size();
+            result.classes = classes;
+            result.confusion.swap(job->confusion);
+            result.seconds = std::chrono::duration<double>(Clock::now() - job->submitted).count();
+            undelivered.push_back(result);
+        }
+    }
+    done_cv.notify_all();
+}
+
+// Hands undelivered results to on_result, or to the completed list. Holding
+// callback_mutex while taking them keeps callbacks in order across workers.
+void BackgroundEvaluator::deliver() {
+    std::lock_guard<std::mutex> callback_lock(callback_mutex);
+    std::deque<EvaluationResult> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.swap(undelivered);
+        if (!on_result) {
+            completed.insert(completed.end(), ready.begin(), ready.end());
+            return;
+        }
+    }
+    for (const EvaluationResult& result : ready) on_result(result);
+}
+
+void BackgroundEvaluator::worker_loop() {
+    for (;;) {
+        std::shared_ptr<Job> job;
+        size_t chunk = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                if (stop_requested) return;
+                for (const std::shared_ptr<Job>& candidate : jobs) {
+                    if (candidate->next_chunk < candidate->chunks) {
+                        job = candidate;
+                        break;
+                    }
+                }
+                if (job) break;
+                work_cv.wait(lock);
+            }
+            chunk = job->next_chunk++;
+        }
+
+        double loss = 0.0;
+        long long correct = 0;
+        std::vector<long long> confusion(static_cast<size_t>(classes) * classes, 0);
+        std::string failure;
+        try {
+            std::call_once(job->replica_once, [this, &job] {
+                job->replica.reset(new Network(model));
+                job->replica->restore_parameters(job->params);
+            });
+            size_t begin = chunk * chunk_size;
+            size_t end = std::min(begin + chunk_size, inputs.size());
+            evaluate_range(*job->replica, inputs, targets, begin, end, loss, correct, confusion);
+        } catch (const std::exception& e) {
+            failure = e.what();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure.empty()) {
+                job->failed = true;
+                if (error.empty()) error = "BackgroundEvaluator: Epoch " + std::to_string(job->epoch) + ": " + failure;
+            }
+            job->chunk_loss[chunk] = loss;
+            job->correct += correct;
+            for (size_t i = 0; i < confusion.size(); ++i) job->confusion[i] += confusion[i];
+            if (++job->chunks_done < job->chunks) continue;
+            job->replica.reset();
+            publish_finished();
+        }
+        deliver();
+    }
+}
+
+std::vector<EvaluationResult> BackgroundEvaluator::take_completed() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<EvaluationResult> results;
+    results.swap(completed);
+    return results;
+}
+
+void BackgroundEvaluator::wait() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [this] { return stop_requested || jobs.empty(); });
+    }
+    deliver();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!error.empty()) {
+        std::string message;
+        message.swap(error);
+        throw std::runtime_error(message);
+    }
+}
+
+void BackgroundEvaluator::evaluate_range(const Network& net, const std::vector<Matrix>& inputs,
+                                         const std::vector<Matrix>& targets, size_t begin, size_t end,
+                                         double& loss, long long& correct, std::vector<long long>& confusion) {
+    int classes = net.getLayers().back().weights.getRow();
+    for (size_t k = begin; k < end; ++k) {
+        Matrix prediction = net.infer(inputs[k].view());
+        loss += net.meanSquaredError(prediction, targets[k]);
+        int actual = argmax(targets[k]);
+        int predicted = argmax(prediction);
+        if (actual == predicted) ++correct;
+        confusion[static_cast<size_t>(actual) * classes + predicted]++;
+    }
+}
+
+EvaluationResult BackgroundEvaluator::evaluate(const Network& net, const std::vector<Matrix>& inputs,
+                                               const std::vector<Matrix>& targets) {
+    Clock::time_point start = Clock::now();
+    EvaluationResult result;
+    result.classes = net.getLayers().back().weights.getRow();
+    result.confusion.assign(static_cast<size_t>(result.classes) * result.classes, 0);
+    result.samples = static_cast<long long>(inputs.size());
+    double loss = 0.0;
+    evaluate_range(net, inputs, targets, 0, inputs.size(), loss, result.correct, result.confusion);
+    result.loss = inputs.empty() ? 0.0 : loss / inputs.size();
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
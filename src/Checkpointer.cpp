@@ -0,0 +1,299 @@
+#include "Checkpointer.h"
+#include <stdexcept>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char CHECKPOINT_MAGIC[8] = {'N', 'N', 'C', 'K', 'P', 'T', '0', '1'};
+
+uint64_t fnv1a(uint64_t hash, const char* data, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+template <typename T>
+void put(std::vector<char>& out, const T& value) {
+    const char* p = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+void put_matrix(std::vector<char>& out, const Matrix& m) {
+    Matrix temp_host;
+    const Matrix* src = &m;
+    if (m.is_on_device() && m.get_device_ptr()) { temp_host = m; temp_host.to_host(); src = &temp_host; }
+
+    put<int32_t>(out, src->getRow());
+    put<int32_t>(out, src->getCol());
+    size_t count = static_cast<size_t>(src->getRow()) * src->getCol();
+    if (count > 0) {
+        const char* p = reinterpret_cast<const char*>(src->get_host_ptr());
+        out.insert(out.end(), p, p + count * sizeof(double));
+    }
+}
+
+class Reader {
+public:
+    Reader(const std::vector<char>& data, const std::string& path) : data(data), pos(0), path(path) {}
+
+    template <typename T>
+    T get() {
+        T value;
+        get_bytes(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+
+    void get_bytes(char* dst, size_t n) {
+        if (pos + n > data.size()) {
+            throw std::runtime_error("Checkpointer: Truncated checkpoint file: " + path);
+        }
+        std::memcpy(dst, data.data() + pos, n);
+        pos += n;
+    }
+
+    Matrix get_matrix() {
+        int32_t r = get<int32_t>();
+        int32_t c = get<int32_t>();
+        if (r < 0 || c < 0) {
+            throw std::runtime_error("Checkpointer: Invalid matrix shape in checkpoint file: " + path);
+        }
+        Matrix m(r, c, 0.0);
+        size_t count = static_cast<size_t>(r) * c;
+        if (count > 0) {
+            get_bytes(reinterpret_cast<char*>(m.get_host_ptr()), count * sizeof(double));
+        }
+        return m;
+    }
+
+private:
+    const std::vector<char>& data;
+    size_t pos;
+    std::string path;
+};
+
+void write_all(int fd, const char* data, size_t n, const std::string& path) {
+    while (n > 0) {
+        ssize_t written = ::write(fd, data, n);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Checkpointer: Write failed for " + path + ": " + std::strerror(errno));
+        }
+        data += written;
+        n -= static_cast<size_t>(written);
+    }
+}
+
+void fsync_parent_directory(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+} // namespace
+
+Checkpointer::Checkpointer(const std::string& _path, long long _every_n_batches, double _every_seconds)
+    : path(_path),
+      every_n_batches(_every_n_batches),
+      every_seconds(_every_seconds),
+      batches_since_checkpoint(0),
+      last_checkpoint_time(std::chrono::steady_clock::now()),
+      has_pending(false),
+      writing(false),
+      stop_requested(false),
+      written_count(0)
+{
+    if (path.empty()) {
+        throw std::invalid_argument("Checkpointer: Checkpoint path cannot be empty.");
+    }
+    if (every_n_batches <= 0 && every_seconds <= 0.0) {
+        throw std::invalid_argument("Checkpointer: Either a batch interval or a time interval must be positive.");
+    }
+    writer = std::thread(&Checkpointer::writer_loop, this);
+}
+
+Checkpointer::~Checkpointer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_requested = true;
+    }
+    cv.notify_all();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+bool Checkpointer::maybe_checkpoint(const Network& net, const TrainingState& state) {
+    batches_since_checkpoint++;
+    bool due = every_n_batches > 0 && batches_since_checkpoint >= every_n_batches;
+    if (!due && every_seconds > 0.0) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - last_checkpoint_time;
+        due = elapsed.count() >= every_seconds;
+    }
+    if (!due) {
+        return false;
+    }
+    checkpoint(net, state);
+    return true;
+}
+
+void Checkpointer::checkpoint(const Network& net, const TrainingState& state) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        net.snapshot_parameters(pending_params);
+        pending_state = state;
+        has_pending = true;
+    }
+    cv.notify_all();
+    batches_since_checkpoint = 0;
+    last_checkpoint_time = std::chrono::steady_clock::now();
+}
+
+void Checkpointer::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return !has_pending && !writing; });
+}
+
+long long Checkpointer::checkpoints_written() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return written_count;
+}
+
+std::string Checkpointer::last_error() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return error_message;
+}
+
+void Checkpointer::writer_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        cv.wait(lock, [this] { return has_pending || stop_requested; });
+        if (!has_pending && stop_requested) {
+            break;
+        }
+
+        std::swap(pending_params, writing_params);
+        std::swap(pending_state, writing_state);
+        has_pending = false;
+        writing = true;
+        lock.unlock();
+
+        std::string error;
+        try {
+            save(path, writing_params, writing_state);
+        } catch (const std::exception& e) {
+            error = e.what();
+            std::cerr << "Warning: " << error << std::endl;
+        }
+
+        lock.lock();
+        writing = false;
+        if (error.empty()) {
+            written_count++;
+        } else {
+            error_message = error;
+        }
+        cv.notify_all();
+    }
+}
+
+void Checkpointer::save(const std::string& path, const ParameterSnapshot& params, const TrainingState& state) {
+    if (params.weights.size() != params.biases.size()) {
+        throw std::invalid_argument("Checkpointer::save: Snapshot weights and biases count mismatch.");
+    }
+
+    std::vector<char> buffer;
+    buffer.insert(buffer.end(), CHECKPOINT_MAGIC, CHECKPOINT_MAGIC + sizeof(CHECKPOINT_MAGIC));
+    put<int64_t>(buffer, state.step);
+    put<int32_t>(buffer, state.epoch);
+    put<int64_t>(buffer, state.next_sample);
+    put<double>(buffer, state.learning_rate);
+    put<uint32_t>(buffer, static_cast<uint32_t>(state.rng_state.size()));
+    buffer.insert(buffer.end(), state.rng_state.begin(), state.rng_state.end());
+    put<uint32_t>(buffer, static_cast<uint32_t>(params.weights.size()));
+    for (size_t i = 0; i < params.weights.size(); ++i) {
+        put_matrix(buffer, params.weights[i]);
+        put_matrix(buffer, params.biases[i]);
+    }
+    put<uint64_t>(buffer, fnv1a(14695981039346656037ULL, buffer.data(), buffer.size()));
+
+    std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Checkpointer: Cannot open " + tmp_path + ": " + std::strerror(errno));
+    }
+    try {
+        write_all(fd, buffer.data(), buffer.size(), tmp_path);
+        if (::fsync(fd) != 0) {
+            throw std::runtime_error("Checkpointer: fsync failed for " + tmp_path + ": " + std::strerror(errno));
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+
+    if (::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Checkpointer: Cannot rename " + tmp_path + " to " + path + ": " + std::strerror(errno));
+    }
+    fsync_parent_directory(path);
+}
+
+bool Checkpointer::load(const std::string& path, Network& net, TrainingState& state) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+        return false;
+    }
+    std::vector<char> buffer((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    if (buffer.size() < sizeof(CHECKPOINT_MAGIC) + sizeof(uint64_t) ||
+        std::memcmp(buffer.data(), CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+        throw std::runtime_error("Checkpointer: Not a checkpoint file: " + path);
+    }
+    size_t payload_size = buffer.size() - sizeof(uint64_t);
+    uint64_t stored_hash;
+    std::memcpy(&stored_hash, buffer.data() + payload_size, sizeof(uint64_t));
+    if (fnv1a(14695981039346656037ULL, buffer.data(), payload_size) != stored_hash) {
+        throw std::runtime_error("Checkpointer: Checksum mismatch in checkpoint file: " + path);
+    }
+    buffer.resize(payload_size);
+
+    Reader reader(buffer, path);
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    reader.get_bytes(magic, sizeof(magic));
+
+    TrainingState loaded;
+    loaded.step = reader.get<int64_t>();
+    loaded.epoch = reader.get<int32_t>();
+    loaded.next_sample = reader.get<int64_t>();
+    loaded.learning_rate = reader.get<double>();
+    uint32_t rng_size = reader.get<uint32_t>();
+    loaded.rng_state.resize(rng_size);
+    if (rng_size > 0) {
+        reader.get_bytes(&loaded.rng_state[0], rng_size);
+    }
+
+    uint32_t num_layers = reader.get<uint32_t>();
+    ParameterSnapshot params;
+    for (uint32_t i = 0; i < num_layers; ++i) {
+        params.weights.push_back(reader.get_matrix());
+        params.biases.push_back(reader.get_matrix());
+    }
+
+    net.restore_parameters(params);
+    state = loaded;
+    return true;
+}
@@ -0,0 +1,415 @@
+#include "Communicator.h"
+#include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <new>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+namespace {
+
+std::string errno_string() {
+    return std::string(std::strerror(errno));
+}
+
+bool timed_out(const std::chrono::steady_clock::time_point& deadline) {
+    return std::chrono::steady_clock::now() > deadline;
+}
+
+std::chrono::steady_clock::time_point deadline_after(double seconds) {
+    return std::chrono::steady_clock::now() +
+           std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+void split_endpoint(const std::string& endpoint, std::string& host, std::string& port) {
+    size_t colon = endpoint.find_last_of(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == endpoint.size()) {
+        throw std::invalid_argument("TcpCommunicator: Endpoint must be host:port, got \"" + endpoint + "\"");
+    }
+    host = endpoint.substr(0, colon);
+    port = endpoint.substr(colon + 1);
+}
+
+void write_fully(int fd, const void* data, size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        ssize_t written = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("TcpCommunicator: send failed: " + errno_string());
+        }
+        p += written;
+        n -= static_cast<size_t>(written);
+    }
+}
+
+void read_fully(int fd, void* data, size_t n) {
+    char* p = static_cast<char*>(data);
+    while (n > 0) {
+        ssize_t got = ::recv(fd, p, n, 0);
+        if (got == 0) {
+            throw std::runtime_error("TcpCommunicator: Peer closed the connection.");
+        }
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("TcpCommunicator: recv failed: " + errno_string());
+        }
+        p += got;
+        n -= static_cast<size_t>(got);
+    }
+}
+
+const int SHM_READY_MAGIC = 0x52494e47;
+
+} // namespace
+
+Communicator::Communicator(int rank, int size)
+    : rank_val(rank), size_val(size) {
+    if (size <= 0 || rank < 0 || rank >= size) {
+        throw std::invalid_argument("Communicator: Invalid rank " + std::to_string(rank) + " for size " + std::to_string(size));
+    }
+}
+
+void Communicator::barrier() {
+    double token = 0.0;
+    double received = 0.0;
+    for (int step = 0; step + 1 < size_val; ++step) {
+        exchange(&token, 1, &received, 1);
+    }
+}
+
+void Communicator::allreduce_sum(double* data, size_t count) {
+    int n = size_val;
+    if (n == 1 || count == 0) return;
+
+    std::vector<size_t> offsets(static_cast<size_t>(n) + 1, 0);
+    for (int c = 0; c < n; ++c) {
+        size_t len = count / n + (static_cast<size_t>(c) < count % n ? 1 : 0);
+        offsets[static_cast<size_t>(c) + 1] = offsets[static_cast<size_t>(c)] + len;
+    }
+    scratch.resize(count / n + 1);
+
+    for (int step = 0; step + 1 < n; ++step) {
+        size_t send_chunk = static_cast<size_t>((rank_val - step + n) % n);
+        size_t recv_chunk = static_cast<size_t>((rank_val - step - 1 + 2 * n) % n);
+        size_t send_len = offsets[send_chunk + 1] - offsets[send_chunk];
+        size_t recv_len = offsets[recv_chunk + 1] - offsets[recv_chunk];
+        exchange(data + offsets[send_chunk], send_len, scratch.data(), recv_len);
+        double* target = data + offsets[recv_chunk];
+        for (size_t i = 0; i < recv_len; ++i) {
+            target[i] += scratch[i];
+        }
+    }
+
+    for (int step = 0; step + 1 < n; ++step) {
+        size_t send_chunk = static_cast<size_t>((rank_val - step + 1 + n) % n);
+        size_t recv_chunk = static_cast<size_t>((rank_val - step + n) % n);
+        size_t send_len = offsets[send_chunk + 1] - offsets[send_chunk];
+        size_t recv_len = offsets[recv_chunk + 1] - offsets[recv_chunk];
+        exchange(data + offsets[send_chunk], send_len, data + offsets[recv_chunk], recv_len);
+    }
+}
+
+TcpCommunicator::TcpCommunicator(int rank, const std::vector<std::string>& endpoints, double connect_timeout_seconds)
+    : Communicator(rank, static_cast<int>(endpoints.size())), send_fd(-1), recv_fd(-1) {
+    if (size_val == 1) return;
+
+    std::string host, port;
+    split_endpoint(endpoints[static_cast<size_t>(rank)], host, port);
+
+    int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error("TcpCommunicator: socket failed: " + errno_string());
+    }
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(std::stoi(port)));
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listen_fd, 4) != 0) {
+        std::string error = errno_string();
+        ::close(listen_fd);
+        throw std::runtime_error("TcpCommunicator: Rank " + std::to_string(rank) + " cannot listen on port " + port + ": " + error);
+    }
+
+    std::chrono::steady_clock::time_point deadline = deadline_after(connect_timeout_seconds);
+    std::string next_host, next_port;
+    split_endpoint(endpoints[static_cast<size_t>(next_rank())], next_host, next_port);
+    while (send_fd < 0) {
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (::getaddrinfo(next_host.c_str(), next_port.c_str(), &hints, &result) == 0) {
+            for (addrinfo* ai = result; ai != nullptr && send_fd < 0; ai = ai->ai_next) {
+                int fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+                if (fd < 0) continue;
+                if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                    send_fd = fd;
+                } else {
+                    ::close(fd);
+                }
+            }
+            ::freeaddrinfo(result);
+        }
+        if (send_fd < 0) {
+            if (timed_out(deadline)) {
+                ::close(listen_fd);
+                throw std::runtime_error("TcpCommunicator: Rank " + std::to_string(rank) + " timed out connecting to " +
+                                         endpoints[static_cast<size_t>(next_rank())]);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+    setsockopt(send_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    int32_t my_rank = rank;
+    write_fully(send_fd, &my_rank, sizeof(my_rank));
+
+    pollfd pfd;
+    pfd.fd = listen_fd;
+    pfd.events = POLLIN;
+    int remaining_ms = static_cast<int>(std::max(0.0, std::chrono::duration<double, std::milli>(deadline - std::chrono::steady_clock::now()).count()));
+    if (::poll(&pfd, 1, remaining_ms) <= 0) {
+        ::close(listen_fd);
+        throw std::runtime_error("TcpCommunicator: Rank " + std::to_string(rank) + " timed out waiting for rank " + std::to_string(prev_rank()));
+    }
+    recv_fd = ::accept(listen_fd, nullptr, nullptr);
+    ::close(listen_fd);
+    if (recv_fd < 0) {
+        throw std::runtime_error("TcpCommunicator: accept failed: " + errno_string());
+    }
+    setsockopt(recv_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    int32_t peer_rank = -1;
+    read_fully(recv_fd, &peer_rank, sizeof(peer_rank));
+    if (peer_rank != prev_rank()) {
+        throw std::runtime_error("TcpCommunicator: Rank " + std::to_string(rank) + " expected rank " + std::to_string(prev_rank()) +
+                                 ", got " + std::to_string(peer_rank));
+    }
+
+    ::fcntl(send_fd, F_SETFL, ::fcntl(send_fd, F_GETFL) | O_NONBLOCK);
+    ::fcntl(recv_fd, F_SETFL, ::fcntl(recv_fd, F_GETFL) | O_NONBLOCK);
+}
+
+TcpCommunicator::~TcpCommunicator() {
+    if (send_fd >= 0) ::close(send_fd);
+    if (recv_fd >= 0) ::close(recv_fd);
+}
+
+std::vector<std::string> TcpCommunicator::local_endpoints(int size, int base_port) {
+    std::vector<std::string> endpoints;
+    for (int r = 0; r < size; ++r) {
+        endpoints.push_back("127.0.0.1:" + std::to_string(base_port + r));
+    }
+    return endpoints;
+}
+
+void TcpCommunicator::exchange(const double* send, size_t send_count, double* recv, size_t recv_count) {
+    if (size_val == 1) {
+        std::memcpy(recv, send, sizeof(double) * std::min(send_count, recv_count));
+        return;
+    }
+
+    const char* send_ptr = reinterpret_cast<const char*>(send);
+    char* recv_ptr = reinterpret_cast<char*>(recv);
+    size_t send_left = send_count * sizeof(double);
+    size_t recv_left = recv_count * sizeof(double);
+
+    while (send_left > 0 || recv_left > 0) {
+        pollfd fds[2];
+        int nfds = 0;
+        if (send_left > 0) { fds[nfds].fd = send_fd; fds[nfds].events = POLLOUT; fds[nfds].revents = 0; nfds++; }
+        if (recv_left > 0) { fds[nfds].fd = recv_fd; fds[nfds].events = POLLIN; fds[nfds].revents = 0; nfds++; }
+        if (::poll(fds, static_cast<nfds_t>(nfds), -1) < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("TcpCommunicator: poll failed: " + errno_string());
+        }
+        for (int i = 0; i < nfds; ++i) {
+            if (fds[i].revents & (POLLERR | POLLNVAL)) {
+                throw std::runtime_error("TcpCommunicator: Socket error during exchange.");
+            }
+            if (fds[i].fd == send_fd && (fds[i].revents & POLLOUT)) {
+                ssize_t n = ::send(send_fd, send_ptr, send_left, MSG_NOSIGNAL);
+                if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    throw std::runtime_error("TcpCommunicator: send failed: " + errno_string());
+                }
+                if (n > 0) { send_ptr += n; send_left -= static_cast<size_t>(n); }
+            }
+            if (fds[i].fd == recv_fd && (fds[i].revents & (POLLIN | POLLHUP))) {
+                ssize_t n = ::recv(recv_fd, recv_ptr, recv_left, 0);
+                if (n == 0) {
+                    throw std::runtime_error("TcpCommunicator: Peer closed the connection.");
+                }
+                if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    throw std::runtime_error("TcpCommunicator: recv failed: " + errno_string());
+                }
+                if (n > 0) { recv_ptr += n; recv_left -= static_cast<size_t>(n); }
+            }
+        }
+    }
+}
+
+struct ShmCommunicator::Header {
+    std::atomic<int> ready;
+    std::atomic<int> arrived;
+    std::atomic<int> sense;
+    std::atomic<int> pending[2];    // ranks with data left after the current exchange round, by round parity
+    int size;
+    size_t slot_capacity;
+};
+
+ShmCommunicator::ShmCommunicator(int rank, int size, const std::string& _name, size_t _slot_capacity,
+                                 double connect_timeout_seconds)
+    : Communicator(rank, size),
+      name(_name[0] == '/' ? _name : "/" + _name),
+      slot_capacity(_slot_capacity),
+      mapped_bytes(0),
+      mapping(nullptr),
+      header(nullptr),
+      local_sense(0),
+      round_parity(0)
+{
+    if (slot_capacity == 0) {
+        throw std::invalid_argument("ShmCommunicator: Slot capacity must be positive.");
+    }
+    size_t header_bytes = ((sizeof(Header) + 63) / 64) * 64;
+    mapped_bytes = header_bytes + static_cast<size_t>(size) * slot_capacity * sizeof(double);
+
+    int fd = -1;
+    std::chrono::steady_clock::time_point deadline = deadline_after(connect_timeout_seconds);
+    if (rank == 0) {
+        ::shm_unlink(name.c_str());
+        fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            throw std::runtime_error("ShmCommunicator: Cannot create " + name + ": " + errno_string());
+        }
+        if (::ftruncate(fd, static_cast<off_t>(mapped_bytes)) != 0) {
+            std::string error = errno_string();
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error("ShmCommunicator: Cannot size " + name + ": " + error);
+        }
+    } else {
+        for (;;) {
+            fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+            if (fd >= 0) {
+                struct stat st;
+                if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= mapped_bytes) break;
+                ::close(fd);
+                fd = -1;
+            }
+            if (timed_out(deadline)) {
+                throw std::runtime_error("ShmCommunicator: Rank " + std::to_string(rank) + " timed out opening " + name);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    mapping = ::mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::runtime_error("ShmCommunicator: mmap failed for " + name + ": " + errno_string());
+    }
+
+    if (rank == 0) {
+        header = new (mapping) Header();
+        header->arrived.store(0);
+        header->sense.store(0);
+        header->pending[0].store(0);
+        header->pending[1].store(0);
+        header->size = size;
+        header->slot_capacity = slot_capacity;
+        header->ready.store(SHM_READY_MAGIC);
+    } else {
+        header = static_cast<Header*>(mapping);
+        while (header->ready.load() != SHM_READY_MAGIC) {
+            if (timed_out(deadline)) {
+                throw std::runtime_error("ShmCommunicator: Rank " + std::to_string(rank) + " timed out waiting for " + name);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (header->size != size || header->slot_capacity != slot_capacity) {
+            throw std::runtime_error("ShmCommunicator: Segment " + name + " was created with a different configuration.");
+        }
+    }
+
+    barrier();
+    if (rank == 0) {
+        ::shm_unlink(name.c_str());
+    }
+}
+
+ShmCommunicator::~ShmCommunicator() {
+    if (mapping != nullptr) {
+        ::munmap(mapping, mapped_bytes);
+    }
+}
+
+double* ShmCommunicator::slot(int r) const {
+    size_t header_bytes = ((sizeof(Header) + 63) / 64) * 64;
+    return reinterpret_cast<double*>(static_cast<char*>(mapping) + header_bytes) + static_cast<size_t>(r) * slot_capacity;
+}
+
+void ShmCommunicator::barrier() {
+    local_sense = 1 - local_sense;
+    if (header->arrived.fetch_add(1) + 1 == size_val) {
+        header->arrived.store(0);
+        header->sense.store(local_sense);
+        return;
+    }
+    int spins = 0;
+    while (header->sense.load() != local_sense) {
+        if (++spins > 1000) {
+            sched_yield();
+        }
+    }
+}
+
+// A slot holds slot_capacity doubles, so long messages take several rounds of
+// two barriers each. Ranks may need different numbers of rounds (ring chunks
+// differ in length by one), and the barriers are global, so all ranks go on
+// while any rank has data left. pending[p] counts those ranks in rounds of
+// parity p, alternating across calls; rank 0 clears the counter of the next
+// round once everyone has read it.
+void ShmCommunicator::exchange(const double* send, size_t send_count, double* recv, size_t recv_count) {
+    size_t sent = 0;
+    size_t received = 0;
+    bool more = true;
+    while (more) {
+        size_t send_piece = std::min(slot_capacity, send_count - sent);
+        size_t recv_piece = std::min(slot_capacity, recv_count - received);
+        if (send_piece > 0) {
+            std::memcpy(slot(rank_val), send + sent, send_piece * sizeof(double));
+        }
+        sent += send_piece;
+        if (sent < send_count || received + recv_piece < recv_count) {
+            header->pending[round_parity].fetch_add(1);
+        }
+        barrier();
+        if (rank_val == 0) {
+            header->pending[1 - round_parity].store(0);
+        }
+        if (recv_piece > 0) {
+            std::memcpy(recv + received, slot(prev_rank()), recv_piece * sizeof(double));
+        }
+        received += recv_piece;
+        barrier();
+        more = header->pending[round_parity].load() > 0;
+        round_parity = 1 - round_parity;
+    }
+}
@@ -0,0 +1,172 @@
+#include "DataParallelTrainer.h"
+#include <stdexcept>
+#include <numeric>
+#include <algorithm>
+
+DataParallelTrainer::DataParallelTrainer(Network& _net, Communicator& _comm, bool overlap_communication)
+    : net(_net),
+      comm(_comm),
+      overlap(overlap_communication && _comm.size() > 1),
+      in_flight(0),
+      stop_requested(false)
+{
+    if (overlap) {
+        comm_thread = std::thread(&DataParallelTrainer::comm_loop, this);
+    }
+}
+
+DataParallelTrainer::~DataParallelTrainer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_requested = true;
+    }
+    cv.notify_all();
+    if (comm_thread.joinable()) {
+        comm_thread.join();
+    }
+}
+
+void DataParallelTrainer::shard_range(size_t total, int rank, int size, size_t& begin, size_t& end) {
+    size_t base = total / static_cast<size_t>(size);
+    size_t extra = total % static_cast<size_t>(size);
+    size_t r = static_cast<size_t>(rank);
+    begin = r * base + std::min(r, extra);
+    end = begin + base + (r < extra ? 1 : 0);
+}
+
+void DataParallelTrainer::broadcast_parameters() {
+    std::vector<Matrix*> params;
+    for (Layer& layer : net.getLayers()) {
+        params.push_back(&layer.weights);
+        params.push_back(&layer.biases);
+    }
+    for (SpatialLayer& layer : net.getFeatureLayers()) {
+        params.push_back(&layer.weights);
+        params.push_back(&layer.biases);
+    }
+    for (Matrix* m : params) {
+        size_t count = static_cast<size_t>(m->getRow()) * m->getCol();
+        if (count == 0) continue;
+        double* data = m->get_host_ptr();
+        if (comm.rank() != 0) {
+            std::fill(data, data + count, 0.0);
+        }
+        comm.allreduce_sum(data, count);
+    }
+}
+
+void DataParallelTrainer::reduce_layer(size_t layer_index) {
+    Layer& layer = net.getLayers()[layer_index];
+    Matrix* deltas[] = {&layer.delta_weights, &layer.delta_biases};
+    for (Matrix* m : deltas) {
+        comm.allreduce_sum(m->get_host_ptr(), static_cast<size_t>(m->getRow()) * m->getCol());
+    }
+}
+
+void DataParallelTrainer::submit_layer(size_t layer_index) {
+    if (layer_submitted[layer_index]) return;
+    layer_submitted[layer_index] = true;
+    if (!overlap) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(layer_index);
+        in_flight++;
+    }
+    cv.notify_all();
+}
+
+void DataParallelTrainer::comm_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this] { return stop_requested || !queue.empty(); });
+        if (queue.empty()) return;
+
+        size_t layer_index = queue.front();
+        queue.pop_front();
+        lock.unlock();
+        std::string error;
+        try {
+            reduce_layer(layer_index);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        lock.lock();
+        if (!error.empty() && error_message.empty()) {
+            error_message = error;
+        }
+        in_flight--;
+        cv.notify_all();
+    }
+}
+
+double DataParallelTrainer::finish_step(double local_loss, size_t global_batch_size, double learning_rate) {
+    size_t num_layers = net.getLayers().size();
+
+    // Every rank must reduce every layer, in the same order, even when its shard
+    // was empty and backward never ran.
+    for (size_t i = num_layers; i-- > 0; ) {
+        submit_layer(i);
+    }
+    if (overlap) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return in_flight == 0; });
+        if (!error_message.empty()) {
+            throw std::runtime_error("DataParallelTrainer: Allreduce failed: " + error_message);
+        }
+    } else {
+        for (size_t i = num_layers; i-- > 0; ) {
+            reduce_layer(i);
+        }
+    }
+
+    // Feature layers finish last in backward, so there is nothing left to overlap with.
+    for (SpatialLayer& layer : net.getFeatureLayers()) {
+        if (!layer.has_parameters()) continue;
+        comm.allreduce_sum(layer.delta_weights.get_host_ptr(), static_cast<size_t>(layer.delta_weights.getRow()) * layer.delta_weights.getCol());
+        comm.allreduce_sum(layer.delta_biases.get_host_ptr(), static_cast<size_t>(layer.delta_biases.getRow()) * layer.delta_biases.getCol());
+    }
+
+    double loss = local_loss;
+    comm.allreduce_sum(&loss, 1);
+
+    net.apply_gradients(learning_rate, static_cast<int>(global_batch_size));
+    return loss / static_cast<double>(global_batch_size);
+}
+
+double DataParallelTrainer::train_on_batch(const std::vector<Matrix>& batch_inputs,
+                                           const std::vector<Matrix>& batch_targets,
+                                           double learning_rate) {
+    if (batch_inputs.empty() || batch_inputs.size() != batch_targets.size()) {
+        throw std::invalid_argument("DataParallelTrainer::train_on_batch: Batch inputs and targets must be non-empty and the same size.");
+    }
+
+    size_t begin, end;
+    shard_range(batch_inputs.size(), comm.rank(), comm.size(), begin, end);
+    std::vector<Matrix> shard_inputs(batch_inputs.begin() + begin, batch_inputs.begin() + end);
+    std::vector<Matrix> shard_targets(batch_targets.begin() + begin, batch_targets.begin() + end);
+
+    layer_submitted.assign(net.getLayers().size(), false);
+    double local_loss = net.accumulate_batch_gradients(shard_inputs, shard_targets,
+                                                       [this](size_t i) { submit_layer(i); });
+    return finish_step(local_loss, batch_inputs.size(), learning_rate);
+}
+
+double DataParallelTrainer::train_on_sparse_batch(const SparseMatrix& batch_inputs,
+                                                  const std::vector<Matrix>& batch_targets,
+                                                  double learning_rate) {
+    if (batch_inputs.getRow() == 0 || static_cast<size_t>(batch_inputs.getRow()) != batch_targets.size()) {
+        throw std::invalid_argument("DataParallelTrainer::train_on_sparse_batch: Batch inputs and targets must be non-empty and the same size.");
+    }
+
+    size_t begin, end;
+    shard_range(batch_targets.size(), comm.rank(), comm.size(), begin, end);
+    std::vector<size_t> rows(batch_targets.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    SparseMatrix shard_inputs = batch_inputs.gatherRows(rows, begin, end);
+    std::vector<Matrix> shard_targets(batch_targets.begin() + begin, batch_targets.begin() + end);
+
+    layer_submitted.assign(net.getLayers().size(), false);
+    double local_loss = net.accumulate_sparse_batch_gradients(shard_inputs, shard_targets,
+                                                              [this](size_t i) { submit_layer(i); });
+    return finish_step(local_loss, batch_targets.size(), learning_rate);
+}
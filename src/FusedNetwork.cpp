@@ -0,0 +1,146 @@
+#include "FusedNetwork.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const int MAX_TILE = 64;
+const size_t TILE_BUFFER_BUDGET = 128 * 1024;
+
+// z[r][s] = sum_i w[r][i] * x[i][s] for R output rows and C columns of the
+// tile, accumulated in registers over i in order. x and z have row stride
+// stride.
+template <int R, int C>
+inline void micro_kernel(const double* w, int inputs, const double* x, int stride, double* z) {
+    double c[R][C] = {};
+    for (int i = 0; i < inputs; ++i) {
+        const double* x_row = x + static_cast<size_t>(i) * stride;
+        for (int r = 0; r < R; ++r) {
+            double a = w[static_cast<size_t>(r) * inputs + i];
+            for (int s = 0; s < C; ++s) c[r][s] += a * x_row[s];
+        }
+    }
+    for (int r = 0; r < R; ++r) {
+        for (int s = 0; s < C; ++s) z[static_cast<size_t>(r) * stride + s] = c[r][s];
+    }
+}
+
+template <int R>
+inline void row_block(const double* w, int inputs, const double* x, int stride, double* z, int columns) {
+    int s = 0;
+    for (; s + 4 <= columns; s += 4) micro_kernel<R, 4>(w, inputs, x + s, stride, z + s);
+    for (; s < columns; ++s) micro_kernel<R, 1>(w, inputs, x + s, stride, z + s);
+}
+
+} // namespace
+
+FusedNetwork::FusedNetwork(const Network& net, int tile_size) : tile(0), max_width(0) {
+    if (!net.getFeatureLayers().empty()) {
+        throw std::invalid_argument("FusedNetwork: Networks with convolution/pooling layers are not supported.");
+    }
+    if (net.getLayers().empty()) {
+        throw std::invalid_argument("FusedNetwork: Network has no layers.");
+    }
+    if (tile_size < 0 || tile_size > MAX_TILE) {
+        throw std::invalid_argument("FusedNetwork: Tile size must be in [0, " + std::to_string(MAX_TILE) +
+                                    "], got " + std::to_string(tile_size));
+    }
+    for (const Layer& layer : net.getLayers()) {
+        MatrixView w = layer.weights.view();
+        MatrixView b = layer.biases.view();
+        FusedLayer fused;
+        fused.inputs = w.getCol();
+        fused.outputs = w.getRow();
+        fused.activation = layer.activation;
+        if (!layers.empty() && layers.back().outputs != fused.inputs) {
+            throw std::invalid_argument("FusedNetwork: Layer sizes do not chain.");
+        }
+        fused.weights.resize(static_cast<size_t>(fused.outputs) * fused.inputs);
+        for (int r = 0; r < fused.outputs; ++r) {
+            for (int c = 0; c < fused.inputs; ++c) {
+                fused.weights[static_cast<size_t>(r) * fused.inputs + c] = w(r, c);
+            }
+        }
+        fused.biases.resize(static_cast<size_t>(fused.outputs));
+        for (int r = 0; r < fused.outputs; ++r) fused.biases[static_cast<size_t>(r)] = b(r, 0);
+        max_width = std::max(max_width, std::max(fused.inputs, fused.outputs));
+        layers.push_back(std::move(fused));
+    }
+    tile = tile_size > 0 ? tile_size : default_tile_size(net);
+}
+
+int FusedNetwork::default_tile_size(const Network& net) {
+    size_t widest_pair = 0;
+    for (const Layer& layer : net.getLayers()) {
+        widest_pair = std::max(widest_pair, static_cast<size_t>(layer.weights.getRow()) + layer.weights.getCol());
+    }
+    size_t fit = widest_pair > 0 ? TILE_BUFFER_BUDGET / (sizeof(double) * widest_pair) : MAX_TILE;
+    int tile_size = static_cast<int>(std::min<size_t>(fit, MAX_TILE)) / 4 * 4;
+    return std::max(tile_size, 4);
+}
+
+// z = f(W x + b) for the first columns of a tile. The sum over inputs starts
+// from zero and the bias is added afterwards, as in Layer::infer.
+void FusedNetwork::run_layer(const FusedLayer& layer, const double* x, double* z, int columns, int stride) {
+    const double* w = layer.weights.data();
+    int o = 0;
+    if (columns < 4) {
+        // Narrow tiles: more rows per pass give more independent sums.
+        for (; o + 8 <= layer.outputs; o += 8) {
+            row_block<8>(w + static_cast<size_t>(o) * layer.inputs, layer.inputs, x, stride, z + static_cast<size_t>(o) * stride, columns);
+        }
+    }
+    for (; o + 4 <= layer.outputs; o += 4) {
+        row_block<4>(w + static_cast<size_t>(o) * layer.inputs, layer.inputs, x, stride, z + static_cast<size_t>(o) * stride, columns);
+    }
+    for (; o < layer.outputs; ++o) {
+        row_block<1>(w + static_cast<size_t>(o) * layer.inputs, layer.inputs, x, stride, z + static_cast<size_t>(o) * stride, columns);
+    }
+    for (o = 0; o < layer.outputs; ++o) {
+        double* z_row = z + static_cast<size_t>(o) * stride;
+        double bias = layer.biases[static_cast<size_t>(o)];
+        for (int s = 0; s < columns; ++s) z_row[s] += bias;
+        activations::apply(layer.activation, z_row, z_row, static_cast<size_t>(columns));
+    }
+}
+
+Matrix FusedNetwork::infer(const MatrixView& input) const {
+    if (input.getRow() != input_size()) {
+        throw std::invalid_argument("FusedNetwork::infer: Input has " + std::to_string(input.getRow()) +
+                                    " features, network expects " + std::to_string(input_size()));
+    }
+    int samples = input.getCol();
+    Matrix result(output_size(), samples);
+    if (samples == 0) return result;
+
+    // Rows of the tile buffers are padded to the tile width, not to samples,
+    // so a whole tile stays within a few KiB per layer.
+    int stride = std::min(tile, samples);
+    std::vector<double, AlignedAllocator<double> > scratch(2 * static_cast<size_t>(max_width) * stride);
+    double* buffers[2] = {scratch.data(), scratch.data() + static_cast<size_t>(max_width) * stride};
+    double* out = result.get_host_ptr();
+
+    for (int col0 = 0; col0 < samples; col0 += stride) {
+        int columns = std::min(stride, samples - col0);
+        double* x = buffers[0];
+        for (int i = 0; i < input_size(); ++i) {
+            double* x_row = x + static_cast<size_t>(i) * stride;
+            if (input.has_unit_col_stride()) {
+                std::memcpy(x_row, input.data() + i * input.getRowStride() + col0, sizeof(double) * columns);
+            } else {
+                for (int s = 0; s < columns; ++s) x_row[s] = input(i, col0 + s);
+            }
+        }
+        int current = 0;
+        for (const FusedLayer& layer : layers) {
+            run_layer(layer, buffers[current], buffers[1 - current], columns, stride);
+            current = 1 - current;
+        }
+        for (int o = 0; o < output_size(); ++o) {
+            std::memcpy(out + static_cast<size_t>(o) * samples + col0, buffers[current] + static_cast<size_t>(o) * stride,
+                        sizeof(double) * columns);
+        }
+    }
+    return result;
+}
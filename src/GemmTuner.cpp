@@ -0,0 +1,213 @@
+#include "GemmTuner.h"
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <set>
+#include <algorithm>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// Blocks larger than the shape behave like the whole dimension, so clamp them
+// to tell candidates that would run identically apart.
+GemmBlocking effective(const GemmBlocking& b, const GemmShape& shape) {
+    int block_m = (b.block_m == 0 || b.block_m >= shape.m) ? 0 : b.block_m;
+    return GemmBlocking(block_m, std::min(b.block_k, shape.k), std::min(b.block_n, shape.n));
+}
+
+double best_call_seconds(const Matrix& lhs, const Matrix& rhs, const GemmBlocking& blocking, double budget) {
+    typedef std::chrono::steady_clock Clock;
+    Matrix::multiply(lhs.view(), rhs.view(), blocking);
+    double best = 1e30;
+    Clock::time_point start = Clock::now();
+    for (int calls = 0; calls < 3 || std::chrono::duration<double>(Clock::now() - start).count() < budget; ++calls) {
+        Clock::time_point t0 = Clock::now();
+        Matrix c = Matrix::multiply(lhs.view(), rhs.view(), blocking);
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t0).count());
+    }
+    return best;
+}
+
+} // namespace
+
+GemmTuner::GemmTuner(const std::string& cache_path, double seconds_per_candidate)
+    : cache_path(cache_path),
+      seconds_per_candidate(seconds_per_candidate),
+      cpu_name(cpu_model())
+{
+    if (seconds_per_candidate <= 0.0) {
+        throw std::invalid_argument("GemmTuner: seconds_per_candidate must be positive");
+    }
+    read_cache();
+}
+
+std::string GemmTuner::cpu_model() {
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) break;
+            size_t begin = line.find_first_not_of(" \t", colon + 1);
+            return begin == std::string::npos ? "unknown" : line.substr(begin);
+        }
+    }
+    return "unknown";
+}
+
+std::vector<GemmShape> GemmTuner::network_shapes(const Network& net, const std::vector<int>& batch_sizes) {
+    std::set<GemmShape> shapes;
+    for (const Layer& layer : net.getLayers()) {
+        int out = layer.weights.getRow();
+        int in = layer.weights.getCol();
+        for (int b : batch_sizes) {
+            shapes.insert(GemmShape(out, in, b));   // W * X
+            shapes.insert(GemmShape(out, b, in));   // dZ * X^T
+            shapes.insert(GemmShape(in, out, b));   // W^T * dZ
+        }
+    }
+    std::vector<GemmShape> result;
+    for (const GemmShape& s : shapes) {
+        if (s.m > 0 && s.k > 0 && s.n > 1) result.push_back(s);
+    }
+    return result;
+}
+
+std::vector<GemmBlocking> GemmTuner::candidates(const GemmShape& shape) {
+    std::vector<GemmBlocking> result(1, effective(GemmBlocking(), shape));
+    const int block_ms[] = {0, 16, 64};
+    const int block_ks[] = {32, 64, 128, 256};
+    const int block_ns[] = {64, 128, 256, 512};
+    for (int bm : block_ms) {
+        for (int bk : block_ks) {
+            for (int bn : block_ns) {
+                GemmBlocking candidate = effective(GemmBlocking(bm, bk, bn), shape);
+                if (std::find(result.begin(), result.end(), candidate) == result.end()) result.push_back(candidate);
+            }
+        }
+    }
+    return result;
+}
+
+GemmBlocking GemmTuner::benchmark(const GemmShape& shape, double* speedup) const {
+    if (shape.m <= 0 || shape.k <= 0 || shape.n <= 0) {
+        throw std::invalid_argument("GemmTuner::benchmark: Invalid shape " + std::to_string(shape.m) + "x" +
+                                    std::to_string(shape.k) + "x" + std::to_string(shape.n));
+    }
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<double> value(-1.0, 1.0);
+    Matrix lhs(shape.m, shape.k, false);
+    Matrix rhs(shape.k, shape.n, false);
+    double* a = lhs.get_host_ptr();
+    double* b = rhs.get_host_ptr();
+    for (size_t i = 0; i < static_cast<size_t>(shape.m) * shape.k; ++i) a[i] = value(rng);
+    for (size_t i = 0; i < static_cast<size_t>(shape.k) * shape.n; ++i) b[i] = value(rng);
+
+    // Two passes over the candidates, keeping each one's best call, so a noisy
+    // moment early in the sweep does not decide the winner.
+    std::vector<GemmBlocking> options = candidates(shape);
+    std::vector<double> seconds(options.size(), 1e30);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t c = 0; c < options.size(); ++c) {
+            seconds[c] = std::min(seconds[c], best_call_seconds(lhs, rhs, options[c], seconds_per_candidate / 2));
+        }
+    }
+
+    size_t best = 0;
+    for (size_t c = 1; c < options.size(); ++c) {
+        if (seconds[c] < seconds[best]) best = c;
+    }
+    if (seconds[best] > seconds[0] / 1.02) best = 0;
+    if (speedup) *speedup = seconds[0] / seconds[best];
+    return options[best];
+}
+
+std::vector<GemmTuningResult> GemmTuner::tune(const std::vector<GemmShape>& shapes) {
+    std::vector<GemmTuningResult> results;
+    bool added = false;
+    for (const GemmShape& shape : shapes) {
+        GemmTuningResult result;
+        result.shape = shape;
+        result.from_cache = false;
+        for (const CacheEntry& entry : entries) {
+            if (entry.cpu == cpu_name && entry.shape == shape) {
+                result.blocking = entry.blocking;
+                result.speedup = entry.speedup;
+                result.from_cache = true;
+                break;
+            }
+        }
+        if (!result.from_cache) {
+            result.blocking = benchmark(shape, &result.speedup);
+            CacheEntry entry;
+            entry.cpu = cpu_name;
+            entry.shape = shape;
+            entry.blocking = result.blocking;
+            entry.speedup = result.speedup;
+            entries.push_back(entry);
+            added = true;
+        }
+        Matrix::setGemmBlocking(shape.m, shape.k, shape.n, result.blocking);
+        results.push_back(result);
+    }
+    if (added) write_cache();
+    return results;
+}
+
+int GemmTuner::load() {
+    int installed = 0;
+    for (const CacheEntry& entry : entries) {
+        if (entry.cpu != cpu_name) continue;
+        Matrix::setGemmBlocking(entry.shape.m, entry.shape.k, entry.shape.n, entry.blocking);
+        ++installed;
+    }
+    return installed;
+}
+
+// One entry per line: m k n block_m block_k block_n speedup cpu model...
+void GemmTuner::read_cache() {
+    entries.clear();
+    std::ifstream in(cache_path.c_str());
+    if (!in) return;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        CacheEntry entry;
+        fields >> entry.shape.m >> entry.shape.k >> entry.shape.n
+               >> entry.blocking.block_m >> entry.blocking.block_k >> entry.blocking.block_n >> entry.speedup;
+        if (fields) std::getline(fields >> std::ws, entry.cpu);
+        if (!fields || entry.cpu.empty() || entry.blocking.block_m < 0 || entry.blocking.block_k <= 0 || entry.blocking.block_n <= 0) {
+            throw std::runtime_error("GemmTuner: Malformed line " + std::to_string(line_number) + " in " + cache_path);
+        }
+        entries.push_back(entry);
+    }
+}
+
+void GemmTuner::write_cache() const {
+    std::string tmp_path = cache_path + ".tmp";
+    {
+        std::ofstream out(tmp_path.c_str(), std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("GemmTuner: Cannot open " + tmp_path + ": " + std::strerror(errno));
+        }
+        out << "# m k n block_m block_k block_n speedup cpu_model\n";
+        for (const CacheEntry& entry : entries) {
+            out << entry.shape.m << ' ' << entry.shape.k << ' ' << entry.shape.n << ' '
+                << entry.blocking.block_m << ' ' << entry.blocking.block_k << ' ' << entry.blocking.block_n << ' '
+                << entry.speedup << ' ' << entry.cpu << '\n';
+        }
+        if (!out.flush()) {
+            throw std::runtime_error("GemmTuner: Write failed for " + tmp_path);
+        }
+    }
+    if (std::rename(tmp_path.c_str(), cache_path.c_str()) != 0) {
+        throw std::runtime_error("GemmTuner: Cannot rename " + tmp_path + " to " + cache_path + ": " + std::strerror(errno));
+    }
+}
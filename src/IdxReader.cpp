@@ -0,0 +1,219 @@
+#include "IdxReader.h"
+#include <zlib.h>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <algorithm>
+
+namespace {
+
+uint32_t big_endian_u32(const unsigned char* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+uint64_t big_endian_u64(const unsigned char* p) {
+    return (static_cast<uint64_t>(big_endian_u32(p)) << 32) | big_endian_u32(p + 4);
+}
+
+} // namespace
+
+IdxReader::IdxReader(const std::string& path, size_t chunk_bytes, int chunks_in_flight)
+    : file_path(path),
+      file(nullptr),
+      gzip(false),
+      element_type(IdxType::UInt8),
+      current(-1),
+      offset(0),
+      stop_requested(false),
+      finished(false)
+{
+    if (chunk_bytes == 0 || chunks_in_flight < 2) {
+        throw std::invalid_argument("IdxReader: Need a non-zero chunk size and at least 2 chunks in flight");
+    }
+    gzFile gz = gzopen(path.c_str(), "rb");
+    if (!gz) {
+        throw std::runtime_error("IdxReader: Cannot open " + path + ": " + std::strerror(errno));
+    }
+    gzbuffer(gz, 256 * 1024);
+    file = gz;
+
+    chunks.resize(static_cast<size_t>(chunks_in_flight));
+    for (int c = 0; c < chunks_in_flight; ++c) {
+        chunks[static_cast<size_t>(c)].data.resize(chunk_bytes);
+        chunks[static_cast<size_t>(c)].size = 0;
+        free_chunks.push_back(c);
+    }
+    producer = std::thread(&IdxReader::producer_loop, this);
+
+    try {
+        unsigned char header[4];
+        read_bytes(header, 4);
+        if (header[0] != 0 || header[1] != 0) {
+            throw std::runtime_error("IdxReader: Not an IDX file: " + path);
+        }
+        element_type = static_cast<IdxType>(header[2]);
+        element_size(element_type);
+        if (header[3] == 0) {
+            throw std::runtime_error("IdxReader: IDX file of rank 0: " + path);
+        }
+        for (int d = 0; d < header[3]; ++d) {
+            unsigned char bytes[4];
+            read_bytes(bytes, 4);
+            uint32_t dim = big_endian_u32(bytes);
+            if (dim > 0x7fffffffu) {
+                throw std::runtime_error("IdxReader: Dimension " + std::to_string(d) + " too large in " + path);
+            }
+            dimensions.push_back(static_cast<int>(dim));
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop_requested = true;
+        }
+        free_cv.notify_all();
+        producer.join();
+        gzclose(gz);
+        throw;
+    }
+}
+
+IdxReader::~IdxReader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_requested = true;
+    }
+    free_cv.notify_all();
+    if (producer.joinable()) producer.join();
+    if (file) gzclose(static_cast<gzFile>(file));
+}
+
+size_t IdxReader::element_size(IdxType type) {
+    switch (type) {
+        case IdxType::UInt8:
+        case IdxType::Int8: return 1;
+        case IdxType::Int16: return 2;
+        case IdxType::Int32:
+        case IdxType::Float32: return 4;
+        case IdxType::Float64: return 8;
+    }
+    throw std::runtime_error("IdxReader: Unknown IDX element type " + std::to_string(static_cast<int>(type)));
+}
+
+std::string IdxReader::resolve(const std::string& path) {
+    if (std::ifstream(path.c_str()).good()) return path;
+    std::string gz_path = path + ".gz";
+    if (std::ifstream(gz_path.c_str()).good()) return gz_path;
+    return path;
+}
+
+void IdxReader::producer_loop() {
+    gzFile gz = static_cast<gzFile>(file);
+    for (bool first = true;; first = false) {
+        int c;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            free_cv.wait(lock, [this]() { return stop_requested || !free_chunks.empty(); });
+            if (stop_requested) return;
+            c = free_chunks.front();
+            free_chunks.pop_front();
+        }
+
+        // Inflate outside the lock; the consumer keeps parsing the filled chunks.
+        Chunk& chunk = chunks[static_cast<size_t>(c)];
+        int n = gzread(gz, chunk.data.data(), static_cast<unsigned>(chunk.data.size()));
+        bool plain = first && gzdirect(gz) != 0;
+        std::string failure;
+        if (n < 0) {
+            int code = 0;
+            const char* message = gzerror(gz, &code);
+            failure = (code == Z_ERRNO) ? std::strerror(errno) : (message ? message : "gzread failed");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            chunk.size = n > 0 ? static_cast<size_t>(n) : 0;
+            if (first) gzip = !plain;
+            if (n > 0) {
+                filled.push_back(c);
+            } else {
+                free_chunks.push_back(c);
+                error = failure;
+                finished = true;
+            }
+        }
+        filled_cv.notify_one();
+        if (n <= 0) return;
+    }
+}
+
+void IdxReader::read_bytes(void* destination, size_t n) {
+    unsigned char* out = static_cast<unsigned char*>(destination);
+    while (n > 0) {
+        if (current < 0) {
+            std::unique_lock<std::mutex> lock(mutex);
+            filled_cv.wait(lock, [this]() { return !filled.empty() || finished; });
+            if (filled.empty()) {
+                if (!error.empty()) throw std::runtime_error("IdxReader: Read failed for " + file_path + ": " + error);
+                throw std::runtime_error("IdxReader: Unexpected end of file in " + file_path);
+            }
+            current = filled.front();
+            filled.pop_front();
+            offset = 0;
+        }
+
+        Chunk& chunk = chunks[static_cast<size_t>(current)];
+        size_t take = std::min(n, chunk.size - offset);
+        std::memcpy(out, chunk.data.data() + offset, take);
+        out += take;
+        n -= take;
+        offset += take;
+        if (offset == chunk.size) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                free_chunks.push_back(current);
+            }
+            free_cv.notify_one();
+            current = -1;
+        }
+    }
+}
+
+void IdxReader::read_values(double* destination, size_t count) {
+    size_t width = element_size(element_type);
+    std::vector<unsigned char> block;
+    const size_t block_elements = 4096;
+    while (count > 0) {
+        size_t n = std::min(count, block_elements);
+        block.resize(n * width);
+        read_bytes(block.data(), block.size());
+        const unsigned char* p = block.data();
+        for (size_t i = 0; i < n; ++i, p += width) {
+            switch (element_type) {
+                case IdxType::UInt8: destination[i] = static_cast<double>(p[0]); break;
+                case IdxType::Int8: destination[i] = static_cast<double>(static_cast<signed char>(p[0])); break;
+                case IdxType::Int16:
+                    destination[i] = static_cast<double>(static_cast<int16_t>((static_cast<uint16_t>(p[0]) << 8) | p[1]));
+                    break;
+                case IdxType::Int32: destination[i] = static_cast<double>(static_cast<int32_t>(big_endian_u32(p))); break;
+                case IdxType::Float32: {
+                    uint32_t bits = big_endian_u32(p);
+                    float value;
+                    std::memcpy(&value, &bits, sizeof(value));
+                    destination[i] = static_cast<double>(value);
+                    break;
+                }
+                case IdxType::Float64: {
+                    uint64_t bits = big_endian_u64(p);
+                    double value;
+                    std::memcpy(&value, &bits, sizeof(value));
+                    destination[i] = value;
+                    break;
+                }
+            }
+        }
+        destination += n;
+        count -= n;
+    }
+}
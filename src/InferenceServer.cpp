@@ -0,0 +1,456 @@
+#include "InferenceServer.h"
+#include <stdexcept>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <system_error>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+const uint32_t InferenceServer::OP_PREDICT;
+const uint32_t InferenceServer::OP_STATS;
+const uint32_t InferenceServer::STATUS_OK;
+const uint32_t InferenceServer::STATUS_ERROR;
+
+namespace {
+
+const size_t STATS_FIELDS = 11;
+
+std::string errno_string() {
+    return std::string(std::strerror(errno));
+}
+
+double micros_between(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+// Both return false when the peer has gone away (or, for a socket with a send
+// timeout, has not read for that long).
+bool write_fully(int fd, const void* data, size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        ssize_t written = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += written;
+        n -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool read_fully(int fd, void* data, size_t n) {
+    char* p = static_cast<char*>(data);
+    while (n > 0) {
+        ssize_t got = ::recv(fd, p, n, 0);
+        if (got == 0) return false;
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += got;
+        n -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+sockaddr_un socket_address(const std::string& path, const char* who) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        throw std::invalid_argument(std::string(who) + ": Socket path must be 1 to " +
+                                    std::to_string(sizeof(addr.sun_path) - 1) + " characters, got \"" + path + "\"");
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    return addr;
+}
+
+std::vector<double> stats_fields(const InferenceServerStats& s) {
+    return {static_cast<double>(s.requests), static_cast<double>(s.batches), static_cast<double>(s.rejected),
+            s.uptime_seconds, s.requests_per_second, s.mean_batch_size, s.mean_queue_us, s.max_queue_us,
+            s.mean_latency_us, s.max_latency_us, s.mean_compute_us};
+}
+
+} // namespace
+
+InferenceServerStats::InferenceServerStats()
+    : requests(0), batches(0), rejected(0), uptime_seconds(0.0), requests_per_second(0.0), mean_batch_size(0.0),
+      mean_queue_us(0.0), max_queue_us(0.0), mean_latency_us(0.0), max_latency_us(0.0), mean_compute_us(0.0) {}
+
+std::string InferenceServerStats::to_string() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << requests << " requests in " << batches << " batches (mean size " << mean_batch_size << "), "
+        << rejected << " rejected, " << requests_per_second << " req/s over " << uptime_seconds << " s; "
+        << "queue mean " << mean_queue_us << " us max " << max_queue_us << " us, "
+        << "latency mean " << mean_latency_us << " us max " << max_latency_us << " us, "
+        << "compute " << mean_compute_us << " us/batch";
+    return out.str();
+}
+
+struct InferenceServer::Connection {
+    int fd;
+    std::thread reader;
+    std::atomic<bool> finished;     // reader has returned and can be joined
+    std::mutex write_mutex;
+    bool broken;                    // a send failed or timed out; guarded by write_mutex
+
+    explicit Connection(int _fd) : fd(_fd), finished(false), broken(false) {}
+    ~Connection() { ::close(fd); }
+
+    // A failed or timed-out send may leave a partial response on the stream, so
+    // the connection is shut down and later responses are dropped.
+    bool send_response(uint32_t status, const void* payload, uint32_t count, size_t element_size) {
+        uint32_t header[2] = {status, count};
+        std::lock_guard<std::mutex> lock(write_mutex);
+        if (broken) return false;
+        if (write_fully(fd, header, sizeof(header)) && (count == 0 || write_fully(fd, payload, count * element_size))) {
+            return true;
+        }
+        broken = true;
+        ::shutdown(fd, SHUT_RDWR);
+        return false;
+    }
+
+    bool send_error(const std::string& message) {
+        return send_response(STATUS_ERROR, message.data(), static_cast<uint32_t>(message.size()), 1);
+    }
+};
+
+InferenceServer::InferenceServer(const Network& _net, const InferenceServerConfig& _config)
+    : net(_net),
+      config(_config),
+      listen_fd(-1),
+      running(false),
+      stop_requested(false),
+      request_count(0),
+      batch_count(0),
+      rejected_count(0),
+      total_queue_us(0.0),
+      max_queue_us(0.0),
+      total_latency_us(0.0),
+      max_latency_us(0.0),
+      total_compute_us(0.0)
+{
+    if (config.max_batch_size <= 0 || config.max_queue_delay_us < 0 || config.send_timeout_ms <= 0) {
+        throw std::invalid_argument("InferenceServer: Max batch size and send timeout must be positive and max queue delay non-negative.");
+    }
+    input_features = net.getFeatureLayers().empty() ? net.getLayers().front().weights.getCol()
+                                                    : net.getFeatureLayers().front().getInputSize();
+    output_features = net.getLayers().back().weights.getRow();
+    socket_address(config.socket_path, "InferenceServer");
+}
+
+InferenceServer::~InferenceServer() {
+    stop();
+}
+
+void InferenceServer::start() {
+    if (running) {
+        throw std::logic_error("InferenceServer::start: Server is already running.");
+    }
+    sockaddr_un addr = socket_address(config.socket_path, "InferenceServer");
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error("InferenceServer::start: socket failed: " + errno_string());
+    }
+    ::unlink(config.socket_path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listen_fd, 128) != 0) {
+        std::string error = errno_string();
+        ::close(listen_fd);
+        listen_fd = -1;
+        throw std::runtime_error("InferenceServer::start: Cannot listen on " + config.socket_path + ": " + error);
+    }
+
+    stop_requested = false;
+    start_time = std::chrono::steady_clock::now();
+    running = true;
+    batcher = std::thread(&InferenceServer::batch_loop, this);
+    acceptor = std::thread(&InferenceServer::accept_loop, this);
+}
+
+void InferenceServer::stop() {
+    if (!running) return;
+    running = false;
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stop_requested = true;
+    }
+    queue_cv.notify_all();
+    ::shutdown(listen_fd, SHUT_RDWR);
+    acceptor.join();
+    batcher.join();
+
+    // The acceptor has exited, so nothing else adds to or reaps connections.
+    for (const std::shared_ptr<Connection>& connection : connections) {
+        ::shutdown(connection->fd, SHUT_RDWR);
+    }
+    for (const std::shared_ptr<Connection>& connection : connections) {
+        connection->reader.join();
+    }
+    connections.clear();
+    queue.clear();
+    ::close(listen_fd);
+    listen_fd = -1;
+    ::unlink(config.socket_path.c_str());
+}
+
+InferenceServerStats InferenceServer::stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    InferenceServerStats s;
+    s.requests = request_count;
+    s.batches = batch_count;
+    s.rejected = rejected_count;
+    s.uptime_seconds = running ? micros_between(start_time, std::chrono::steady_clock::now()) * 1e-6 : 0.0;
+    s.requests_per_second = s.uptime_seconds > 0.0 ? static_cast<double>(request_count) / s.uptime_seconds : 0.0;
+    if (request_count > 0) {
+        s.mean_batch_size = static_cast<double>(request_count) / static_cast<double>(batch_count);
+        s.mean_queue_us = total_queue_us / static_cast<double>(request_count);
+        s.mean_latency_us = total_latency_us / static_cast<double>(request_count);
+        s.mean_compute_us = total_compute_us / static_cast<double>(batch_count);
+    }
+    s.max_queue_us = max_queue_us;
+    s.max_latency_us = max_latency_us;
+    return s;
+}
+
+void InferenceServer::accept_loop() {
+    while (true) {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return;   // listen socket shut down by stop()
+        }
+        reap_connections();
+        timeval timeout;
+        timeout.tv_sec = config.send_timeout_ms / 1000;
+        timeout.tv_usec = (config.send_timeout_ms % 1000) * 1000;
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>(fd);
+        try {
+            connection->reader = std::thread(&InferenceServer::connection_loop, this, connection);
+        } catch (const std::system_error&) {
+            continue;   // out of threads: drop this client, which closes its socket
+        }
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        connections.push_back(connection);
+    }
+}
+
+// Joins the reader threads of closed connections, so their stacks are released.
+// Requests still queued keep their Connection alive until answered.
+void InferenceServer::reap_connections() {
+    std::vector<std::shared_ptr<Connection> > closed;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        std::vector<std::shared_ptr<Connection> >::iterator open =
+            std::stable_partition(connections.begin(), connections.end(),
+                                  [](const std::shared_ptr<Connection>& c) { return !c->finished.load(); });
+        closed.assign(open, connections.end());
+        connections.erase(open, connections.end());
+    }
+    for (const std::shared_ptr<Connection>& connection : closed) {
+        connection->reader.join();
+    }
+}
+
+void InferenceServer::connection_loop(std::shared_ptr<Connection> connection) {
+    uint32_t header[2];
+    while (read_fully(connection->fd, header, sizeof(header))) {
+        if (header[0] == OP_STATS) {
+            std::vector<double> fields = stats_fields(stats());
+            if (!connection->send_response(STATUS_OK, fields.data(), static_cast<uint32_t>(fields.size()), sizeof(double))) break;
+            continue;
+        }
+        if (header[0] != OP_PREDICT || header[1] != static_cast<uint32_t>(input_features)) {
+            {
+                std::lock_guard<std::mutex> lock(stats_mutex);
+                rejected_count++;
+            }
+            // The payload length cannot be trusted, so the connection is closed after the error.
+            connection->send_error(header[0] != OP_PREDICT
+                                   ? "Unknown op " + std::to_string(header[0])
+                                   : "Expected " + std::to_string(input_features) + " inputs, got " + std::to_string(header[1]));
+            break;
+        }
+
+        Request request;
+        request.connection = connection;
+        request.input.resize(header[1]);
+        if (!read_fully(connection->fd, request.input.data(), header[1] * sizeof(double))) break;
+        request.arrival = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (stop_requested) break;
+            queue.push_back(std::move(request));
+        }
+        queue_cv.notify_one();
+    }
+    ::shutdown(connection->fd, SHUT_RDWR);
+    connection->finished = true;
+}
+
+void InferenceServer::batch_loop() {
+    size_t max_batch = static_cast<size_t>(config.max_batch_size);
+    std::chrono::microseconds max_delay(config.max_queue_delay_us);
+    std::vector<Request> batch;
+
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    while (true) {
+        queue_cv.wait(lock, [this] { return stop_requested || !queue.empty(); });
+        if (stop_requested) return;
+
+        std::chrono::steady_clock::time_point deadline = queue.front().arrival + max_delay;
+        while (!stop_requested && queue.size() < max_batch && std::chrono::steady_clock::now() < deadline) {
+            queue_cv.wait_until(lock, deadline);
+        }
+        if (stop_requested) return;
+
+        size_t count = std::min(max_batch, queue.size());
+        batch.clear();
+        for (size_t i = 0; i < count; ++i) {
+            batch.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+
+        lock.unlock();
+        run_batch(batch);
+        lock.lock();
+    }
+}
+
+void InferenceServer::run_batch(std::vector<Request>& batch) {
+    std::chrono::steady_clock::time_point batch_start = std::chrono::steady_clock::now();
+    int cols = static_cast<int>(batch.size());
+
+    // One sample per column.
+    Matrix input(input_features, cols, false);
+    double* in = input.get_host_ptr();
+    for (int b = 0; b < cols; ++b) {
+        const std::vector<double>& x = batch[static_cast<size_t>(b)].input;
+        for (int i = 0; i < input_features; ++i) {
+            in[static_cast<size_t>(i) * cols + b] = x[static_cast<size_t>(i)];
+        }
+    }
+
+    Matrix output = net.infer(input.view());
+    if (output.is_on_device() && output.get_device_ptr()) output.to_host();
+    std::chrono::steady_clock::time_point compute_end = std::chrono::steady_clock::now();
+
+    const double* out = output.get_host_ptr();
+    std::vector<double> column(static_cast<size_t>(output_features));
+    double queue_us = 0.0;
+    double batch_max_queue_us = 0.0;
+    double latency_us = 0.0;
+    double batch_max_latency_us = 0.0;
+    for (int b = 0; b < cols; ++b) {
+        Request& request = batch[static_cast<size_t>(b)];
+        for (int i = 0; i < output_features; ++i) {
+            column[static_cast<size_t>(i)] = out[static_cast<size_t>(i) * cols + b];
+        }
+        request.connection->send_response(STATUS_OK, column.data(), static_cast<uint32_t>(output_features), sizeof(double));
+
+        double waited = micros_between(request.arrival, batch_start);
+        double total = micros_between(request.arrival, std::chrono::steady_clock::now());
+        queue_us += waited;
+        latency_us += total;
+        batch_max_queue_us = std::max(batch_max_queue_us, waited);
+        batch_max_latency_us = std::max(batch_max_latency_us, total);
+    }
+    batch.clear();
+
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    request_count += static_cast<unsigned long long>(cols);
+    batch_count++;
+    total_queue_us += queue_us;
+    total_latency_us += latency_us;
+    total_compute_us += micros_between(batch_start, compute_end);
+    max_queue_us = std::max(max_queue_us, batch_max_queue_us);
+    max_latency_us = std::max(max_latency_us, batch_max_latency_us);
+}
+
+InferenceClient::InferenceClient(const std::string& socket_path) : fd(-1) {
+    sockaddr_un addr = socket_address(socket_path, "InferenceClient");
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error("InferenceClient: socket failed: " + errno_string());
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::string error = errno_string();
+        ::close(fd);
+        throw std::runtime_error("InferenceClient: Cannot connect to " + socket_path + ": " + error);
+    }
+}
+
+InferenceClient::~InferenceClient() {
+    ::close(fd);
+}
+
+Matrix InferenceClient::predict(const Matrix& input) {
+    if (input.getCol() != 1) {
+        throw std::invalid_argument("InferenceClient::predict: Input must be a single column, got " +
+                                    std::to_string(input.getCol()) + " columns.");
+    }
+    Matrix temp_host;
+    const Matrix* src = &input;
+    if (input.is_on_device() && input.get_device_ptr()) { temp_host = input; temp_host.to_host(); src = &temp_host; }
+    send_predict(src->get_host_ptr(), src->getRow());
+    return receive_prediction();
+}
+
+void InferenceClient::send_predict(const double* input, int n) {
+    uint32_t header[2] = {InferenceServer::OP_PREDICT, static_cast<uint32_t>(n)};
+    if (!write_fully(fd, header, sizeof(header)) || !write_fully(fd, input, static_cast<size_t>(n) * sizeof(double))) {
+        throw std::runtime_error("InferenceClient::send_predict: Server closed the connection.");
+    }
+}
+
+Matrix InferenceClient::receive_prediction() {
+    uint32_t header[2];
+    if (!read_fully(fd, header, sizeof(header))) {
+        throw std::runtime_error("InferenceClient::receive_prediction: Server closed the connection.");
+    }
+    if (header[0] != InferenceServer::STATUS_OK) {
+        std::string message(header[1], '\0');
+        read_fully(fd, &message[0], header[1]);
+        throw std::runtime_error("InferenceClient::receive_prediction: Server error: " + message);
+    }
+    Matrix output(static_cast<int>(header[1]), 1, false);
+    if (header[1] > 0 && !read_fully(fd, output.get_host_ptr(), header[1] * sizeof(double))) {
+        throw std::runtime_error("InferenceClient::receive_prediction: Server closed the connection.");
+    }
+    return output;
+}
+
+InferenceServerStats InferenceClient::stats() {
+    uint32_t header[2] = {InferenceServer::OP_STATS, 0};
+    if (!write_fully(fd, header, sizeof(header)) || !read_fully(fd, header, sizeof(header))) {
+        throw std::runtime_error("InferenceClient::stats: Server closed the connection.");
+    }
+    std::vector<double> fields(header[1]);
+    if (header[0] != InferenceServer::STATUS_OK || header[1] != STATS_FIELDS ||
+        !read_fully(fd, fields.data(), fields.size() * sizeof(double))) {
+        throw std::runtime_error("InferenceClient::stats: Malformed stats response.");
+    }
+    InferenceServerStats s;
+    s.requests = static_cast<unsigned long long>(fields[0]);
+    s.batches = static_cast<unsigned long long>(fields[1]);
+    s.rejected = static_cast<unsigned long long>(fields[2]);
+    s.uptime_seconds = fields[3];
+    s.requests_per_second = fields[4];
+    s.mean_batch_size = fields[5];
+    s.mean_queue_us = fields[6];
+    s.max_queue_us = fields[7];
+    s.mean_latency_us = fields[8];
+    s.max_latency_us = fields[9];
+    s.mean_compute_us = fields[10];
+    return s;
+}
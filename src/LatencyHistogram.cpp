@@ -0,0 +1,97 @@
+#include "LatencyHistogram.h"
+#include <stdexcept>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+int highest_bit(uint64_t v) {
+    int bit = 0;
+    while (v >>= 1) ++bit;
+    return bit;
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram(uint64_t max_value, int precision_bits)
+    : precision_bits(precision_bits),
+      max_value(max_value),
+      total(0),
+      min_value(UINT64_MAX),
+      max_recorded(0),
+      sum(0.0)
+{
+    if (precision_bits < 1 || precision_bits > 16) {
+        throw std::invalid_argument("LatencyHistogram: precision_bits must be in [1, 16], got " + std::to_string(precision_bits));
+    }
+    if (max_value < 1) {
+        throw std::invalid_argument("LatencyHistogram: max_value must be positive");
+    }
+    counts.assign(bucket_of(max_value) + 1, 0);
+}
+
+// Exact below 2^(bits + 1). Above, a value with highest bit b lands in the
+// range (b - bits) and keeps its top bits + 1 bits as the sub-bucket.
+size_t LatencyHistogram::bucket_of(uint64_t value) const {
+    uint64_t sub_buckets = 1ULL << precision_bits;
+    if (value < 2 * sub_buckets) return static_cast<size_t>(value);
+    int shift = highest_bit(value) - precision_bits;
+    uint64_t top = value >> shift;
+    return static_cast<size_t>((static_cast<uint64_t>(shift) + 1) * sub_buckets + (top - sub_buckets));
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t bucket) const {
+    uint64_t sub_buckets = 1ULL << precision_bits;
+    if (bucket < 2 * sub_buckets) return static_cast<uint64_t>(bucket);
+    uint64_t shift = bucket / sub_buckets - 1;
+    uint64_t top = bucket % sub_buckets + sub_buckets;
+    return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    value = std::min(value, max_value);
+    counts[bucket_of(value)]++;
+    total++;
+    min_value = std::min(min_value, value);
+    max_recorded = std::max(max_recorded, value);
+    sum += static_cast<double>(value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    if (other.precision_bits != precision_bits || other.max_value != max_value) {
+        throw std::invalid_argument("LatencyHistogram::merge: Histograms have different ranges or precision");
+    }
+    for (size_t b = 0; b < counts.size(); ++b) {
+        counts[b] += other.counts[b];
+    }
+    total += other.total;
+    min_value = std::min(min_value, other.min_value);
+    max_recorded = std::max(max_recorded, other.max_recorded);
+    sum += other.sum;
+}
+
+void LatencyHistogram::reset() {
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    min_value = UINT64_MAX;
+    max_recorded = 0;
+    sum = 0.0;
+}
+
+double LatencyHistogram::mean() const {
+    return total ? sum / static_cast<double>(total) : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double percentile) const {
+    if (total == 0) return 0;
+    double clamped = std::max(0.0, std::min(100.0, percentile));
+    uint64_t rank = static_cast<uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(total)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t b = 0; b < counts.size(); ++b) {
+        seen += counts[b];
+        if (seen >= rank) return std::min(bucket_upper_bound(b), max_recorded);
+    }
+    return max_recorded;
+}
@@ -4,17 +4,67 @@
 #include <iostream>   
 #include <stdexcept>
 #include <utility>    
+#include <atomic>
 
 double randomDouble_for_layer_reverted(double min, double max) { 
     return min + (static_cast<double>(rand()) / RAND_MAX) * (max - min);
 }
 
+namespace {
+
+// The products over active units and non-zero inputs are used when they cover
+// at most this fraction of the dense work, for up to MAX_SPARSE_COLUMNS samples
+// at a time; wider batches rarely have whole zero rows and go to the blocked GEMM.
+const double ACTIVE_WORK_LIMIT = 0.75;
+const int MAX_SPARSE_COLUMNS = 16;
+
+std::atomic<bool> activation_sparsity(true);
+
+// Rows of m with at least one non-zero entry.
+void nonzero_rows(const MatrixView& m, std::vector<int>& rows) {
+    rows.clear();
+    for (int r = 0; r < m.getRow(); ++r) {
+        for (int j = 0; j < m.getCol(); ++j) {
+            if (m(r, j) != 0.0) {
+                rows.push_back(r);
+                break;
+            }
+        }
+    }
+}
+
+bool on_device(const Matrix& m) {
+    return m.is_on_device() && m.get_device_ptr();
+}
+
+} // namespace
+
 Layer::Layer(int inputSize, int outputSize, std::string _activationName)
+    : Layer(inputSize, outputSize, std::move(_activationName), Unfilled())
+{
+    double limit = std::sqrt(6.0 / (static_cast<double>(inputSize) + static_cast<double>(outputSize)));
+    double* w = weights.get_host_ptr();
+    for (size_t i = 0; i < static_cast<size_t>(outputSize) * inputSize; ++i) {
+        w[i] = randomDouble_for_layer_reverted(-limit, limit);
+    }
+}
+
+Layer::Layer(int inputSize, int outputSize, std::string _activationName,
+             const WeightInit& init, const WeightInitializer& rng, uint64_t stream)
+    : Layer(inputSize, outputSize, std::move(_activationName), Unfilled())
+{
+    rng.fill(weights.get_host_ptr(), static_cast<size_t>(outputSize) * inputSize, init, inputSize, outputSize, stream);
+}
+
+Layer::Layer(int inputSize, int outputSize, std::string _activationName, Unfilled)
     : weights(outputSize, inputSize), 
       biases(outputSize, 1),          
       activationName(std::move(_activationName)),
+      activation(activations::parse(activationName)),
       last_input(), 
+      last_sparse_input(inputSize), 
       last_z(),    
+      last_output(),
       grad_weights(outputSize, inputSize, 0.0, false), 
       grad_biases(outputSize, 1, 0.0, false),          
       delta_weights(outputSize, inputSize, 0.0, false), 
@@ -23,22 +73,30 @@ Layer::Layer(int inputSize, int outputSize, std::string _activationName)
     if (inputSize <= 0 || outputSize <= 0) {
         throw std::invalid_argument("Layer input and output sizes must be positive.");
     }
+    reset_biases();
+}
 
-    double limit = std::sqrt(6.0 / (static_cast<double>(inputSize) + static_cast<double>(outputSize)));
-    for (int i = 0; i < weights.getRow(); ++i) {
-        for (int j = 0; j < weights.getCol(); ++j) {
-            weights.setEntry(i, j, randomDouble_for_layer_reverted(-limit, limit));
-        }
-    }
+void Layer::initialize_parameters(const WeightInit& init, const WeightInitializer& rng, uint64_t stream) {
+    if (weights.is_on_device() && weights.get_device_ptr()) weights.to_host();
+    rng.fill(weights.get_host_ptr(), static_cast<size_t>(weights.getRow()) * weights.getCol(), init,
+             weights.getCol(), weights.getRow(), stream);
+    reset_biases();
+}
 
+void Layer::reset_biases() {
     double bias_init_val = 0.0;
     if (this->activationName == "relu") {
         bias_init_val = 0.01;
     }
-    for (int i = 0; i < biases.getRow(); ++i) {
-        for (int j = 0; j < biases.getCol(); ++j) {
-            biases.setEntry(i, j, bias_init_val); 
-        }
+    biases = Matrix(biases.getRow(), 1, bias_init_val);
+}
+
+void Layer::release_activations(bool keep_input) {
+    this->last_z = Matrix();
+    this->last_output = Matrix();
+    if (!keep_input) {
+        this->last_input = Matrix();
+        this->last_sparse_input = SparseMatrix(weights.getCol());
     }
 }
 
@@ -69,43 +127,282 @@ void Layer::update_parameters_from_deltas(double learning_rate, int batch_size)
 Matrix Layer::forward(Matrix& input) {
     this->last_input = input; 
 
-    Matrix weighted = weights.multiply(input); 
-    Matrix z = weighted.add(biases);       
+    Matrix z = (on_device(weights) || on_device(input)) ? weights.multiply(input)
+                                                        : multiply_weights(input.view(), active_inputs);
+    add_biases(z);
     
-    this->last_z = z; 
+    return cache_and_activate(std::move(z)); 
+}
 
-    Matrix activated = activate(z); 
-    
-    return activated; 
+Matrix Layer::forward(const MatrixView& input) {
+    this->last_input = Matrix(input); 
+
+    Matrix z = multiply_weights(input, active_inputs); 
+    add_biases(z);
+
+    return cache_and_activate(std::move(z)); 
+}
+
+Matrix Layer::infer(const MatrixView& input) const {
+    std::vector<int> active;
+    Matrix z = multiply_weights(input, active); 
+    add_biases(z);
+    size_t n = static_cast<size_t>(z.getRow()) * z.getCol();
+    if (n > 0) activations::apply(activation, z.get_host_ptr(), z.get_host_ptr(), n);
+    return z; 
+}
+
+// W x, over only the non-zero rows of x (zero ReLU outputs of the layer below)
+// when there are few enough. Each entry is summed from 0.0 in input order as in
+// Matrix::multiply and the skipped terms are exact zeros, so the result is the
+// same to the bit.
+Matrix Layer::multiply_weights(const MatrixView& input, std::vector<int>& active) const {
+    if (!activation_sparsity.load() || on_device(weights) || input.getRow() != weights.getCol() ||
+        input.getCol() > MAX_SPARSE_COLUMNS) {
+        return Matrix::multiply(weights.view(), input);
+    }
+    nonzero_rows(input, active);
+    if (active.size() > ACTIVE_WORK_LIMIT * input.getRow()) {
+        return Matrix::multiply(weights.view(), input);
+    }
+    MatrixView w = weights.view();
+    int columns = input.getCol();
+    Matrix z(weights.getRow(), columns, 0.0);
+    double* out = z.get_host_ptr();
+    for (int r = 0; r < z.getRow(); ++r) {
+        const double* w_row = w.data() + r * w.getRowStride();
+        double* z_row = out + static_cast<size_t>(r) * columns;
+        for (int j = 0; j < columns; ++j) {
+            double sum = 0.0;
+            for (int c : active) sum += w_row[c] * input(c, j);
+            z_row[j] = sum;
+        }
+    }
+    return z;
+}
+
+void Layer::add_biases(Matrix& z) const {
+    if (z.getRow() != biases.getRow()) {
+        throw std::invalid_argument("Layer::add_biases: Expected " + std::to_string(biases.getRow()) +
+                                    " rows, got " + std::to_string(z.getRow()));
+    }
+    if (z.getRow() == 0 || z.getCol() == 0) return;
+    if (z.is_on_device() && z.get_device_ptr()) z.to_host(); 
+
+    MatrixView b = biases.view();
+    double* z_data = z.get_host_ptr();
+    for (int i = 0; i < z.getRow(); ++i) {
+        double bias = b(i, 0);
+        double* z_row = z_data + static_cast<size_t>(i) * z.getCol();
+        for (int j = 0; j < z.getCol(); ++j) {
+            z_row[j] += bias;
+        }
+    }
+}
+
+Matrix Layer::forward(const SparseMatrix& input) {
+    if (input.getCol() != weights.getCol()) {
+        throw std::invalid_argument("Layer::forward: Sparse input has " + std::to_string(input.getCol()) +
+                                    " features, layer expects " + std::to_string(weights.getCol()));
+    }
+    this->last_input = Matrix(); 
+    this->last_sparse_input = input; 
+
+    Matrix z = input.leftMultiply(weights); 
+    add_biases(z);
+
+    return cache_and_activate(std::move(z)); 
 }
 
 Matrix Layer::activate(Matrix& z_host) const {
-    if (activationName == "relu") return z_host.applyFunction(Layer::relu);
-    if (activationName == "sigmoid") return z_host.applyFunction(Layer::sigmoid);
-    throw std::invalid_argument("Unsupported activation function: " + activationName);
+    if (z_host.is_on_device() && z_host.get_device_ptr()) z_host.to_host(); 
+    Matrix activated(z_host.getRow(), z_host.getCol(), false);
+    size_t n = static_cast<size_t>(z_host.getRow()) * z_host.getCol();
+    if (n > 0) activations::apply(activation, z_host.get_host_ptr(), activated.get_host_ptr(), n);
+    return activated;
 }
 
 Matrix Layer::activatePrime(Matrix& z_values_host) const {
-    if (activationName == "relu") return z_values_host.applyFunction(Layer::reluPrime);
-    if (activationName == "sigmoid") return z_values_host.applyFunction(Layer::sigmoidPrime);
-    throw std::invalid_argument("Unsupported activation function for derivative: " + activationName);
+    if (z_values_host.is_on_device() && z_values_host.get_device_ptr()) z_values_host.to_host(); 
+    Matrix prime(z_values_host.getRow(), z_values_host.getCol(), false);
+    size_t n = static_cast<size_t>(z_values_host.getRow()) * z_values_host.getCol();
+    if (n > 0) activations::derivative(activation, z_values_host.get_host_ptr(), prime.get_host_ptr(), n);
+    return prime;
+}
+
+// Activates z in place and caches what the backward pass needs: the output when
+// the derivative can be computed from it, the pre-activation otherwise.
+Matrix Layer::cache_and_activate(Matrix z) {
+    size_t n = static_cast<size_t>(z.getRow()) * z.getCol();
+    if (activations::derivative_from_output(activation)) {
+        this->last_z = Matrix();
+        if (n > 0) activations::apply(activation, z.get_host_ptr(), z.get_host_ptr(), n);
+        this->last_output = z;
+        return z;
+    }
+    this->last_output = Matrix();
+    this->last_z = z;
+    if (n > 0) activations::apply(activation, z.get_host_ptr(), z.get_host_ptr(), n);
+    return z;
+}
+
+// d_cost/d_z for the last forward pass, fusing f'(z) with the incoming error.
+Matrix Layer::activation_gradient(const Matrix& d_cost_d_activation) const {
+    bool from_output = activations::derivative_from_output(activation);
+    const Matrix& cached = from_output ? this->last_output : this->last_z;
+    if (d_cost_d_activation.getRow() != cached.getRow() || d_cost_d_activation.getCol() != cached.getCol()) {
+        throw std::invalid_argument("Layer::backward: Error is " + std::to_string(d_cost_d_activation.getRow()) + "x" +
+                                    std::to_string(d_cost_d_activation.getCol()) + ", last forward pass produced " +
+                                    std::to_string(cached.getRow()) + "x" + std::to_string(cached.getCol()));
+    }
+    Matrix d_z(cached.getRow(), cached.getCol(), false);
+    size_t n = static_cast<size_t>(cached.getRow()) * cached.getCol();
+    if (n == 0) return d_z;
+
+    Matrix temp_host;
+    const Matrix* grad = &d_cost_d_activation;
+    if (grad->is_on_device() && grad->get_device_ptr()) { temp_host = *grad; temp_host.to_host(); grad = &temp_host; }
+    if (from_output) {
+        activations::gradient_from_output(activation, cached.get_host_ptr(), grad->get_host_ptr(), d_z.get_host_ptr(), n);
+    } else {
+        activations::gradient_from_input(activation, cached.get_host_ptr(), grad->get_host_ptr(), d_z.get_host_ptr(), n);
+    }
+    return d_z;
+}
+
+// Collects the units with a non-zero d_z and the non-zero inputs of the last
+// forward pass; true when the products over them beat the dense ones.
+bool Layer::find_active(const Matrix& d_z) {
+    if (!activation_sparsity.load() || on_device(weights) || on_device(d_z) || on_device(this->last_input) ||
+        d_z.getCol() > MAX_SPARSE_COLUMNS || this->last_input.getRow() != weights.getCol() ||
+        this->last_input.getCol() != d_z.getCol()) {
+        return false;
+    }
+    nonzero_rows(d_z.view(), active_units);
+    nonzero_rows(this->last_input.view(), active_inputs);
+    double work = static_cast<double>(active_units.size()) * active_inputs.size();
+    return work <= ACTIVE_WORK_LIMIT * weights.getRow() * weights.getCol();
+}
+
+// target += d_z * last_input^T at the active units and inputs; the rest of the
+// product is exactly zero. Entries are summed over samples from 0.0 in order,
+// as the dense product does.
+void Layer::add_outer_product(const Matrix& d_z, Matrix& target) const {
+    if (on_device(target)) target.to_host();
+    MatrixView g = d_z.view();
+    MatrixView x = this->last_input.view();
+    double* t = target.get_host_ptr();
+    int columns = d_z.getCol();
+    for (int r : active_units) {
+        double* t_row = t + static_cast<size_t>(r) * target.getCol();
+        for (int c : active_inputs) {
+            double sum = 0.0;
+            for (int j = 0; j < columns; ++j) sum += g(r, j) * x(c, j);
+            t_row[c] += sum;
+        }
+    }
+}
+
+// W^T d_z from the rows of W of the active units, added in unit order from
+// 0.0 like the dense product, without forming W^T.
+Matrix Layer::propagate_error(const Matrix& d_z, bool skip_zero_inputs) const {
+    MatrixView w = weights.view();
+    MatrixView g = d_z.view();
+    int inputs = weights.getCol();
+    int columns = d_z.getCol();
+    Matrix d_prev(inputs, columns, 0.0);
+    double* out = d_prev.get_host_ptr();
+    for (int r : active_units) {
+        const double* w_row = w.data() + r * w.getRowStride();
+        for (int j = 0; j < columns; ++j) {
+            double scale = g(r, j);
+            if (skip_zero_inputs) {
+                for (int c : active_inputs) out[static_cast<size_t>(c) * columns + j] += w_row[c] * scale;
+            } else if (columns == 1) {
+                for (int c = 0; c < inputs; ++c) out[c] += w_row[c] * scale;
+            } else {
+                for (int c = 0; c < inputs; ++c) out[static_cast<size_t>(c) * columns + j] += w_row[c] * scale;
+            }
+        }
+    }
+    return d_prev;
 }
 
 Matrix Layer::backward(const Matrix& d_cost_d_activation_from_next_layer) {
-    Matrix activation_grad = activatePrime(this->last_z); 
-    Matrix d_z = d_cost_d_activation_from_next_layer.multiplyElements(activation_grad); 
+    Matrix d_z = activation_gradient(d_cost_d_activation_from_next_layer); 
+
+    this->grad_biases = (d_z.getCol() == 1) ? d_z : sum_columns(d_z); 
+
+    if (find_active(d_z)) {
+        this->grad_weights = Matrix(weights.getRow(), weights.getCol(), 0.0, false);
+        add_outer_product(d_z, this->grad_weights);
+        return propagate_error(d_z, false);
+    }
 
     Matrix last_input_T = this->last_input.transpose(); 
     this->grad_weights = d_z.multiply(last_input_T); 
 
-    this->grad_biases = d_z; 
-
     Matrix weights_T = this->weights.transpose(); 
     Matrix d_activation_prev = weights_T.multiply(d_z); 
     
     return d_activation_prev; 
 }
 
+Matrix Layer::backward_accumulate(const Matrix& d_cost_d_activation_from_next_layer, bool skip_zero_inputs) {
+    Matrix d_z = activation_gradient(d_cost_d_activation_from_next_layer); 
+
+    this->grad_biases = (d_z.getCol() == 1) ? d_z : sum_columns(d_z); 
+    this->delta_biases = this->delta_biases.add(this->grad_biases); 
+
+    if (find_active(d_z)) {
+        add_outer_product(d_z, this->delta_weights);
+        return propagate_error(d_z, skip_zero_inputs);
+    }
+
+    Matrix last_input_T = this->last_input.transpose(); 
+    this->grad_weights = d_z.multiply(last_input_T); 
+    this->delta_weights = this->delta_weights.add(this->grad_weights); 
+
+    Matrix weights_T = this->weights.transpose(); 
+    return weights_T.multiply(d_z); 
+}
+
+// Gradient step for a first layer fed by sparse input: weight gradients are added
+// straight into delta_weights for the non-zero input columns only, and no error is
+// propagated since there is no previous layer.
+void Layer::backward_sparse(const Matrix& d_cost_d_activation_from_next_layer) {
+    Matrix d_z = activation_gradient(d_cost_d_activation_from_next_layer); 
+
+    this->last_sparse_input.accumulateOuterProduct(d_z, this->delta_weights); 
+
+    this->grad_biases = sum_columns(d_z); 
+    this->delta_biases = this->delta_biases.add(this->grad_biases); 
+}
+
+void Layer::setActivationSparsity(bool enabled) {
+    activation_sparsity.store(enabled);
+}
+
+bool Layer::getActivationSparsity() {
+    return activation_sparsity.load();
+}
+
+Matrix Layer::sum_columns(const Matrix& m) {
+    Matrix sums(m.getRow(), 1, 0.0, false);
+    if (m.getRow() == 0 || m.getCol() == 0) return sums;
+
+    MatrixView v = m.view();
+    double* out = sums.get_host_ptr();
+    for (int i = 0; i < v.getRow(); ++i) {
+        double sum = 0.0;
+        for (int j = 0; j < v.getCol(); ++j) {
+            sum += v(i, j);
+        }
+        out[i] = sum;
+    }
+    return sums;
+}
+
 double Layer::sigmoid(double x) { return 1.0 / (1.0 + std::exp(-x)); }
 double Layer::sigmoidPrime(double x) { double s = Layer::sigmoid(x); return s * (1.0 - s); }
 double Layer::relu(double x) { return x > 0 ? x : 0.0; }
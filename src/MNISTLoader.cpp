@@ -1,59 +1,65 @@
 #include "MNISTLoader.h"
+#include "IdxReader.h"
 #include <stdexcept> 
 #include <iostream>  
 #include <vector>    
 
-int32_t MNISTLoader::read_int_big_endian(std::ifstream& ifs) {
-    int32_t val = 0;
-    unsigned char bytes[4];
-    if (!ifs.read(reinterpret_cast<char*>(bytes), 4)) {
-        throw std::runtime_error("MNISTLoader: Failed to read 4 bytes for integer.");
+namespace {
+
+// Images may be any IDX type of rank >= 2 (N x rows [x cols ...]); trailing
+// dimensions after the row count are flattened into the column count.
+void read_image_header(const IdxReader& reader, int& number_of_images, int& image_rows, int& image_cols) {
+    if (reader.rank() < 2) {
+        throw std::runtime_error("MNISTLoader: Image file " + reader.path() + " has rank " + std::to_string(reader.rank()) +
+                                 ", expected at least 2");
+    }
+    number_of_images = reader.dims()[0];
+    image_rows = reader.dims()[1];
+    long long cols = 1;
+    for (int d = 2; d < reader.rank(); ++d) cols *= reader.dims()[static_cast<size_t>(d)];
+    if (static_cast<long long>(image_rows) * cols > 0x7fffffffLL) {
+        throw std::runtime_error("MNISTLoader: Images too large in " + reader.path());
     }
-    val = (static_cast<int32_t>(bytes[0]) << 24) |
-          (static_cast<int32_t>(bytes[1]) << 16) |
-          (static_cast<int32_t>(bytes[2]) << 8)  |
-          (static_cast<int32_t>(bytes[3]));
-    return val;
+    image_cols = static_cast<int>(cols);
 }
 
-std::vector<Matrix> MNISTLoader::load_images(const std::string& path, int& number_of_images, int& image_rows, int& image_cols, int max_items_to_load) {
-    std::ifstream ifs(path, std::ios::binary);
-    if (!ifs.is_open()) {
-        throw std::runtime_error("MNISTLoader: Cannot open image file: " + path);
-    }
+int items_to_load(int available, int max_items_to_load) {
+    return (max_items_to_load > 0 && max_items_to_load < available) ? max_items_to_load : available;
+}
 
-    int32_t magic_number = read_int_big_endian(ifs);
-    if (magic_number != 0x00000803) { 
-        throw std::runtime_error("MNISTLoader: Invalid magic number in image file: " + path + ". Expected 2051, got " + std::to_string(magic_number));
-    }
+std::string describe(const IdxReader& reader) {
+    return reader.path() + (reader.compressed() ? " (gzip)" : "");
+}
 
-    number_of_images = read_int_big_endian(ifs);
-    image_rows = read_int_big_endian(ifs);
-    image_cols = read_int_big_endian(ifs);
+} // namespace
 
-    int items_to_read = number_of_images;
-    if (max_items_to_load > 0 && max_items_to_load < number_of_images) {
-        items_to_read = max_items_to_load;
-        number_of_images = items_to_read; 
-    }
+// UInt8 images are scaled to [0, 1]; other element types are used as stored.
+std::vector<Matrix> MNISTLoader::load_images(const std::string& path, int& number_of_images, int& image_rows, int& image_cols, int max_items_to_load) {
+    IdxReader reader(IdxReader::resolve(path));
+    read_image_header(reader, number_of_images, image_rows, image_cols);
+
+    int items_to_read = items_to_load(number_of_images, max_items_to_load);
+    number_of_images = items_to_read;
     
     std::cout << "Loading " << items_to_read << " images (" 
-              << image_rows << "x" << image_cols << ") from " << path << std::endl;
+              << image_rows << "x" << image_cols << ") from " << describe(reader) << std::endl;
 
     std::vector<Matrix> images_data;
     images_data.reserve(items_to_read);
 
     int image_size = image_rows * image_cols;
-    std::vector<unsigned char> buffer(image_size);
+    bool bytes = reader.type() == IdxType::UInt8;
+    std::vector<unsigned char> buffer(bytes ? image_size : 0);
 
     for (int i = 0; i < items_to_read; ++i) {
-        if (!ifs.read(reinterpret_cast<char*>(buffer.data()), image_size)) {
-            throw std::runtime_error("MNISTLoader: Failed to read image data for image " + std::to_string(i) + " from " + path);
-        }
-
         Matrix image_matrix(image_size, 1); 
-        for (int j = 0; j < image_size; ++j) {
-            image_matrix.setEntry(j, 0, static_cast<double>(buffer[j]) / 255.0);
+        if (bytes) {
+            reader.read_bytes(buffer.data(), buffer.size());
+            for (int j = 0; j < image_size; ++j) {
+                image_matrix.setEntry(j, 0, static_cast<double>(buffer[j]) / 255.0);
+            }
+        } else {
+            reader.read_values(image_matrix.get_host_ptr(), static_cast<size_t>(image_size));
         }
         images_data.push_back(image_matrix);
 
@@ -61,52 +67,70 @@ std::vector<Matrix> MNISTLoader::load_images(const std::string& path, int& numbe
             std::cout << "Loaded " << (i + 1) << "/" << items_to_read << " images..." << std::endl;
         }
     }
-    ifs.close();
     return images_data;
 }
 
-std::vector<Matrix> MNISTLoader::load_labels(const std::string& path, int& number_of_labels, int max_items_to_load) {
-    std::ifstream ifs(path, std::ios::binary);
-    if (!ifs.is_open()) {
-        throw std::runtime_error("MNISTLoader: Cannot open label file: " + path);
-    }
+SparseMatrix MNISTLoader::load_images_sparse(const std::string& path, int& number_of_images, int& image_rows, int& image_cols, int max_items_to_load) {
+    IdxReader reader(IdxReader::resolve(path));
+    read_image_header(reader, number_of_images, image_rows, image_cols);
+
+    int items_to_read = items_to_load(number_of_images, max_items_to_load);
+    number_of_images = items_to_read;
+
+    std::cout << "Loading " << items_to_read << " sparse images (" 
+              << image_rows << "x" << image_cols << ") from " << describe(reader) << std::endl;
+
+    int image_size = image_rows * image_cols;
+    SparseMatrix images_data(image_size);
+    images_data.reserve(static_cast<size_t>(items_to_read), static_cast<size_t>(items_to_read) * image_size / 4);
 
-    int32_t magic_number = read_int_big_endian(ifs);
-    if (magic_number != 0x00000801) { 
-        throw std::runtime_error("MNISTLoader: Invalid magic number in label file: " + path + ". Expected 2049, got " + std::to_string(magic_number));
+    bool bytes = reader.type() == IdxType::UInt8;
+    std::vector<unsigned char> buffer(bytes ? image_size : 0);
+    std::vector<double> values(bytes ? 0 : image_size);
+
+    for (int i = 0; i < items_to_read; ++i) {
+        if (bytes) {
+            reader.read_bytes(buffer.data(), buffer.size());
+            images_data.appendRow(buffer.data(), image_size, 1.0 / 255.0);
+        } else {
+            reader.read_values(values.data(), values.size());
+            images_data.appendRow(values.data(), image_size);
+        }
+
+        if ((i + 1) % 10000 == 0 && items_to_read > 10000) {
+            std::cout << "Loaded " << (i + 1) << "/" << items_to_read << " images..." << std::endl;
+        }
     }
+    return images_data;
+}
 
-    number_of_labels = read_int_big_endian(ifs);
-    
-    int items_to_read = number_of_labels;
-    if (max_items_to_load > 0 && max_items_to_load < number_of_labels) {
-        items_to_read = max_items_to_load;
-        number_of_labels = items_to_read; 
+std::vector<Matrix> MNISTLoader::load_labels(const std::string& path, int& number_of_labels, int max_items_to_load) {
+    IdxReader reader(IdxReader::resolve(path));
+    if (reader.rank() != 1 || reader.type() == IdxType::Float32 || reader.type() == IdxType::Float64) {
+        throw std::runtime_error("MNISTLoader: Label file " + reader.path() + " must be a rank-1 integer IDX file, got magic number " +
+                                 std::to_string(reader.magic()));
     }
 
-    std::cout << "Loading " << items_to_read << " labels from " << path << std::endl;
+    int items_to_read = items_to_load(reader.dims()[0], max_items_to_load);
+    number_of_labels = items_to_read;
+
+    std::cout << "Loading " << items_to_read << " labels from " << describe(reader) << std::endl;
+
+    std::vector<double> label_values(static_cast<size_t>(items_to_read));
+    reader.read_values(label_values.data(), label_values.size());
 
     std::vector<Matrix> labels_data;
     labels_data.reserve(items_to_read);
-    unsigned char label_buffer;
-
     for (int i = 0; i < items_to_read; ++i) {
-        if (!ifs.read(reinterpret_cast<char*>(&label_buffer), 1)) {
-            throw std::runtime_error("MNISTLoader: Failed to read label data for label " + std::to_string(i) + " from " + path);
-        }
-
+        int label = static_cast<int>(label_values[static_cast<size_t>(i)]);
         Matrix label_matrix(10, 1, 0.0); 
-        if (static_cast<int>(label_buffer) >= 0 && static_cast<int>(label_buffer) < 10) {
-            label_matrix.setEntry(static_cast<int>(label_buffer), 0, 1.0); 
+        if (label >= 0 && label < 10) {
+            label_matrix.setEntry(label, 0, 1.0); 
         } else {
-            std::cerr << "Warning: Invalid label " << static_cast<int>(label_buffer) << " encountered at index " << i << std::endl;
+            std::cerr << "Warning: Invalid label " << label << " encountered at index " << i << std::endl;
         }
         labels_data.push_back(label_matrix);
-         if ((i + 1) % 10000 == 0 && items_to_read > 10000) {
-            std::cout << "Loaded " << (i + 1) << "/" << items_to_read << " labels..." << std::endl;
-        }
     }
-    ifs.close();
     return labels_data;
 }
 
@@ -133,4 +157,26 @@ MNISTDataset MNISTLoader::load(const std::string& image_path, const std::string&
     }
 
     return dataset;
-}
\ No newline at end of file
+}
+
+MNISTSparseDataset MNISTLoader::load_sparse(const std::string& image_path, const std::string& label_path, int max_items) {
+    MNISTSparseDataset dataset;
+    dataset.images = load_images_sparse(image_path, dataset.number_of_items, dataset.image_rows, dataset.image_cols, max_items);
+
+    int num_labels_temp; 
+    dataset.labels = load_labels(label_path, num_labels_temp, max_items);
+
+    if (static_cast<size_t>(dataset.images.getRow()) != dataset.labels.size()) {
+        throw std::runtime_error("MNISTLoader: Mismatch between number of loaded images (" + std::to_string(dataset.images.getRow()) +
+                                 ") and labels (" + std::to_string(dataset.labels.size()) + ").");
+    }
+    dataset.number_of_items = dataset.images.getRow();
+
+    double density = (dataset.number_of_items > 0 && dataset.images.getCol() > 0)
+        ? static_cast<double>(dataset.images.nonZeros()) / (static_cast<double>(dataset.number_of_items) * dataset.images.getCol())
+        : 0.0;
+    std::cout << "Successfully loaded " << dataset.number_of_items << " sparse image-label pairs ("
+              << dataset.images.nonZeros() << " non-zeros, density " << density * 100.0 << "%)." << std::endl;
+
+    return dataset;
+}
@@ -5,6 +5,33 @@
 #include <iomanip>
 #include <stdexcept>
 #include <algorithm> 
+#include <map>
+#include <tuple>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+namespace {
+typedef std::map<std::tuple<int, int, int>, GemmBlocking> GemmTable;
+
+// Readers load the current table without locking, so replaced tables are
+// kept alive until exit rather than freed under a concurrent multiply.
+std::atomic<const GemmTable*> gemm_table(nullptr);
+std::mutex gemm_table_mutex;
+std::vector<std::unique_ptr<const GemmTable> > gemm_tables;
+
+void check_gemm_blocking(const GemmBlocking& blocking, const char* where) {
+    if (blocking.block_m < 0 || blocking.block_k <= 0 || blocking.block_n <= 0) {
+        throw std::invalid_argument(std::string(where) + ": Invalid blocking " + std::to_string(blocking.block_m) + "/" +
+                                    std::to_string(blocking.block_k) + "/" + std::to_string(blocking.block_n));
+    }
+}
+
+void publish_gemm_table(GemmTable* table) {
+    gemm_tables.emplace_back(table);
+    gemm_table.store(table, std::memory_order_release);
+}
+}
 
 cublasHandle_t Matrix::cublas_handle = nullptr;
 bool Matrix::cublas_initialized = false;
@@ -64,6 +91,22 @@ Matrix::Matrix(int r, int c, double val, bool on_gpu_default)
     }
 }
 
+Matrix::Matrix(const MatrixView& view)
+    : rows_val(view.getRow()), cols_val(view.getCol()), d_data(nullptr), data_on_device(false) {
+    if (view.is_empty()) return;
+
+    allocate_host_memory();
+    if (view.is_contiguous()) {
+        std::copy(view.data(), view.data() + h_data.size(), h_data.begin());
+        return;
+    }
+    for (int i = 0; i < rows_val; ++i) {
+        for (int j = 0; j < cols_val; ++j) {
+            h_data[static_cast<size_t>(i) * cols_val + j] = view(i, j);
+        }
+    }
+}
+
 Matrix::~Matrix() {
     free_device_memory();
 }
@@ -233,6 +276,30 @@ void Matrix::setEntry(int r, int c, double entry) {
     data_on_device = false; 
 }
 
+MatrixView Matrix::view() const {
+    if (h_data.empty() && rows_val > 0 && cols_val > 0) {
+        throw std::runtime_error("Matrix::view: Host data not initialized for non-empty matrix. Call to_host() if data is on device.");
+    }
+    return MatrixView(h_data.empty() ? nullptr : h_data.data(), rows_val, cols_val);
+}
+
+void Matrix::reshape(int r, int c) {
+    if (r < 0 || c < 0 || static_cast<long long>(r) * c != static_cast<long long>(rows_val) * cols_val) {
+        throw std::invalid_argument("Matrix::reshape: Cannot reshape " + std::to_string(rows_val) + "x" + std::to_string(cols_val) +
+                                    " to " + std::to_string(r) + "x" + std::to_string(c));
+    }
+    rows_val = r;
+    cols_val = c;
+}
+
+double* Matrix::get_host_ptr() {
+    if (h_data.empty()) {
+        return nullptr;
+    }
+    data_on_device = false; 
+    return h_data.data();
+}
+
 void Matrix::display() const {
     if (data_on_device && (rows_val > 0 && cols_val > 0)) {
         std::cout << "(Note: Displaying host data. Call to_host() to ensure it's up-to-date if recent ops were on GPU)" << std::endl;
@@ -278,9 +345,8 @@ Matrix Matrix::multiply(const Matrix& m) const {
         return zero_result;
     }
 
-    Matrix result(rows_val, m.cols_val); 
-
     if (this->data_on_device && this->d_data && m.data_on_device && m.d_data && Matrix::cublas_initialized) {
+        Matrix result(rows_val, m.cols_val); 
         result.to_device(); 
 
         const double alpha = 1.0;
@@ -291,6 +357,7 @@ Matrix Matrix::multiply(const Matrix& m) const {
                                  &alpha, m.d_data, m.cols_val, this->d_data, this->cols_val,  
                                  &beta, result.d_data, result.cols_val));
         result.data_on_device = true; 
+        return result;
 
     } else { 
         Matrix temp_lhs; 
@@ -309,28 +376,11 @@ Matrix Matrix::multiply(const Matrix& m) const {
             rhs = &temp_rhs;
         }
         
-        if(result.rows_val > 0 && result.cols_val > 0 && result.h_data.empty()){
-            result.allocate_host_memory(); 
-        } else if (result.rows_val == 0 || result.cols_val == 0) {
-            result.h_data.clear(); 
-        }
+        if (lhs->h_data.empty() && (lhs->rows_val > 0 && lhs->cols_val > 0)) throw std::runtime_error("LHS h_data empty in CPU multiply");
+        if (rhs->h_data.empty() && (rhs->rows_val > 0 && rhs->cols_val > 0)) throw std::runtime_error("RHS h_data empty in CPU multiply");
 
-        for (int i = 0; i < result.rows_val; i++) {
-            for (int j = 0; j < result.cols_val; j++) {
-                double vectorProd = 0.0;
-                for (int k_inner = 0; k_inner < lhs->cols_val; k_inner++) { 
-                    if (lhs->h_data.empty() && (lhs->rows_val > 0 && lhs->cols_val > 0)) throw std::runtime_error("LHS h_data empty in CPU multiply");
-                    if (rhs->h_data.empty() && (rhs->rows_val > 0 && rhs->cols_val > 0)) throw std::runtime_error("RHS h_data empty in CPU multiply");
-                    vectorProd += lhs->h_data[static_cast<size_t>(i) * lhs->cols_val + k_inner] * rhs->h_data[static_cast<size_t>(k_inner) * rhs->cols_val + j];
-                }
-                if (!result.h_data.empty()) { 
-                    result.h_data[static_cast<size_t>(i) * result.cols_val + j] = vectorProd;
-                }
-            }
-        }
-        result.data_on_device = false; 
+        return Matrix::multiply(lhs->view(), rhs->view());
     }
-    return result;
 }
 
 Matrix Matrix::applyFunction(double (*f)(double x)) {
@@ -345,13 +395,9 @@ Matrix Matrix::applyFunction(double (*f)(double x)) {
         throw std::runtime_error("Matrix::applyFunction: Host data is empty for non-empty matrix. Call to_host() if data is on device.");
     }
     
-    Matrix result(rows_val, cols_val, false); 
-    if (rows_val == 0 || cols_val == 0) return result; 
+    if (rows_val == 0 || cols_val == 0) return Matrix(rows_val, cols_val, false); 
 
-    for (size_t i = 0; i < current_this->h_data.size(); ++i) {
-        result.h_data[i] = f(current_this->h_data[i]);
-    }
-    return result;
+    return Matrix::applyFunction(current_this->view(), f);
 }
 
 Matrix Matrix::add(const Matrix& m) const {
@@ -360,8 +406,7 @@ Matrix Matrix::add(const Matrix& m) const {
             std::to_string(rows_val) + "x" + std::to_string(cols_val) + " RHS:" +
             std::to_string(m.rows_val) + "x" + std::to_string(m.cols_val));
     }
-    Matrix result(rows_val, cols_val, false); 
-    if (rows_val == 0 || cols_val == 0) return result;
+    if (rows_val == 0 || cols_val == 0) return Matrix(rows_val, cols_val, false);
 
     Matrix temp_lhs; 
     Matrix temp_rhs; 
@@ -375,18 +420,14 @@ Matrix Matrix::add(const Matrix& m) const {
     else if (m.h_data.empty() && (m.rows_val > 0 && m.cols_val > 0)) { throw std::runtime_error("Matrix::add (RHS): Host data empty.");}
 
 
-    for (size_t i = 0; i < lhs->h_data.size(); ++i) {
-        result.h_data[i] = lhs->h_data[i] + rhs->h_data[i];
-    }
-    return result;
+    return Matrix::add(lhs->view(), rhs->view());
 }
 
 Matrix Matrix::subtract(const Matrix& m) const {
      if (cols_val != m.cols_val || rows_val != m.rows_val) {
         throw std::invalid_argument("Matrix::subtract: Dimensions not compatible.");
     }
-    Matrix result(rows_val, cols_val, false); 
-    if (rows_val == 0 || cols_val == 0) return result;
+    if (rows_val == 0 || cols_val == 0) return Matrix(rows_val, cols_val, false);
 
     Matrix temp_lhs; 
     Matrix temp_rhs; 
@@ -399,18 +440,14 @@ Matrix Matrix::subtract(const Matrix& m) const {
     if (m.data_on_device && m.d_data) { temp_rhs = m; temp_rhs.to_host(); rhs = &temp_rhs; }
     else if (m.h_data.empty() && (m.rows_val > 0 && m.cols_val > 0)) { throw std::runtime_error("Matrix::subtract (RHS): Host data empty.");}
 
-    for (size_t i = 0; i < lhs->h_data.size(); ++i) {
-        result.h_data[i] = lhs->h_data[i] - rhs->h_data[i];
-    }
-    return result;
+    return Matrix::subtract(lhs->view(), rhs->view());
 }
 
 Matrix Matrix::multiplyElements(const Matrix& m) const {
      if (cols_val != m.cols_val || rows_val != m.rows_val) {
         throw std::invalid_argument("Matrix::multiplyElements: Dimensions not compatible.");
     }
-    Matrix result(rows_val, cols_val, false); 
-    if (rows_val == 0 || cols_val == 0) return result;
+    if (rows_val == 0 || cols_val == 0) return Matrix(rows_val, cols_val, false);
 
     Matrix temp_lhs; 
     Matrix temp_rhs; 
@@ -424,15 +461,11 @@ Matrix Matrix::multiplyElements(const Matrix& m) const {
     else if (m.h_data.empty() && (m.rows_val > 0 && m.cols_val > 0)) { throw std::runtime_error("Matrix::multiplyElements (RHS): Host data empty.");}
 
 
-    for (size_t i = 0; i < lhs->h_data.size(); ++i) {
-        result.h_data[i] = lhs->h_data[i] * rhs->h_data[i];
-    }
-    return result;
+    return Matrix::multiplyElements(lhs->view(), rhs->view());
 }
 
 Matrix Matrix::multiplyScalar(double scalar) const {
-    Matrix result(rows_val, cols_val, false); 
-    if (rows_val == 0 || cols_val == 0) return result;
+    if (rows_val == 0 || cols_val == 0) return Matrix(rows_val, cols_val, false);
     
     Matrix temp_this_storage; 
     const Matrix* current_this = this;
@@ -440,15 +473,11 @@ Matrix Matrix::multiplyScalar(double scalar) const {
     else if (this->h_data.empty() && (this->rows_val > 0 && this->cols_val > 0)) { throw std::runtime_error("Matrix::multiplyScalar: Host data empty.");}
 
 
-    for (size_t i = 0; i < current_this->h_data.size(); ++i) {
-        result.h_data[i] = current_this->h_data[i] * scalar;
-    }
-    return result;
+    return Matrix::multiplyScalar(current_this->view(), scalar);
 }
 
 Matrix Matrix::transpose() const {
-    Matrix result(cols_val, rows_val, false); 
-    if (rows_val == 0 || cols_val == 0) return result;
+    if (rows_val == 0 || cols_val == 0) return Matrix(cols_val, rows_val, false);
 
     Matrix temp_this_storage; 
     const Matrix* current_this = this;
@@ -456,10 +485,195 @@ Matrix Matrix::transpose() const {
     else if (this->h_data.empty() && (this->rows_val > 0 && this->cols_val > 0)) { throw std::runtime_error("Matrix::transpose: Host data empty.");}
 
 
-    for (int i = 0; i < current_this->rows_val; ++i) {
-        for (int j = 0; j < current_this->cols_val; ++j) {
-            result.h_data[static_cast<size_t>(j) * result.cols_val + i] = current_this->h_data[static_cast<size_t>(i) * current_this->cols_val + j];
+    return Matrix::transpose(current_this->view());
+}
+
+GemmBlocking Matrix::gemmBlocking(int m, int k, int n) {
+    const GemmTable* table = gemm_table.load(std::memory_order_acquire);
+    if (table) {
+        GemmTable::const_iterator it = table->find(std::make_tuple(m, k, n));
+        if (it != table->end()) return it->second;
+    }
+    return GemmBlocking();
+}
+
+void Matrix::setGemmBlocking(int m, int k, int n, const GemmBlocking& blocking) {
+    check_gemm_blocking(blocking, "Matrix::setGemmBlocking");
+    std::lock_guard<std::mutex> lock(gemm_table_mutex);
+    const GemmTable* current = gemm_table.load(std::memory_order_acquire);
+    GemmTable* table = current ? new GemmTable(*current) : new GemmTable();
+    (*table)[std::make_tuple(m, k, n)] = blocking;
+    publish_gemm_table(table);
+}
+
+void Matrix::clearGemmBlocking() {
+    std::lock_guard<std::mutex> lock(gemm_table_mutex);
+    publish_gemm_table(new GemmTable());
+}
+
+Matrix Matrix::multiply(const MatrixView& lhs, const MatrixView& rhs) {
+    return multiply(lhs, rhs, gemmBlocking(lhs.getRow(), lhs.getCol(), rhs.getCol()));
+}
+
+Matrix Matrix::multiply(const MatrixView& lhs, const MatrixView& rhs, const GemmBlocking& blocking) {
+    check_gemm_blocking(blocking, "Matrix::multiply");
+    if (lhs.getCol() != rhs.getRow()) {
+        throw std::invalid_argument("Matrix::multiply: Dimensions not compatible. LHS: " +
+                                    std::to_string(lhs.getRow()) + "x" + std::to_string(lhs.getCol()) + ", RHS: " +
+                                    std::to_string(rhs.getRow()) + "x" + std::to_string(rhs.getCol()));
+    }
+    Matrix result(lhs.getRow(), rhs.getCol(), 0.0);
+    if (result.rows_val == 0 || result.cols_val == 0 || lhs.getCol() == 0) return result;
+
+    int inner = lhs.getCol();
+    int n = result.cols_val;
+    if (rhs.has_unit_col_stride() && n > 1) {
+        // i-k-j over block_k x block_n panels of rhs so the panel stays in cache
+        // across a block_m band of lhs rows. k blocks run in order, so every
+        // entry is still summed in k order.
+        int block_m = blocking.block_m > 0 ? blocking.block_m : result.rows_val;
+        for (int i0 = 0; i0 < result.rows_val; i0 += block_m) {
+            int i1 = std::min(result.rows_val, i0 + block_m);
+            for (int j0 = 0; j0 < n; j0 += blocking.block_n) {
+                int j1 = std::min(n, j0 + blocking.block_n);
+                for (int k0 = 0; k0 < inner; k0 += blocking.block_k) {
+                    int k1 = std::min(inner, k0 + blocking.block_k);
+                    for (int i = i0; i < i1; i++) {
+                        double* c_row = &result.h_data[static_cast<size_t>(i) * n];
+                        for (int k_inner = k0; k_inner < k1; k_inner++) {
+                            double a_ik = lhs(i, k_inner);
+                            const double* b_row = rhs.data() + k_inner * rhs.getRowStride();
+                            for (int j = j0; j < j1; j++) {
+                                c_row[j] += a_ik * b_row[j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    } else {
+        for (int i = 0; i < result.rows_val; i++) {
+            for (int j = 0; j < n; j++) {
+                double vectorProd = 0.0;
+                for (int k_inner = 0; k_inner < inner; k_inner++) {
+                    vectorProd += lhs(i, k_inner) * rhs(k_inner, j);
+                }
+                result.h_data[static_cast<size_t>(i) * n + j] = vectorProd;
+            }
+        }
+    }
+    return result;
+}
+
+Matrix Matrix::add(const MatrixView& lhs, const MatrixView& rhs) {
+    if (lhs.getCol() != rhs.getCol() || lhs.getRow() != rhs.getRow()) {
+        throw std::invalid_argument("Matrix::add: Dimensions not compatible. LHS:" +
+            std::to_string(lhs.getRow()) + "x" + std::to_string(lhs.getCol()) + " RHS:" +
+            std::to_string(rhs.getRow()) + "x" + std::to_string(rhs.getCol()));
+    }
+    Matrix result(lhs.getRow(), lhs.getCol(), false);
+    if (lhs.is_empty()) return result;
+
+    if (lhs.is_contiguous() && rhs.is_contiguous()) {
+        const double* a = lhs.data();
+        const double* b = rhs.data();
+        for (size_t i = 0; i < result.h_data.size(); ++i) {
+            result.h_data[i] = a[i] + b[i];
+        }
+        return result;
+    }
+    for (int i = 0; i < result.rows_val; ++i) {
+        for (int j = 0; j < result.cols_val; ++j) {
+            result.h_data[static_cast<size_t>(i) * result.cols_val + j] = lhs(i, j) + rhs(i, j);
+        }
+    }
+    return result;
+}
+
+Matrix Matrix::subtract(const MatrixView& lhs, const MatrixView& rhs) {
+    if (lhs.getCol() != rhs.getCol() || lhs.getRow() != rhs.getRow()) {
+        throw std::invalid_argument("Matrix::subtract: Dimensions not compatible.");
+    }
+    Matrix result(lhs.getRow(), lhs.getCol(), false);
+    if (lhs.is_empty()) return result;
+
+    if (lhs.is_contiguous() && rhs.is_contiguous()) {
+        const double* a = lhs.data();
+        const double* b = rhs.data();
+        for (size_t i = 0; i < result.h_data.size(); ++i) {
+            result.h_data[i] = a[i] - b[i];
+        }
+        return result;
+    }
+    for (int i = 0; i < result.rows_val; ++i) {
+        for (int j = 0; j < result.cols_val; ++j) {
+            result.h_data[static_cast<size_t>(i) * result.cols_val + j] = lhs(i, j) - rhs(i, j);
         }
     }
     return result;
-}
\ No newline at end of file
+}
+
+Matrix Matrix::multiplyElements(const MatrixView& lhs, const MatrixView& rhs) {
+    if (lhs.getCol() != rhs.getCol() || lhs.getRow() != rhs.getRow()) {
+        throw std::invalid_argument("Matrix::multiplyElements: Dimensions not compatible.");
+    }
+    Matrix result(lhs.getRow(), lhs.getCol(), false);
+    if (lhs.is_empty()) return result;
+
+    if (lhs.is_contiguous() && rhs.is_contiguous()) {
+        const double* a = lhs.data();
+        const double* b = rhs.data();
+        for (size_t i = 0; i < result.h_data.size(); ++i) {
+            result.h_data[i] = a[i] * b[i];
+        }
+        return result;
+    }
+    for (int i = 0; i < result.rows_val; ++i) {
+        for (int j = 0; j < result.cols_val; ++j) {
+            result.h_data[static_cast<size_t>(i) * result.cols_val + j] = lhs(i, j) * rhs(i, j);
+        }
+    }
+    return result;
+}
+
+Matrix Matrix::multiplyScalar(const MatrixView& m, double scalar) {
+    Matrix result(m.getRow(), m.getCol(), false);
+    if (m.is_empty()) return result;
+
+    if (m.is_contiguous()) {
+        const double* a = m.data();
+        for (size_t i = 0; i < result.h_data.size(); ++i) {
+            result.h_data[i] = a[i] * scalar;
+        }
+        return result;
+    }
+    for (int i = 0; i < result.rows_val; ++i) {
+        for (int j = 0; j < result.cols_val; ++j) {
+            result.h_data[static_cast<size_t>(i) * result.cols_val + j] = m(i, j) * scalar;
+        }
+    }
+    return result;
+}
+
+Matrix Matrix::transpose(const MatrixView& m) {
+    return Matrix(m.transpose());
+}
+
+Matrix Matrix::applyFunction(const MatrixView& m, double (*f)(double x)) {
+    Matrix result(m.getRow(), m.getCol(), false);
+    if (m.is_empty()) return result;
+
+    if (m.is_contiguous()) {
+        const double* a = m.data();
+        for (size_t i = 0; i < result.h_data.size(); ++i) {
+            result.h_data[i] = f(a[i]);
+        }
+        return result;
+    }
+    for (int i = 0; i < result.rows_val; ++i) {
+        for (int j = 0; j < result.cols_val; ++j) {
+            result.h_data[static_cast<size_t>(i) * result.cols_val + j] = f(m(i, j));
+        }
+    }
+    return result;
+}
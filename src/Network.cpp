@@ -5,7 +5,8 @@
 #include <string>   
 #include <iomanip> 
 
-Network::Network(const std::vector<int>& layerSizes, const std::vector<std::string>& activations) {
+Network::Network(const std::vector<int>& layerSizes, const std::vector<std::string>& activations)
+    : checkpoint_interval(1) {
     if (activations.size() != layerSizes.size() - 1) {
         throw std::invalid_argument("Mismatch in layer sizes and activations.");
     }
@@ -17,11 +18,116 @@ Network::Network(const std::vector<int>& layerSizes, const std::vector<std::stri
     }
 }
 
+Network::Network(const std::vector<int>& layerSizes, const std::vector<std::string>& activations,
+                 const WeightInit& init, uint64_t seed, int threads)
+    : checkpoint_interval(1) {
+    if (activations.size() != layerSizes.size() - 1) {
+        throw std::invalid_argument("Mismatch in layer sizes and activations.");
+    }
+    if (layerSizes.size() < 2) {
+        throw std::invalid_argument("Network must have at least an input and an output size.");
+    }
+    WeightInitializer rng(seed, threads);
+    for (size_t i = 0; i < layerSizes.size() - 1; ++i) {
+        layers.emplace_back(layerSizes[i], layerSizes[i + 1], activations[i], init, rng, i);
+    }
+}
+
+void Network::initialize_parameters(const WeightInit& init, uint64_t seed, int threads) {
+    WeightInitializer rng(seed, threads);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        layers[i].initialize_parameters(init, rng, i);
+    }
+    for (size_t f = 0; f < feature_layers.size(); ++f) {
+        feature_layers[f].initialize_parameters(init, rng, (static_cast<uint64_t>(1) << 32) + f);
+    }
+}
+
+Network::Network(const std::vector<SpatialLayer>& featureLayers, const std::vector<int>& layerSizes,
+                 const std::vector<std::string>& activations)
+    : Network(layerSizes, activations) {
+    for (size_t i = 0; i < featureLayers.size(); ++i) {
+        int expected = (i + 1 < featureLayers.size()) ? featureLayers[i + 1].getInputSize() : layerSizes[0];
+        if (featureLayers[i].getOutputSize() != expected) {
+            throw std::invalid_argument("Network: Feature layer " + std::to_string(i) + " outputs " +
+                                        std::to_string(featureLayers[i].getOutputSize()) + " values, next layer expects " +
+                                        std::to_string(expected));
+        }
+    }
+    feature_layers = featureLayers;
+}
+
+Matrix Network::forward_features(const MatrixView& input) {
+    Matrix current_output = feature_layers[0].forward(input);
+    for (size_t i = 1; i < feature_layers.size(); ++i) {
+        current_output = feature_layers[i].forward(current_output.view());
+    }
+    return current_output;
+}
+
+Matrix Network::infer_features(const MatrixView& input) const {
+    Matrix current_output = feature_layers[0].infer(input);
+    for (size_t i = 1; i < feature_layers.size(); ++i) {
+        current_output = feature_layers[i].infer(current_output.view());
+    }
+    return current_output;
+}
+
 Matrix Network::predict(Matrix& input) { 
-    Matrix current_output = input;
+    if (!feature_layers.empty()) return predict(input.view());
 
-    for (auto& layer : layers) {
-        current_output = layer.forward(current_output); 
+    Matrix current_output = layers[0].forward(input);
+    release_after_forward(0);
+
+    for (size_t i = 1; i < layers.size(); ++i) {
+        current_output = layers[i].forward(current_output); 
+        release_after_forward(i);
+    }
+    return current_output; 
+}
+
+Matrix Network::predict(const MatrixView& input) { 
+    Matrix current_output;
+    if (feature_layers.empty()) {
+        current_output = layers[0].forward(input);
+    } else {
+        Matrix features = forward_features(input);
+        current_output = layers[0].forward(features);
+    }
+    release_after_forward(0);
+
+    for (size_t i = 1; i < layers.size(); ++i) {
+        current_output = layers[i].forward(current_output); 
+        release_after_forward(i);
+    }
+    return current_output; 
+}
+
+Matrix Network::infer(const MatrixView& input) const { 
+    Matrix current_output = feature_layers.empty() ? layers[0].infer(input)
+                                                   : layers[0].infer(infer_features(input).view());
+
+    for (size_t i = 1; i < layers.size(); ++i) {
+        current_output = layers[i].infer(current_output.view()); 
+    }
+    return current_output; 
+}
+
+Matrix Network::predict(const SparseMatrix& input) {
+    if (input.getRow() != 1) {
+        throw std::invalid_argument("Network::predict: Sparse input must hold exactly one sample, got " + std::to_string(input.getRow()));
+    }
+    if (!feature_layers.empty()) {
+        Matrix dense_input = input.toDense();
+        dense_input.reshape(input.getCol(), 1);
+        return predict(dense_input.view());
+    }
+    Matrix current_output = layers[0].forward(input);
+    release_after_forward(0);
+
+    for (size_t i = 1; i < layers.size(); ++i) {
+        current_output = layers[i].forward(current_output); 
+        release_after_forward(i);
     }
     return current_output; 
 }
@@ -54,29 +160,135 @@ Matrix Network::meanSquaredErrorDerivative(const Matrix& predicted, const Matrix
     return predicted.subtract(actual).multiplyScalar(scale); 
 }
 
-void Network::backpropagate_sample(const Matrix& initial_error_gradient) {
+void Network::set_activation_checkpoint_interval(int k) {
+    if (k < 1) {
+        throw std::invalid_argument("Network::set_activation_checkpoint_interval: Interval must be at least 1.");
+    }
+    checkpoint_interval = k;
+}
+
+void Network::release_after_forward(size_t layer_index) {
+    if (checkpoint_interval <= 1) return;
+
+    size_t k = static_cast<size_t>(checkpoint_interval);
+    size_t last_segment_start = ((layers.size() - 1) / k) * k;
+    if (layer_index >= last_segment_start) return; 
+
+    layers[layer_index].release_activations(layer_index % k == 0);
+}
+
+void Network::recompute_segment(size_t begin, size_t end) {
+    Layer& first = layers[begin];
+    Matrix current_output;
+    if (first.last_input.getRow() > 0) {
+        Matrix segment_input = first.last_input;
+        current_output = first.forward(segment_input);
+    } else if (first.last_sparse_input.getRow() > 0) {
+        SparseMatrix segment_input = first.last_sparse_input;
+        current_output = first.forward(segment_input);
+    } else {
+        throw std::runtime_error("Network::recompute_segment: No checkpointed input for layer " + std::to_string(begin));
+    }
+    for (size_t i = begin + 1; i < end; ++i) {
+        current_output = layers[i].forward(current_output);
+    }
+}
+
+void Network::backpropagate(const Matrix& initial_error_gradient, bool sparse_input, bool accumulate,
+                            const LayerReadyCallback& on_layer_ready) {
     Matrix current_error_gradient = initial_error_gradient; 
+    size_t k = static_cast<size_t>(checkpoint_interval);
+    bool sparse_first_layer = sparse_input && feature_layers.empty();
+
+    size_t segment_end = layers.size();
+    while (segment_end > 0) {
+        size_t segment_start = ((segment_end - 1) / k) * k;
+        if (!layers[segment_end - 1].has_cached_activations()) {
+            recompute_segment(segment_start, segment_end);
+        }
+        for (size_t i = segment_end; i-- > segment_start; ) {
+            if (i == 0 && sparse_first_layer) {
+                layers[0].backward_sparse(current_error_gradient);
+            } else if (accumulate) {
+                // No error is computed for inputs whose gradient nobody reads:
+                // zero outputs of a ReLU layer, or the network input itself.
+                bool skip_zero_inputs = (i > 0) ? activations::zero_output_blocks_gradient(layers[i - 1].activation)
+                                                : feature_layers.empty();
+                current_error_gradient = layers[i].backward_accumulate(current_error_gradient, skip_zero_inputs);
+            } else {
+                current_error_gradient = layers[i].backward(current_error_gradient);
+            }
+            if (on_layer_ready) {
+                on_layer_ready(i);
+            }
+            if (k > 1) {
+                layers[i].release_activations(false);
+            }
+        }
+        segment_end = segment_start;
+    }
 
-    for (int i = static_cast<int>(layers.size()) - 1; i >= 0; --i) {
-        current_error_gradient = layers[static_cast<size_t>(i)].backward(current_error_gradient);
+    for (size_t i = feature_layers.size(); i-- > 0; ) {
+        current_error_gradient = feature_layers[i].backward(current_error_gradient, accumulate);
     }
 }
 
+void Network::backpropagate_sample(const Matrix& initial_error_gradient) {
+    backpropagate(initial_error_gradient, false, false, LayerReadyCallback());
+}
+
 void Network::zero_all_layer_deltas() {
+    for (auto& layer : feature_layers) {
+        layer.zero_deltas();
+    }
     for (auto& layer : layers) {
         layer.zero_deltas(); 
     }
 }
 
-void Network::accumulate_all_layer_gradients() {
+void Network::update_all_layer_parameters(double learning_rate, int batch_size) {
+    for (auto& layer : feature_layers) {
+        layer.update_parameters_from_deltas(learning_rate, batch_size);
+    }
     for (auto& layer : layers) {
-        layer.accumulate_gradients(); 
+        layer.update_parameters_from_deltas(learning_rate, batch_size);
     }
 }
 
-void Network::update_all_layer_parameters(double learning_rate, int batch_size) {
-    for (auto& layer : layers) {
-        layer.update_parameters_from_deltas(learning_rate, batch_size);
+
+// Dense layers come first so snapshots of networks without feature layers keep
+// their original layout; pooling layers contribute empty matrices.
+void Network::snapshot_parameters(ParameterSnapshot& snapshot) const {
+    size_t total = layers.size() + feature_layers.size();
+    snapshot.weights.resize(total);
+    snapshot.biases.resize(total);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        snapshot.weights[i] = layers[i].weights; 
+        snapshot.biases[i] = layers[i].biases;
+    }
+    for (size_t i = 0; i < feature_layers.size(); ++i) {
+        snapshot.weights[layers.size() + i] = feature_layers[i].weights;
+        snapshot.biases[layers.size() + i] = feature_layers[i].biases;
+    }
+}
+
+void Network::restore_parameters(const ParameterSnapshot& snapshot) {
+    size_t total = layers.size() + feature_layers.size();
+    if (snapshot.weights.size() != total || snapshot.biases.size() != total) {
+        throw std::invalid_argument("Network::restore_parameters: Snapshot has " + std::to_string(snapshot.weights.size()) +
+                                    " layers, network has " + std::to_string(total));
+    }
+    for (size_t i = 0; i < total; ++i) {
+        Matrix& target_w = (i < layers.size()) ? layers[i].weights : feature_layers[i - layers.size()].weights;
+        Matrix& target_b = (i < layers.size()) ? layers[i].biases : feature_layers[i - layers.size()].biases;
+        const Matrix& w = snapshot.weights[i];
+        const Matrix& b = snapshot.biases[i];
+        if (w.getRow() != target_w.getRow() || w.getCol() != target_w.getCol() ||
+            b.getRow() != target_b.getRow() || b.getCol() != target_b.getCol()) {
+            throw std::invalid_argument("Network::restore_parameters: Shape mismatch in layer " + std::to_string(i));
+        }
+        target_w = w;
+        target_b = b;
     }
 }
 
@@ -87,31 +299,86 @@ double Network::train_on_batch(const std::vector<Matrix>& batch_inputs,
     if (batch_inputs.empty() || batch_targets.empty()) {
         throw std::invalid_argument("Batch inputs or targets cannot be empty.");
     }
+
+    int batch_size_val = static_cast<int>(batch_inputs.size());
+    double total_batch_loss = this->accumulate_batch_gradients(batch_inputs, batch_targets); 
+
+    this->update_all_layer_parameters(learning_rate, batch_size_val); 
+
+    return total_batch_loss / static_cast<double>(batch_size_val); 
+}
+
+double Network::train_on_sparse_batch(const SparseMatrix& batch_inputs,
+                                      const std::vector<Matrix>& batch_targets,
+                                      double learning_rate) {
+    if (batch_inputs.getRow() == 0 || batch_targets.empty()) {
+        throw std::invalid_argument("Batch inputs or targets cannot be empty.");
+    }
+
+    int batch_size_val = batch_inputs.getRow();
+    double total_batch_loss = this->accumulate_sparse_batch_gradients(batch_inputs, batch_targets);
+
+    this->update_all_layer_parameters(learning_rate, batch_size_val);
+
+    return total_batch_loss / static_cast<double>(batch_size_val);
+}
+
+double Network::accumulate_batch_gradients(const std::vector<Matrix>& batch_inputs,
+                                           const std::vector<Matrix>& batch_targets,
+                                           const LayerReadyCallback& on_layer_ready) {
     if (batch_inputs.size() != batch_targets.size()) {
         throw std::invalid_argument("Batch inputs and targets size mismatch.");
     }
 
-    int batch_size_val = static_cast<int>(batch_inputs.size());
     double total_batch_loss = 0.0;
 
     zero_all_layer_deltas();
 
-    for (int i = 0; i < batch_size_val; ++i) {
-        Matrix current_input = batch_inputs[i]; 
-        Matrix current_target = batch_targets[i]; 
+    for (size_t i = 0; i < batch_inputs.size(); ++i) {
+        const Matrix& current_target = batch_targets[i]; 
         
-        Matrix predicted_output = this->predict(current_input); 
+        Matrix predicted_output = this->predict(batch_inputs[i].view()); 
         
         total_batch_loss += this->meanSquaredError(predicted_output, current_target); 
 
         Matrix error_gradient = this->meanSquaredErrorDerivative(predicted_output, current_target); 
 
-        this->backpropagate_sample(error_gradient); 
+        bool last_sample = (i + 1 == batch_inputs.size());
+        this->backpropagate(error_gradient, false, true, last_sample ? on_layer_ready : LayerReadyCallback()); 
+    }
 
-        this->accumulate_all_layer_gradients(); 
+    return total_batch_loss;
+}
+
+double Network::accumulate_sparse_batch_gradients(const SparseMatrix& batch_inputs,
+                                                  const std::vector<Matrix>& batch_targets,
+                                                  const LayerReadyCallback& on_layer_ready) {
+    if (static_cast<size_t>(batch_inputs.getRow()) != batch_targets.size()) {
+        throw std::invalid_argument("Batch inputs and targets size mismatch.");
     }
 
-    this->update_all_layer_parameters(learning_rate, batch_size_val); 
+    int batch_size_val = batch_inputs.getRow();
+    double total_batch_loss = 0.0;
 
-    return total_batch_loss / static_cast<double>(batch_size_val); 
-}
\ No newline at end of file
+    zero_all_layer_deltas();
+
+    for (int i = 0; i < batch_size_val; ++i) {
+        SparseMatrix current_input = batch_inputs.row(i);
+        const Matrix& current_target = batch_targets[static_cast<size_t>(i)];
+
+        Matrix predicted_output = this->predict(current_input);
+
+        total_batch_loss += this->meanSquaredError(predicted_output, current_target);
+
+        Matrix error_gradient = this->meanSquaredErrorDerivative(predicted_output, current_target);
+
+        bool last_sample = (i + 1 == batch_size_val);
+        this->backpropagate(error_gradient, true, true, last_sample ? on_layer_ready : LayerReadyCallback());
+    }
+
+    return total_batch_loss;
+}
+
+void Network::apply_gradients(double learning_rate, int batch_size) {
+    this->update_all_layer_parameters(learning_rate, batch_size);
+}
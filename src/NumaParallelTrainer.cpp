@@ -0,0 +1,320 @@
+#include "NumaParallelTrainer.h"
+#include "AlignedAllocator.h"
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+namespace {
+
+std::vector<Matrix*> delta_matrices(Network& net) {
+    std::vector<Matrix*> deltas;
+    for (Layer& layer : net.getLayers()) {
+        deltas.push_back(&layer.delta_weights);
+        deltas.push_back(&layer.delta_biases);
+    }
+    for (SpatialLayer& layer : net.getFeatureLayers()) {
+        if (!layer.has_parameters()) continue;
+        deltas.push_back(&layer.delta_weights);
+        deltas.push_back(&layer.delta_biases);
+    }
+    return deltas;
+}
+
+} // namespace
+
+struct NumaParallelTrainer::Replica {
+    Network net;
+    bool sparse;
+    std::vector<Matrix> inputs;
+    SparseMatrix sparse_inputs;
+    std::vector<Matrix> targets;
+    std::vector<size_t> order;
+    std::default_random_engine rng;
+    double loss;
+    size_t batch_count;
+
+    Replica(const Network& _net, unsigned int seed) : net(_net), sparse(false), rng(seed), loss(0.0), batch_count(0) {}
+};
+
+NumaParallelTrainer::NumaParallelTrainer(const Network& net, ThreadPool& _pool,
+                                         const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets,
+                                         unsigned int seed)
+    : pool(_pool), reduced(nullptr), reduced_count(0),
+      global_rng(seed), leaf_gradients(nullptr), leaf_capacity(0) {
+    if (inputs.size() != targets.size()) {
+        throw std::invalid_argument("NumaParallelTrainer: Inputs and targets size mismatch.");
+    }
+    create_replicas(net, &inputs, nullptr, targets, seed);
+}
+
+NumaParallelTrainer::NumaParallelTrainer(const Network& net, ThreadPool& _pool,
+                                         const SparseMatrix& inputs, const std::vector<Matrix>& targets,
+                                         unsigned int seed)
+    : pool(_pool), reduced(nullptr), reduced_count(0),
+      global_rng(seed), leaf_gradients(nullptr), leaf_capacity(0) {
+    if (static_cast<size_t>(inputs.getRow()) != targets.size()) {
+        throw std::invalid_argument("NumaParallelTrainer: Inputs and targets size mismatch.");
+    }
+    create_replicas(net, nullptr, &inputs, targets, seed);
+}
+
+NumaParallelTrainer::~NumaParallelTrainer() {
+    aligned_memory::deallocate(reduced);
+    aligned_memory::deallocate(leaf_gradients);
+}
+
+void NumaParallelTrainer::create_replicas(const Network& net, const std::vector<Matrix>* inputs,
+                                          const SparseMatrix* sparse_inputs, const std::vector<Matrix>& targets,
+                                          unsigned int seed) {
+    int workers = pool.size();
+    size_t total = targets.size();
+    replicas.resize(static_cast<size_t>(workers));
+
+    // Everything a worker will touch during training is copied by that worker.
+    pool.run([&](int w) {
+        size_t begin = total * static_cast<size_t>(w) / static_cast<size_t>(workers);
+        size_t end = total * static_cast<size_t>(w + 1) / static_cast<size_t>(workers);
+        std::unique_ptr<Replica> replica(new Replica(net, seed + static_cast<unsigned int>(w)));
+        if (sparse_inputs) {
+            std::vector<size_t> rows(total);
+            std::iota(rows.begin(), rows.end(), 0);
+            replica->sparse = true;
+            replica->sparse_inputs = sparse_inputs->gatherRows(rows, begin, end);
+        } else {
+            replica->inputs.assign(inputs->begin() + begin, inputs->begin() + end);
+        }
+        replica->targets.assign(targets.begin() + begin, targets.begin() + end);
+        replica->order.resize(end - begin);
+        replicas[static_cast<size_t>(w)] = std::move(replica);
+    });
+
+    for (int w = 0; w < workers; ++w) {
+        shard_begin.push_back(total * static_cast<size_t>(w) / static_cast<size_t>(workers));
+    }
+    global_order.resize(total);
+
+    std::vector<Matrix*> deltas = delta_matrices(replicas[0]->net);
+    parameter_offsets.push_back(0);
+    for (Matrix* m : deltas) {
+        parameter_offsets.push_back(parameter_offsets.back() + static_cast<size_t>(m->getRow()) * m->getCol());
+    }
+    reduced_count = parameter_offsets.back();
+    reduced = static_cast<double*>(aligned_memory::allocate(std::max<size_t>(reduced_count, 1) * sizeof(double)));
+
+    // Each worker first-touches the slice of the reduction buffer it will own.
+    pool.run([this](int w) {
+        size_t begin, end;
+        slice_bounds(w, begin, end);
+        std::fill(reduced + begin, reduced + end, 0.0);
+    });
+}
+
+void NumaParallelTrainer::slice_bounds(int worker, size_t& begin, size_t& end) const {
+    begin = reduced_count * static_cast<size_t>(worker) / static_cast<size_t>(pool.size());
+    end = reduced_count * static_cast<size_t>(worker + 1) / static_cast<size_t>(pool.size());
+}
+
+size_t NumaParallelTrainer::shard_size(int worker) const {
+    return replicas[static_cast<size_t>(worker)]->targets.size();
+}
+
+// Sums one contiguous slice of all gradients across replicas, in replica order
+// so the result does not depend on thread timing.
+void NumaParallelTrainer::reduce_slice(int worker) {
+    size_t begin, end;
+    slice_bounds(worker, begin, end);
+    if (begin == end) return;
+
+    std::vector<std::vector<Matrix*> > deltas;
+    for (const std::unique_ptr<Replica>& replica : replicas) {
+        deltas.push_back(delta_matrices(replica->net));
+    }
+    for (size_t m = 0; m + 1 < parameter_offsets.size(); ++m) {
+        size_t lo = std::max(begin, parameter_offsets[m]);
+        size_t hi = std::min(end, parameter_offsets[m + 1]);
+        if (lo >= hi) continue;
+        double* out = reduced + lo;
+        size_t local = lo - parameter_offsets[m];
+        std::memcpy(out, deltas[0][m]->get_host_ptr() + local, (hi - lo) * sizeof(double));
+        for (size_t r = 1; r < deltas.size(); ++r) {
+            const double* src = deltas[r][m]->get_host_ptr() + local;
+            for (size_t i = 0; i < hi - lo; ++i) {
+                out[i] += src[i];
+            }
+        }
+    }
+}
+
+double NumaParallelTrainer::train_epoch(int per_worker_batch, double learning_rate) {
+    if (per_worker_batch <= 0) {
+        throw std::invalid_argument("NumaParallelTrainer::train_epoch: Batch size must be positive.");
+    }
+    size_t batch = static_cast<size_t>(per_worker_batch);
+    size_t steps = 0;
+    size_t total_samples = 0;
+    for (const std::unique_ptr<Replica>& replica : replicas) {
+        steps = std::max(steps, (replica->targets.size() + batch - 1) / batch);
+        total_samples += replica->targets.size();
+    }
+
+    pool.run([this](int w) {
+        Replica& replica = *replicas[static_cast<size_t>(w)];
+        std::iota(replica.order.begin(), replica.order.end(), 0);
+        std::shuffle(replica.order.begin(), replica.order.end(), replica.rng);
+    });
+
+    double epoch_loss = 0.0;
+    for (size_t step = 0; step < steps; ++step) {
+        pool.run([this, step, batch](int w) {
+            Replica& replica = *replicas[static_cast<size_t>(w)];
+            size_t begin = std::min(step * batch, replica.order.size());
+            size_t end = std::min(begin + batch, replica.order.size());
+            std::vector<Matrix> targets;
+            for (size_t j = begin; j < end; ++j) targets.push_back(replica.targets[replica.order[j]]);
+            if (replica.sparse) {
+                replica.loss = replica.net.accumulate_sparse_batch_gradients(
+                    replica.sparse_inputs.gatherRows(replica.order, begin, end), targets);
+            } else {
+                std::vector<Matrix> inputs;
+                for (size_t j = begin; j < end; ++j) inputs.push_back(replica.inputs[replica.order[j]]);
+                replica.loss = replica.net.accumulate_batch_gradients(inputs, targets);
+            }
+            replica.batch_count = end - begin;
+        });
+
+        size_t global_batch = 0;
+        for (const std::unique_ptr<Replica>& replica : replicas) {
+            global_batch += replica->batch_count;
+            epoch_loss += replica->loss;
+        }
+
+        pool.run([this](int w) { reduce_slice(w); });
+        pool.run([this, global_batch, learning_rate](int w) { apply_reduced(w, global_batch, learning_rate); });
+    }
+    return total_samples > 0 ? epoch_loss / static_cast<double>(total_samples) : 0.0;
+}
+
+void NumaParallelTrainer::apply_reduced(int worker, size_t global_batch, double learning_rate) {
+    Replica& replica = *replicas[static_cast<size_t>(worker)];
+    std::vector<Matrix*> deltas = delta_matrices(replica.net);
+    for (size_t m = 0; m < deltas.size(); ++m) {
+        std::memcpy(deltas[m]->get_host_ptr(), reduced + parameter_offsets[m],
+                    (parameter_offsets[m + 1] - parameter_offsets[m]) * sizeof(double));
+    }
+    replica.net.apply_gradients(learning_rate, static_cast<int>(global_batch));
+}
+
+// Sums the gradients of global_order[first, last) on the given replica and stores
+// them in the leaf's block. Samples are read from whichever shard holds them.
+void NumaParallelTrainer::compute_leaf(Replica& replica, size_t leaf, size_t first, size_t last) {
+    std::vector<Matrix> inputs;
+    SparseMatrix sparse_inputs(replica.sparse ? replica.sparse_inputs.getCol() : 0);
+    std::vector<Matrix> targets;
+    for (size_t j = first; j < last; ++j) {
+        size_t sample = global_order[j];
+        size_t owner = static_cast<size_t>(std::upper_bound(shard_begin.begin(), shard_begin.end(), sample) -
+                                           shard_begin.begin()) - 1;
+        const Replica& shard = *replicas[owner];
+        size_t local = sample - shard_begin[owner];
+        if (replica.sparse) {
+            sparse_inputs.appendRow(shard.sparse_inputs, static_cast<int>(local));
+        } else {
+            inputs.push_back(shard.inputs[local]);
+        }
+        targets.push_back(shard.targets[local]);
+    }
+
+    leaf_losses[leaf] = replica.sparse ? replica.net.accumulate_sparse_batch_gradients(sparse_inputs, targets)
+                                       : replica.net.accumulate_batch_gradients(inputs, targets);
+
+    double* block = leaf_gradients + leaf * reduced_count;
+    std::vector<Matrix*> deltas = delta_matrices(replica.net);
+    for (size_t m = 0; m < deltas.size(); ++m) {
+        std::memcpy(block + parameter_offsets[m], deltas[m]->get_host_ptr(),
+                    (parameter_offsets[m + 1] - parameter_offsets[m]) * sizeof(double));
+    }
+}
+
+// Combines the leaf blocks over this worker's slice in a fixed pairwise tree:
+// leaf l absorbs leaf l + stride for stride = 1, 2, 4, ... The order of every
+// addition depends only on the leaf count.
+void NumaParallelTrainer::tree_reduce_slice(int worker, size_t leaves) {
+    size_t begin, end;
+    slice_bounds(worker, begin, end);
+    if (begin == end) return;
+
+    for (size_t stride = 1; stride < leaves; stride *= 2) {
+        for (size_t l = 0; l + stride < leaves; l += 2 * stride) {
+            double* dst = leaf_gradients + l * reduced_count;
+            const double* src = leaf_gradients + (l + stride) * reduced_count;
+            for (size_t i = begin; i < end; ++i) {
+                dst[i] += src[i];
+            }
+        }
+    }
+    std::memcpy(reduced + begin, leaf_gradients + begin, (end - begin) * sizeof(double));
+}
+
+double NumaParallelTrainer::train_epoch_deterministic(int global_batch, double learning_rate, int leaf_size) {
+    if (global_batch <= 0 || leaf_size <= 0) {
+        throw std::invalid_argument("NumaParallelTrainer::train_epoch_deterministic: Batch and leaf size must be positive.");
+    }
+    size_t batch = static_cast<size_t>(global_batch);
+    size_t leaf = static_cast<size_t>(leaf_size);
+    size_t max_leaves = (batch + leaf - 1) / leaf;
+    if (max_leaves > leaf_capacity) {
+        aligned_memory::deallocate(leaf_gradients);
+        leaf_gradients = nullptr;
+        leaf_capacity = 0;
+        leaf_gradients = static_cast<double*>(
+            aligned_memory::allocate(std::max<size_t>(max_leaves * reduced_count, 1) * sizeof(double)));
+        leaf_capacity = max_leaves;
+    }
+    leaf_losses.assign(max_leaves, 0.0);
+
+    std::iota(global_order.begin(), global_order.end(), 0);
+    std::shuffle(global_order.begin(), global_order.end(), global_rng);
+
+    double epoch_loss = 0.0;
+    for (size_t start = 0; start < global_order.size(); start += batch) {
+        size_t count = std::min(batch, global_order.size() - start);
+        size_t leaves = (count + leaf - 1) / leaf;
+
+        pool.run([this, start, count, leaf, leaves](int w) {
+            Replica& replica = *replicas[static_cast<size_t>(w)];
+            for (size_t l = static_cast<size_t>(w); l < leaves; l += static_cast<size_t>(pool.size())) {
+                size_t first = start + l * leaf;
+                compute_leaf(replica, l, first, std::min(first + leaf, start + count));
+            }
+        });
+
+        for (size_t l = 0; l < leaves; ++l) {
+            epoch_loss += leaf_losses[l];
+        }
+
+        pool.run([this, leaves](int w) { tree_reduce_slice(w, leaves); });
+        pool.run([this, count, learning_rate](int w) { apply_reduced(w, count, learning_rate); });
+    }
+    return global_order.empty() ? 0.0 : epoch_loss / static_cast<double>(global_order.size());
+}
+
+std::vector<Matrix> NumaParallelTrainer::infer(const std::vector<Matrix>& inputs) {
+    std::vector<Matrix> outputs(inputs.size());
+    pool.run([&](int w) {
+        const Network& net = replicas[static_cast<size_t>(w)]->net;
+        size_t begin = inputs.size() * static_cast<size_t>(w) / static_cast<size_t>(pool.size());
+        size_t end = inputs.size() * static_cast<size_t>(w + 1) / static_cast<size_t>(pool.size());
+        for (size_t i = begin; i < end; ++i) {
+            outputs[i] = net.infer(inputs[i].view());
+        }
+    });
+    return outputs;
+}
+
+void NumaParallelTrainer::copy_parameters_to(Network& net) const {
+    ParameterSnapshot snapshot;
+    replicas[0]->net.snapshot_parameters(snapshot);
+    net.restore_parameters(snapshot);
+}
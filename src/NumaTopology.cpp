@@ -0,0 +1,154 @@
+#include "NumaTopology.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+#include <dirent.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace {
+
+std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+    if (cpus.empty()) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int cpu = 0; cpu < (online > 0 ? online : 1); ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+bool set_affinity(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+} // namespace
+
+std::vector<int> NumaTopology::parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        range.erase(std::remove_if(range.begin(), range.end(), ::isspace), range.end());
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        } catch (const std::exception&) {
+            throw std::invalid_argument("NumaTopology::parse_cpu_list: Malformed cpu list \"" + list + "\"");
+        }
+    }
+    return cpus;
+}
+
+NumaTopology NumaTopology::detect(const std::string& sysfs_node_root) {
+    std::vector<int> allowed = allowed_cpus();
+    NumaTopology topology;
+
+    std::vector<int> node_numbers;
+    if (DIR* dir = opendir(sysfs_node_root.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+                name.find_first_not_of("0123456789", 4) == std::string::npos) {
+                node_numbers.push_back(std::stoi(name.substr(4)));
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(node_numbers.begin(), node_numbers.end());
+
+    for (int node : node_numbers) {
+        std::ifstream ifs(sysfs_node_root + "/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (!ifs.is_open() || !std::getline(ifs, list)) continue;
+        std::vector<int> cpus;
+        for (int cpu : parse_cpu_list(list)) {
+            if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) cpus.push_back(cpu);
+        }
+        if (!cpus.empty()) {
+            topology.ids.push_back(node);
+            topology.node_cpus.push_back(cpus);
+        }
+    }
+
+    if (topology.node_cpus.empty()) {
+        topology.ids.push_back(0);
+        topology.node_cpus.push_back(allowed);
+    }
+    return topology;
+}
+
+const NumaTopology& NumaTopology::system() {
+    static const NumaTopology topology = detect();
+    return topology;
+}
+
+int NumaTopology::cpu_count() const {
+    int total = 0;
+    for (const std::vector<int>& cpus : node_cpus) total += static_cast<int>(cpus.size());
+    return total;
+}
+
+int NumaTopology::node_of_cpu(int cpu) const {
+    for (size_t n = 0; n < node_cpus.size(); ++n) {
+        if (std::find(node_cpus[n].begin(), node_cpus[n].end(), cpu) != node_cpus[n].end()) {
+            return static_cast<int>(n);
+        }
+    }
+    return -1;
+}
+
+std::string NumaTopology::describe() const {
+    std::ostringstream out;
+    out << node_count() << " NUMA node(s), " << cpu_count() << " CPU(s):";
+    for (size_t n = 0; n < node_cpus.size(); ++n) {
+        out << " node" << ids[n] << "=[";
+        for (size_t i = 0; i < node_cpus[n].size(); ++i) {
+            out << (i ? "," : "") << node_cpus[n][i];
+        }
+        out << "]";
+    }
+    return out.str();
+}
+
+namespace thread_affinity {
+
+bool pin_current_thread(int cpu) {
+    return set_affinity(std::vector<int>(1, cpu));
+}
+
+bool pin_current_thread(const std::vector<int>& cpus) {
+    return set_affinity(cpus);
+}
+
+// The kernel intersects the mask with the process cpuset, so "every CPU" restores
+// whatever the thread was allowed before pinning.
+void unpin_current_thread() {
+    long configured = sysconf(_SC_NPROCESSORS_CONF);
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < (configured > 0 ? configured : 1); ++cpu) cpus.push_back(cpu);
+    set_affinity(cpus);
+}
+
+int current_cpu() {
+    return sched_getcpu();
+}
+
+} // namespace thread_affinity
@@ -0,0 +1,329 @@
+#include "PipelineParallelTrainer.h"
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_between(Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double>(b - a).count();
+}
+
+// Splits consecutive layers into stages minimizing the largest stage's
+// parameter count (a stand-in for its forward + backward work).
+std::vector<size_t> partition_layers(const std::vector<Layer>& layers, size_t stages) {
+    size_t n = layers.size();
+    std::vector<double> prefix(n + 1, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        prefix[i + 1] = prefix[i] + static_cast<double>(layers[i].weights.getRow()) * (layers[i].weights.getCol() + 1);
+    }
+    // cost[k][i]: smallest possible largest stage when the first i layers form k stages.
+    const double inf = 1e300;
+    std::vector<std::vector<double> > cost(stages + 1, std::vector<double>(n + 1, inf));
+    std::vector<std::vector<size_t> > cut(stages + 1, std::vector<size_t>(n + 1, 0));
+    cost[0][0] = 0.0;
+    for (size_t k = 1; k <= stages; ++k) {
+        for (size_t i = k; i <= n; ++i) {
+            for (size_t j = k - 1; j < i; ++j) {
+                double c = std::max(cost[k - 1][j], prefix[i] - prefix[j]);
+                if (c < cost[k][i]) {
+                    cost[k][i] = c;
+                    cut[k][i] = j;
+                }
+            }
+        }
+    }
+    std::vector<size_t> begin(stages);
+    size_t end = n;
+    for (size_t k = stages; k > 0; --k) {
+        begin[k - 1] = cut[k][end];
+        end = begin[k - 1];
+    }
+    return begin;
+}
+
+// Samples first..first+count-1 as the columns of one matrix.
+Matrix gather_columns(const std::vector<Matrix>& samples, size_t first, int count) {
+    int rows = samples[first].getRow();
+    Matrix batch(rows, count, false);
+    double* out = batch.get_host_ptr();
+    for (int c = 0; c < count; ++c) {
+        const Matrix& sample = samples[first + static_cast<size_t>(c)];
+        const double* in = sample.get_host_ptr();
+        for (int r = 0; r < rows; ++r) {
+            out[static_cast<size_t>(r) * count + c] = in[r];
+        }
+    }
+    return batch;
+}
+
+} // namespace
+
+struct PipelineParallelTrainer::Stage {
+    struct Cache {
+        Matrix input;
+        Matrix z;
+        Matrix output;
+    };
+
+    std::vector<Layer> layers;
+    std::vector<std::vector<Cache> > stash;   // [microbatch][layer], between forward and backward
+    std::vector<Matrix> output_errors;        // last stage: loss gradient per microbatch
+    double busy_seconds;
+    double loss;
+
+    Stage() : busy_seconds(0.0), loss(0.0) {}
+};
+
+double PipelineStats::bubble_fraction() const {
+    if (wall_seconds <= 0.0 || stage_busy_seconds.empty()) return 0.0;
+    double busy = 0.0;
+    for (double s : stage_busy_seconds) busy += s;
+    return 1.0 - busy / (wall_seconds * static_cast<double>(stage_busy_seconds.size()));
+}
+
+std::string PipelineStats::to_string() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << batches << " batches in " << std::setprecision(3) << wall_seconds
+        << " s, bubble " << std::setprecision(1) << 100.0 * bubble_fraction() << "% (ideal "
+        << 100.0 * ideal_bubble_fraction() << "%), stage busy";
+    for (size_t s = 0; s < stage_busy_seconds.size(); ++s) {
+        out << (s ? "/" : " ") << std::setprecision(0)
+            << (wall_seconds > 0.0 ? 100.0 * stage_busy_seconds[s] / wall_seconds : 0.0) << "%";
+    }
+    return out.str();
+}
+
+PipelineParallelTrainer::PipelineParallelTrainer(const Network& net, ThreadPool& _pool)
+    : pool(_pool), layer_count(net.getLayers().size()), aborted(false) {
+    if (!net.getFeatureLayers().empty()) {
+        throw std::invalid_argument("PipelineParallelTrainer: Convolution and pooling layers are not supported.");
+    }
+    if (layer_count == 0) {
+        throw std::invalid_argument("PipelineParallelTrainer: Network has no layers.");
+    }
+    size_t stage_total = std::min(layer_count, static_cast<size_t>(pool.size()));
+    stage_begin = partition_layers(net.getLayers(), stage_total);
+    stages.resize(stage_total);
+    for (size_t s = 0; s + 1 < stage_total; ++s) {
+        boundaries.emplace_back(new Boundary());
+    }
+    pipeline_stats.stage_busy_seconds.assign(stage_total, 0.0);
+
+    // Each stage's layers are copied on the worker that will run it.
+    pool.run([&](int worker) {
+        size_t s = static_cast<size_t>(worker);
+        if (s >= stage_total) return;
+        std::unique_ptr<Stage> stage(new Stage());
+        for (size_t l = stage_begin[s]; l < first_layer(static_cast<int>(s) + 1); ++l) {
+            stage->layers.push_back(net.getLayers()[l]);
+        }
+        stages[s] = std::move(stage);
+    });
+}
+
+PipelineParallelTrainer::~PipelineParallelTrainer() {}
+
+size_t PipelineParallelTrainer::first_layer(int stage) const {
+    return static_cast<size_t>(stage) < stage_begin.size() ? stage_begin[static_cast<size_t>(stage)] : layer_count;
+}
+
+void PipelineParallelTrainer::reset_stats() {
+    pipeline_stats = PipelineStats();
+    pipeline_stats.stage_busy_seconds.assign(stages.size(), 0.0);
+}
+
+void PipelineParallelTrainer::copy_parameters_to(Network& net) const {
+    if (net.getLayers().size() != layer_count) {
+        throw std::invalid_argument("PipelineParallelTrainer::copy_parameters_to: Network has " +
+                                    std::to_string(net.getLayers().size()) + " layers, expected " + std::to_string(layer_count));
+    }
+    for (size_t s = 0; s < stages.size(); ++s) {
+        for (size_t l = 0; l < stages[s]->layers.size(); ++l) {
+            Layer& target = net.getLayers()[stage_begin[s] + l];
+            target.weights = stages[s]->layers[l].weights;
+            target.biases = stages[s]->layers[l].biases;
+        }
+    }
+}
+
+void PipelineParallelTrainer::abort(std::exception_ptr error) {
+    {
+        std::lock_guard<std::mutex> lock(abort_mutex);
+        if (!first_error) first_error = error;
+    }
+    aborted = true;
+    // Taking each mutex orders the flag before any waiter's next predicate check.
+    for (std::unique_ptr<Boundary>& boundary : boundaries) {
+        { std::lock_guard<std::mutex> lock(boundary->mutex); }
+        boundary->cv.notify_all();
+    }
+}
+
+Matrix PipelineParallelTrainer::take(Boundary& boundary, std::vector<Matrix> Boundary::* slots,
+                                     std::vector<char> Boundary::* ready, int microbatch) {
+    size_t j = static_cast<size_t>(microbatch);
+    std::unique_lock<std::mutex> lock(boundary.mutex);
+    boundary.cv.wait(lock, [&]() { return (boundary.*ready)[j] || aborted.load(); });
+    if (!(boundary.*ready)[j]) {
+        throw std::runtime_error("PipelineParallelTrainer: Aborted because another stage failed.");
+    }
+    return std::move((boundary.*slots)[j]);
+}
+
+void PipelineParallelTrainer::put(Boundary& boundary, std::vector<Matrix> Boundary::* slots,
+                                  std::vector<char> Boundary::* ready, int microbatch, Matrix value) {
+    size_t j = static_cast<size_t>(microbatch);
+    {
+        std::lock_guard<std::mutex> lock(boundary.mutex);
+        (boundary.*slots)[j] = std::move(value);
+        (boundary.*ready)[j] = 1;
+    }
+    boundary.cv.notify_all();
+}
+
+double PipelineParallelTrainer::train_batch(const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets,
+                                            int microbatch_size, double learning_rate, PipelineSchedule schedule) {
+    if (inputs.empty() || inputs.size() != targets.size()) {
+        throw std::invalid_argument("PipelineParallelTrainer::train_batch: Need equally many inputs and targets, got " +
+                                    std::to_string(inputs.size()) + " and " + std::to_string(targets.size()));
+    }
+    if (microbatch_size <= 0) {
+        throw std::invalid_argument("PipelineParallelTrainer::train_batch: Microbatch size must be positive.");
+    }
+    const Layer& first = stages.front()->layers.front();
+    const Layer& last = stages.back()->layers.back();
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (inputs[i].getRow() != first.weights.getCol() || inputs[i].getCol() != 1 ||
+            targets[i].getRow() != last.weights.getRow() || targets[i].getCol() != 1) {
+            throw std::invalid_argument("PipelineParallelTrainer::train_batch: Sample " + std::to_string(i) +
+                                        " does not match the network's input/output size.");
+        }
+    }
+
+    int microbatches = static_cast<int>((inputs.size() + static_cast<size_t>(microbatch_size) - 1) / static_cast<size_t>(microbatch_size));
+    for (std::unique_ptr<Boundary>& boundary : boundaries) {
+        boundary->activations.assign(static_cast<size_t>(microbatches), Matrix());
+        boundary->errors.assign(static_cast<size_t>(microbatches), Matrix());
+        boundary->activation_ready.assign(static_cast<size_t>(microbatches), 0);
+        boundary->error_ready.assign(static_cast<size_t>(microbatches), 0);
+    }
+    aborted = false;
+    first_error = nullptr;
+
+    Clock::time_point start = Clock::now();
+    pool.run([&](int worker) {
+        if (static_cast<size_t>(worker) >= stages.size()) return;
+        try {
+            run_stage(worker, inputs, targets, microbatch_size, learning_rate, schedule);
+        } catch (...) {
+            abort(std::current_exception());
+        }
+    });
+    double wall = seconds_between(start, Clock::now());
+    if (first_error) std::rethrow_exception(first_error);
+
+    size_t stage_total = stages.size();
+    pipeline_stats.batches++;
+    pipeline_stats.wall_seconds += wall;
+    pipeline_stats.ideal_bubble_sum += static_cast<double>(stage_total - 1) / static_cast<double>(microbatches + static_cast<int>(stage_total) - 1);
+    for (size_t s = 0; s < stage_total; ++s) {
+        pipeline_stats.stage_busy_seconds[s] += stages[s]->busy_seconds;
+    }
+
+    return stages.back()->loss / static_cast<double>(inputs.size());
+}
+
+void PipelineParallelTrainer::run_stage(int s, const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets,
+                                        int microbatch_size, double learning_rate, PipelineSchedule schedule) {
+    Stage& stage = *stages[static_cast<size_t>(s)];
+    int stage_total = static_cast<int>(stages.size());
+    bool is_first = (s == 0);
+    bool is_last = (s + 1 == stage_total);
+    int microbatches = static_cast<int>((inputs.size() + static_cast<size_t>(microbatch_size) - 1) / static_cast<size_t>(microbatch_size));
+
+    stage.busy_seconds = 0.0;
+    stage.loss = 0.0;
+    stage.stash.assign(static_cast<size_t>(microbatches), std::vector<Stage::Cache>(stage.layers.size()));
+    stage.output_errors.assign(is_last ? static_cast<size_t>(microbatches) : 0, Matrix());
+    for (Layer& layer : stage.layers) {
+        layer.zero_deltas();
+    }
+
+    // Forward ops are encoded as j + 1 and backward ops as -(j + 1).
+    std::vector<int> ops;
+    if (schedule == PipelineSchedule::GPipe) {
+        for (int j = 0; j < microbatches; ++j) ops.push_back(j + 1);
+        for (int j = 0; j < microbatches; ++j) ops.push_back(-(j + 1));
+    } else {
+        int warmup = std::min(stage_total - 1 - s, microbatches);
+        for (int j = 0; j < warmup; ++j) ops.push_back(j + 1);
+        for (int j = 0; j + warmup < microbatches; ++j) {
+            ops.push_back(j + warmup + 1);
+            ops.push_back(-(j + 1));
+        }
+        for (int j = microbatches - warmup; j < microbatches; ++j) ops.push_back(-(j + 1));
+    }
+
+    for (int op : ops) {
+        int j = std::abs(op) - 1;
+        size_t first_sample = static_cast<size_t>(j) * static_cast<size_t>(microbatch_size);
+        int count = static_cast<int>(std::min(static_cast<size_t>(microbatch_size), inputs.size() - first_sample));
+
+        if (op > 0) {
+            Matrix x = is_first ? Matrix() : take(*boundaries[static_cast<size_t>(s) - 1], &Boundary::activations,
+                                                  &Boundary::activation_ready, j);
+            Clock::time_point t0 = Clock::now();
+            if (is_first) x = gather_columns(inputs, first_sample, count);
+            for (size_t l = 0; l < stage.layers.size(); ++l) {
+                Layer& layer = stage.layers[l];
+                x = layer.forward(x.view());
+                Stage::Cache& cache = stage.stash[static_cast<size_t>(j)][l];
+                cache.input = std::move(layer.last_input);
+                cache.z = std::move(layer.last_z);
+                cache.output = std::move(layer.last_output);
+            }
+            if (is_last) {
+                // Per-sample MSE, as in Network: mean over the output rows of each column.
+                Matrix target = gather_columns(targets, first_sample, count);
+                Matrix diff = x.subtract(target);
+                const double* d = diff.get_host_ptr();
+                size_t n = static_cast<size_t>(diff.getRow()) * count;
+                double sum_sq = 0.0;
+                for (size_t i = 0; i < n; ++i) sum_sq += d[i] * d[i];
+                stage.loss += sum_sq / diff.getRow();
+                stage.output_errors[static_cast<size_t>(j)] = diff.multiplyScalar(2.0 / diff.getRow());
+            }
+            stage.busy_seconds += seconds_between(t0, Clock::now());
+            if (!is_last) put(*boundaries[static_cast<size_t>(s)], &Boundary::activations, &Boundary::activation_ready, j, std::move(x));
+        } else {
+            Matrix error = is_last ? std::move(stage.output_errors[static_cast<size_t>(j)])
+                                   : take(*boundaries[static_cast<size_t>(s)], &Boundary::errors, &Boundary::error_ready, j);
+            Clock::time_point t0 = Clock::now();
+            for (size_t l = stage.layers.size(); l-- > 0; ) {
+                Layer& layer = stage.layers[l];
+                Stage::Cache& cache = stage.stash[static_cast<size_t>(j)][l];
+                layer.last_input = std::move(cache.input);
+                layer.last_z = std::move(cache.z);
+                layer.last_output = std::move(cache.output);
+                bool skip_zero_inputs = (l > 0) ? activations::zero_output_blocks_gradient(stage.layers[l - 1].activation)
+                                                : is_first;
+                error = layer.backward_accumulate(error, skip_zero_inputs);
+                layer.release_activations(false);
+            }
+            stage.busy_seconds += seconds_between(t0, Clock::now());
+            if (!is_first) put(*boundaries[static_cast<size_t>(s) - 1], &Boundary::errors, &Boundary::error_ready, j, std::move(error));
+        }
+    }
+
+    Clock::time_point t0 = Clock::now();
+    for (Layer& layer : stage.layers) {
+        layer.update_parameters_from_deltas(learning_rate, static_cast<int>(inputs.size()));
+    }
+    stage.busy_seconds += seconds_between(t0, Clock::now());
+}
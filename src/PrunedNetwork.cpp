@@ -0,0 +1,71 @@
+#include "PrunedNetwork.h"
+#include <stdexcept>
+
+SparseLayer::SparseLayer(const Layer& layer)
+    : weights(SparseMatrix::fromDense(layer.weights)),
+      biases(layer.biases),
+      activationName(layer.activationName),
+      activation(layer.activation)
+{
+    if (biases.is_on_device() && biases.get_device_ptr()) biases.to_host();
+}
+
+Matrix SparseLayer::infer(const MatrixView& input) const {
+    Matrix z = weights.multiply(input);
+    if (z.getRow() > 0 && z.getCol() > 0) {
+        const double* b = biases.get_host_ptr();
+        double* z_data = z.get_host_ptr();
+        for (int i = 0; i < z.getRow(); ++i) {
+            double* z_row = z_data + static_cast<size_t>(i) * z.getCol();
+            for (int j = 0; j < z.getCol(); ++j) {
+                z_row[j] += b[i];
+            }
+        }
+    }
+    size_t n = static_cast<size_t>(z.getRow()) * z.getCol();
+    if (n > 0) activations::apply(activation, z.get_host_ptr(), z.get_host_ptr(), n);
+    return z;
+}
+
+size_t SparseLayer::storage_bytes() const {
+    return weights.nonZeros() * (sizeof(int) + sizeof(double)) +
+           weights.getRowPtr().size() * sizeof(int) +
+           static_cast<size_t>(biases.getRow()) * biases.getCol() * sizeof(double);
+}
+
+PrunedNetwork::PrunedNetwork(const Network& net) {
+    if (!net.getFeatureLayers().empty()) {
+        throw std::invalid_argument("PrunedNetwork: Networks with convolution/pooling layers are not supported.");
+    }
+    for (const Layer& layer : net.getLayers()) {
+        layers.push_back(SparseLayer(layer));
+    }
+}
+
+Matrix PrunedNetwork::infer(const MatrixView& input) const {
+    if (layers.empty()) {
+        throw std::logic_error("PrunedNetwork::infer: Network has no layers.");
+    }
+    Matrix current = layers[0].infer(input);
+    for (size_t i = 1; i < layers.size(); ++i) {
+        current = layers[i].infer(current.view());
+    }
+    return current;
+}
+
+size_t PrunedNetwork::storage_bytes() const {
+    size_t total = 0;
+    for (const SparseLayer& layer : layers) {
+        total += layer.storage_bytes();
+    }
+    return total;
+}
+
+size_t PrunedNetwork::dense_storage_bytes(const Network& net) {
+    size_t total = 0;
+    for (const Layer& layer : net.getLayers()) {
+        total += (static_cast<size_t>(layer.weights.getRow()) * layer.weights.getCol() +
+                  static_cast<size_t>(layer.biases.getRow()) * layer.biases.getCol()) * sizeof(double);
+    }
+    return total;
+}
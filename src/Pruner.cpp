@@ -0,0 +1,124 @@
+#include "Pruner.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Magnitude at or below which weights are pruned so that about `sparsity` of
+// the given magnitudes go; negative when nothing should be pruned.
+double magnitude_threshold(std::vector<double>& magnitudes, double sparsity) {
+    size_t prune_count = static_cast<size_t>(std::floor(sparsity * static_cast<double>(magnitudes.size())));
+    if (prune_count == 0) return -1.0;
+    std::nth_element(magnitudes.begin(), magnitudes.begin() + (prune_count - 1), magnitudes.end());
+    return magnitudes[prune_count - 1];
+}
+
+void append_magnitudes(const Layer& layer, std::vector<double>& magnitudes) {
+    const double* w = layer.weights.get_host_ptr();
+    size_t count = static_cast<size_t>(layer.weights.getRow()) * layer.weights.getCol();
+    for (size_t i = 0; i < count; ++i) {
+        magnitudes.push_back(std::fabs(w[i]));
+    }
+}
+
+} // namespace
+
+Pruner::Pruner(double sparsity, PruningScope _scope)
+    : target_sparsity(sparsity), scope(_scope) {
+    if (sparsity < 0.0 || sparsity >= 1.0) {
+        throw std::invalid_argument("Pruner: Sparsity must be in [0, 1), got " + std::to_string(sparsity));
+    }
+}
+
+void Pruner::prune(Network& net) {
+    std::vector<Layer>& layers = net.getLayers();
+    for (Layer& layer : layers) {
+        if (layer.weights.is_on_device() && layer.weights.get_device_ptr()) layer.weights.to_host();
+    }
+
+    std::vector<double> thresholds(layers.size(), -1.0);
+    std::vector<double> magnitudes;
+    if (scope == PruningScope::Global) {
+        for (const Layer& layer : layers) append_magnitudes(layer, magnitudes);
+        double threshold = magnitude_threshold(magnitudes, target_sparsity);
+        std::fill(thresholds.begin(), thresholds.end(), threshold);
+    } else {
+        for (size_t l = 0; l < layers.size(); ++l) {
+            magnitudes.clear();
+            append_magnitudes(layers[l], magnitudes);
+            thresholds[l] = magnitude_threshold(magnitudes, target_sparsity);
+        }
+    }
+
+    masks.assign(layers.size(), std::vector<unsigned char>());
+    for (size_t l = 0; l < layers.size(); ++l) {
+        size_t count = static_cast<size_t>(layers[l].weights.getRow()) * layers[l].weights.getCol();
+        const double* w = layers[l].weights.get_host_ptr();
+        masks[l].resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            masks[l][i] = (std::fabs(w[i]) > thresholds[l]) ? 1 : 0;
+        }
+    }
+    apply_mask(net);
+}
+
+void Pruner::apply_mask(Network& net) const {
+    std::vector<Layer>& layers = net.getLayers();
+    if (masks.size() != layers.size()) {
+        throw std::logic_error("Pruner::apply_mask: No mask for this network; call prune() first.");
+    }
+    for (size_t l = 0; l < layers.size(); ++l) {
+        Matrix& weights = layers[l].weights;
+        if (weights.is_on_device() && weights.get_device_ptr()) weights.to_host();
+        size_t count = static_cast<size_t>(weights.getRow()) * weights.getCol();
+        if (masks[l].size() != count) {
+            throw std::logic_error("Pruner::apply_mask: Layer " + std::to_string(l) + " shape changed since prune().");
+        }
+        double* w = weights.get_host_ptr();
+        for (size_t i = 0; i < count; ++i) {
+            if (!masks[l][i]) w[i] = 0.0;
+        }
+    }
+}
+
+// With plain SGD, re-zeroing after the update is the same as masking the gradient.
+double Pruner::fine_tune_on_batch(Network& net,
+                                  const std::vector<Matrix>& batch_inputs,
+                                  const std::vector<Matrix>& batch_targets,
+                                  double learning_rate) const {
+    double loss = net.train_on_batch(batch_inputs, batch_targets, learning_rate);
+    apply_mask(net);
+    return loss;
+}
+
+double Pruner::fine_tune_on_sparse_batch(Network& net,
+                                         const SparseMatrix& batch_inputs,
+                                         const std::vector<Matrix>& batch_targets,
+                                         double learning_rate) const {
+    double loss = net.train_on_sparse_batch(batch_inputs, batch_targets, learning_rate);
+    apply_mask(net);
+    return loss;
+}
+
+double Pruner::layer_sparsity(const Layer& layer) {
+    Matrix temp_host;
+    const Matrix* src = &layer.weights;
+    if (src->is_on_device() && src->get_device_ptr()) { temp_host = *src; temp_host.to_host(); src = &temp_host; }
+    size_t count = static_cast<size_t>(src->getRow()) * src->getCol();
+    if (count == 0) return 0.0;
+    const double* w = src->get_host_ptr();
+    return static_cast<double>(std::count(w, w + count, 0.0)) / static_cast<double>(count);
+}
+
+double Pruner::sparsity(const Network& net) {
+    double zeros = 0.0;
+    double total = 0.0;
+    for (const Layer& layer : net.getLayers()) {
+        double count = static_cast<double>(layer.weights.getRow()) * layer.weights.getCol();
+        zeros += layer_sparsity(layer) * count;
+        total += count;
+    }
+    return total > 0.0 ? zeros / total : 0.0;
+}
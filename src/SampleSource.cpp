@@ -0,0 +1,180 @@
+#include "SampleSource.h"
+#include "IdxReader.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+void one_hot(Matrix& target, int classes, double label, const std::string& where) {
+    int index = static_cast<int>(label);
+    if (static_cast<double>(index) != label || index < 0 || index >= classes) {
+        throw std::runtime_error(where + ": Class index " + std::to_string(label) + " outside [0, " + std::to_string(classes) + ")");
+    }
+    target = Matrix(classes, 1, 0.0);
+    target.setEntry(index, 0, 1.0);
+}
+
+} // namespace
+
+TextSampleSource::TextSampleSource(const std::string& _path, int input_size, int output_size)
+    : path(_path), in(nullptr), inputs(input_size), outputs(output_size), line_number(0) {
+    if (inputs <= 0 || outputs <= 0) {
+        throw std::invalid_argument("TextSampleSource: Input and output sizes must be positive.");
+    }
+    if (path == "-") {
+        in = &std::cin;
+    } else {
+        file.reset(new std::ifstream(path.c_str()));
+        if (!*file) {
+            throw std::runtime_error("TextSampleSource: Cannot open " + path + ": " + std::strerror(errno));
+        }
+        in = file.get();
+    }
+}
+
+bool TextSampleSource::next(Matrix& input, Matrix& target) {
+    std::string line;
+    while (std::getline(*in, line)) {
+        ++line_number;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        values.clear();
+        const char* p = line.c_str();
+        for (;;) {
+            while (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r') ++p;
+            if (*p == '\0') break;
+            char* end = nullptr;
+            double v = std::strtod(p, &end);
+            if (end == p) {
+                throw std::runtime_error("TextSampleSource: Bad number on line " + std::to_string(line_number) + " of " + path);
+            }
+            values.push_back(v);
+            p = end;
+        }
+
+        size_t n = values.size();
+        bool class_index = outputs > 1 && n == static_cast<size_t>(inputs) + 1;
+        if (n != static_cast<size_t>(inputs + outputs) && !class_index) {
+            throw std::runtime_error("TextSampleSource: Line " + std::to_string(line_number) + " of " + path + " has " +
+                                     std::to_string(n) + " values, expected " + std::to_string(inputs + outputs) +
+                                     (outputs > 1 ? " or " + std::to_string(inputs + 1) : std::string()));
+        }
+        input = Matrix(inputs, 1);
+        std::memcpy(input.get_host_ptr(), values.data(), sizeof(double) * static_cast<size_t>(inputs));
+        if (class_index) {
+            one_hot(target, outputs, values[static_cast<size_t>(inputs)], "TextSampleSource");
+        } else {
+            target = Matrix(outputs, 1);
+            std::memcpy(target.get_host_ptr(), values.data() + inputs, sizeof(double) * static_cast<size_t>(outputs));
+        }
+        return true;
+    }
+    if (in->bad()) {
+        throw std::runtime_error("TextSampleSource: Read failed for " + path);
+    }
+    return false;
+}
+
+BinarySampleSource::BinarySampleSource(const std::string& _path, int input_size, int output_size)
+    : path(_path), fd(-1), owns_fd(false), inputs(input_size), outputs(output_size), begin(0), end(0) {
+    if (inputs <= 0 || outputs <= 0) {
+        throw std::invalid_argument("BinarySampleSource: Input and output sizes must be positive.");
+    }
+    if (path == "-") {
+        fd = STDIN_FILENO;
+    } else {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("BinarySampleSource: Cannot open " + path + ": " + std::strerror(errno));
+        }
+        owns_fd = true;
+    }
+    size_t record = sizeof(double) * static_cast<size_t>(inputs + outputs);
+    buffer.resize(std::max<size_t>(record, 1 << 16));
+}
+
+BinarySampleSource::~BinarySampleSource() {
+    if (owns_fd) ::close(fd);
+}
+
+// Makes at least need bytes available from begin; false on a clean EOF.
+bool BinarySampleSource::fill(size_t need) {
+    if (end - begin >= need) return true;
+    std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+    end -= begin;
+    begin = 0;
+    while (end < need) {
+        ssize_t n = ::read(fd, buffer.data() + end, buffer.size() - end);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("BinarySampleSource: Read failed for " + path + ": " + std::strerror(errno));
+        }
+        if (n == 0) {
+            if (end == 0) return false;
+            throw std::runtime_error("BinarySampleSource: Truncated record at end of " + path);
+        }
+        end += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool BinarySampleSource::next(Matrix& input, Matrix& target) {
+    size_t input_bytes = sizeof(double) * static_cast<size_t>(inputs);
+    size_t output_bytes = sizeof(double) * static_cast<size_t>(outputs);
+    if (!fill(input_bytes + output_bytes)) return false;
+    input = Matrix(inputs, 1);
+    target = Matrix(outputs, 1);
+    std::memcpy(input.get_host_ptr(), buffer.data() + begin, input_bytes);
+    std::memcpy(target.get_host_ptr(), buffer.data() + begin + input_bytes, output_bytes);
+    begin += input_bytes + output_bytes;
+    return true;
+}
+
+IdxSampleSource::IdxSampleSource(const std::string& image_path, const std::string& label_path, int _classes)
+    : images(new IdxReader(IdxReader::resolve(image_path))),
+      labels(new IdxReader(IdxReader::resolve(label_path))),
+      inputs(0), classes(_classes), remaining(0) {
+    if (images->rank() < 2 || labels->rank() != 1) {
+        throw std::runtime_error("IdxSampleSource: Expected images of rank >= 2 and rank-1 labels, got " +
+                                 std::to_string(images->rank()) + " and " + std::to_string(labels->rank()));
+    }
+    if (images->dims()[0] != labels->dims()[0]) {
+        throw std::runtime_error("IdxSampleSource: " + std::to_string(images->dims()[0]) + " images but " +
+                                 std::to_string(labels->dims()[0]) + " labels");
+    }
+    long long size = 1;
+    for (int d = 1; d < images->rank(); ++d) size *= images->dims()[static_cast<size_t>(d)];
+    if (size > 0x7fffffffLL) {
+        throw std::runtime_error("IdxSampleSource: Images too large in " + images->path());
+    }
+    inputs = static_cast<int>(size);
+    remaining = images->dims()[0];
+    if (images->type() == IdxType::UInt8) pixels.resize(static_cast<size_t>(inputs));
+}
+
+IdxSampleSource::~IdxSampleSource() {}
+
+bool IdxSampleSource::next(Matrix& input, Matrix& target) {
+    if (remaining == 0) return false;
+    --remaining;
+    input = Matrix(inputs, 1);
+    if (images->type() == IdxType::UInt8) {
+        images->read_bytes(pixels.data(), pixels.size());
+        double* x = input.get_host_ptr();
+        for (int i = 0; i < inputs; ++i) x[i] = static_cast<double>(pixels[static_cast<size_t>(i)]) / 255.0;
+    } else {
+        images->read_values(input.get_host_ptr(), static_cast<size_t>(inputs));
+    }
+    double label = 0.0;
+    labels->read_values(&label, 1);
+    one_hot(target, classes, label, "IdxSampleSource");
+    return true;
+}
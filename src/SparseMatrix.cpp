@@ -0,0 +1,269 @@
+#include "SparseMatrix.h"
+#include <stdexcept>
+#include <string>
+
+SparseMatrix::SparseMatrix()
+    : rows_val(0), cols_val(0), row_ptr(1, 0) {}
+
+SparseMatrix::SparseMatrix(int c)
+    : rows_val(0), cols_val(c), row_ptr(1, 0) {
+    if (c < 0) {
+        throw std::invalid_argument("SparseMatrix dimensions cannot be negative.");
+    }
+}
+
+SparseMatrix SparseMatrix::fromDense(const Matrix& m) {
+    Matrix temp_host;
+    const Matrix* src = &m;
+    if (m.is_on_device() && m.get_device_ptr()) { temp_host = m; temp_host.to_host(); src = &temp_host; }
+
+    SparseMatrix result(src->getCol());
+    if (src->getRow() == 0 || src->getCol() == 0) {
+        for (int i = 0; i < src->getRow(); ++i) result.appendRow(static_cast<const double*>(nullptr), 0);
+        return result;
+    }
+    const double* data = src->get_host_ptr();
+    if (data == nullptr) {
+        throw std::runtime_error("SparseMatrix::fromDense: Host data empty.");
+    }
+    for (int i = 0; i < src->getRow(); ++i) {
+        result.appendRow(data + static_cast<size_t>(i) * src->getCol(), src->getCol());
+    }
+    return result;
+}
+
+void SparseMatrix::reserve(size_t rows, size_t non_zeros) {
+    row_ptr.reserve(rows + 1);
+    col_indices.reserve(non_zeros);
+    values.reserve(non_zeros);
+}
+
+void SparseMatrix::appendRow(const double* dense_row, int n) {
+    if (n != cols_val) {
+        throw std::invalid_argument("SparseMatrix::appendRow: Row length " + std::to_string(n) +
+                                    " does not match column count " + std::to_string(cols_val));
+    }
+    for (int j = 0; j < n; ++j) {
+        if (dense_row[j] != 0.0) {
+            col_indices.push_back(j);
+            values.push_back(dense_row[j]);
+        }
+    }
+    row_ptr.push_back(static_cast<int>(values.size()));
+    rows_val++;
+}
+
+void SparseMatrix::appendRow(const unsigned char* dense_row, int n, double scale) {
+    if (n != cols_val) {
+        throw std::invalid_argument("SparseMatrix::appendRow: Row length " + std::to_string(n) +
+                                    " does not match column count " + std::to_string(cols_val));
+    }
+    for (int j = 0; j < n; ++j) {
+        if (dense_row[j] != 0) {
+            col_indices.push_back(j);
+            values.push_back(static_cast<double>(dense_row[j]) * scale);
+        }
+    }
+    row_ptr.push_back(static_cast<int>(values.size()));
+    rows_val++;
+}
+
+void SparseMatrix::appendRow(const SparseMatrix& source, int r) {
+    if (source.cols_val != cols_val) {
+        throw std::invalid_argument("SparseMatrix::appendRow: Source has " + std::to_string(source.cols_val) +
+                                    " columns, expected " + std::to_string(cols_val));
+    }
+    if (r < 0 || r >= source.rows_val) {
+        throw std::out_of_range("SparseMatrix::appendRow: Row " + std::to_string(r) + " out of bounds for " +
+                                std::to_string(source.rows_val) + " rows.");
+    }
+    int start = source.row_ptr[static_cast<size_t>(r)];
+    int stop = source.row_ptr[static_cast<size_t>(r) + 1];
+    col_indices.insert(col_indices.end(), source.col_indices.begin() + start, source.col_indices.begin() + stop);
+    values.insert(values.end(), source.values.begin() + start, source.values.begin() + stop);
+    row_ptr.push_back(static_cast<int>(values.size()));
+    rows_val++;
+}
+
+SparseMatrix SparseMatrix::row(int r) const {
+    if (r < 0 || r >= rows_val) {
+        throw std::out_of_range("SparseMatrix::row: Row " + std::to_string(r) + " out of bounds for " +
+                                std::to_string(rows_val) + " rows.");
+    }
+    SparseMatrix result(cols_val);
+    int start = row_ptr[static_cast<size_t>(r)];
+    int stop = row_ptr[static_cast<size_t>(r) + 1];
+    result.col_indices.assign(col_indices.begin() + start, col_indices.begin() + stop);
+    result.values.assign(values.begin() + start, values.begin() + stop);
+    result.row_ptr.push_back(stop - start);
+    result.rows_val = 1;
+    return result;
+}
+
+SparseMatrix SparseMatrix::gatherRows(const std::vector<size_t>& indices, size_t begin, size_t end) const {
+    if (begin > end || end > indices.size()) {
+        throw std::out_of_range("SparseMatrix::gatherRows: Invalid index range.");
+    }
+    size_t total_nnz = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (indices[i] >= static_cast<size_t>(rows_val)) {
+            throw std::out_of_range("SparseMatrix::gatherRows: Row " + std::to_string(indices[i]) + " out of bounds.");
+        }
+        total_nnz += static_cast<size_t>(row_ptr[indices[i] + 1] - row_ptr[indices[i]]);
+    }
+
+    SparseMatrix result(cols_val);
+    result.reserve(end - begin, total_nnz);
+    for (size_t i = begin; i < end; ++i) {
+        int start = row_ptr[indices[i]];
+        int stop = row_ptr[indices[i] + 1];
+        result.col_indices.insert(result.col_indices.end(), col_indices.begin() + start, col_indices.begin() + stop);
+        result.values.insert(result.values.end(), values.begin() + start, values.begin() + stop);
+        result.row_ptr.push_back(static_cast<int>(result.values.size()));
+        result.rows_val++;
+    }
+    return result;
+}
+
+Matrix SparseMatrix::toDense() const {
+    Matrix result(rows_val, cols_val, 0.0);
+    if (rows_val == 0 || cols_val == 0) return result;
+
+    double* out = result.get_host_ptr();
+    for (int r = 0; r < rows_val; ++r) {
+        for (int p = row_ptr[static_cast<size_t>(r)]; p < row_ptr[static_cast<size_t>(r) + 1]; ++p) {
+            out[static_cast<size_t>(r) * cols_val + col_indices[static_cast<size_t>(p)]] = values[static_cast<size_t>(p)];
+        }
+    }
+    return result;
+}
+
+Matrix SparseMatrix::multiply(const MatrixView& dense) const {
+    if (dense.getRow() != cols_val) {
+        throw std::invalid_argument("SparseMatrix::multiply: Dimensions not compatible. Sparse: " +
+                                    std::to_string(rows_val) + "x" + std::to_string(cols_val) +
+                                    ", Dense: " + std::to_string(dense.getRow()) + "x" + std::to_string(dense.getCol()));
+    }
+    int n = dense.getCol();
+    Matrix result(rows_val, n, 0.0);
+    if (rows_val == 0 || n == 0 || values.empty()) return result;
+
+    double* out = result.get_host_ptr();
+    const double* x = dense.data();
+    long rs = dense.getRowStride();
+    long cs = dense.getColStride();
+    const int* rp = row_ptr.data();
+    const int* ci = col_indices.data();
+    const double* vals = values.data();
+
+    if (n == 1) {
+        // Gathered dot product per row, with independent accumulators to hide FMA latency.
+        for (int r = 0; r < rows_val; ++r) {
+            int p = rp[r];
+            int stop = rp[r + 1];
+            double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+            for (; p + 3 < stop; p += 4) {
+                s0 += vals[p] * x[ci[p] * rs];
+                s1 += vals[p + 1] * x[ci[p + 1] * rs];
+                s2 += vals[p + 2] * x[ci[p + 2] * rs];
+                s3 += vals[p + 3] * x[ci[p + 3] * rs];
+            }
+            for (; p < stop; ++p) {
+                s0 += vals[p] * x[ci[p] * rs];
+            }
+            out[r] = (s0 + s1) + (s2 + s3);
+        }
+        return result;
+    }
+
+    for (int r = 0; r < rows_val; ++r) {
+        double* out_row = out + static_cast<size_t>(r) * n;
+        for (int p = rp[r]; p < rp[r + 1]; ++p) {
+            double v = vals[p];
+            const double* x_row = x + ci[p] * rs;
+            if (cs == 1) {
+                for (int j = 0; j < n; ++j) {
+                    out_row[j] += v * x_row[j];
+                }
+            } else {
+                for (int j = 0; j < n; ++j) {
+                    out_row[j] += v * x_row[j * cs];
+                }
+            }
+        }
+    }
+    return result;
+}
+
+Matrix SparseMatrix::leftMultiply(const Matrix& dense) const {
+    if (dense.getCol() != cols_val) {
+        throw std::invalid_argument("SparseMatrix::leftMultiply: Dimensions not compatible. Dense: " +
+                                    std::to_string(dense.getRow()) + "x" + std::to_string(dense.getCol()) +
+                                    ", Sparse^T: " + std::to_string(cols_val) + "x" + std::to_string(rows_val));
+    }
+    int m = dense.getRow();
+    Matrix result(m, rows_val, 0.0);
+    if (m == 0 || rows_val == 0 || cols_val == 0) return result;
+
+    Matrix temp_host;
+    const Matrix* lhs = &dense;
+    if (dense.is_on_device() && dense.get_device_ptr()) { temp_host = dense; temp_host.to_host(); lhs = &temp_host; }
+    const double* w = lhs->get_host_ptr();
+    if (w == nullptr) {
+        throw std::runtime_error("SparseMatrix::leftMultiply: Dense host data empty.");
+    }
+
+    double* out = result.get_host_ptr();
+    const int* rp = row_ptr.data();
+    const int* ci = col_indices.data();
+    const double* vals = values.data();
+    for (int i = 0; i < m; ++i) {
+        const double* w_row = w + static_cast<size_t>(i) * cols_val;
+        double* out_row = out + static_cast<size_t>(i) * rows_val;
+        for (int b = 0; b < rows_val; ++b) {
+            double sum = 0.0;
+            for (int p = rp[b]; p < rp[b + 1]; ++p) {
+                sum += w_row[ci[p]] * vals[p];
+            }
+            out_row[b] = sum;
+        }
+    }
+    return result;
+}
+
+void SparseMatrix::accumulateOuterProduct(const Matrix& d_z, Matrix& target) const {
+    if (d_z.getCol() != rows_val || target.getRow() != d_z.getRow() || target.getCol() != cols_val) {
+        throw std::invalid_argument("SparseMatrix::accumulateOuterProduct: Dimensions not compatible. d_z: " +
+                                    std::to_string(d_z.getRow()) + "x" + std::to_string(d_z.getCol()) +
+                                    ", sparse: " + std::to_string(rows_val) + "x" + std::to_string(cols_val) +
+                                    ", target: " + std::to_string(target.getRow()) + "x" + std::to_string(target.getCol()));
+    }
+    int m = d_z.getRow();
+    if (m == 0 || rows_val == 0 || cols_val == 0) return;
+
+    Matrix temp_host;
+    const Matrix* grad = &d_z;
+    if (d_z.is_on_device() && d_z.get_device_ptr()) { temp_host = d_z; temp_host.to_host(); grad = &temp_host; }
+    if (target.is_on_device() && target.get_device_ptr()) { target.to_host(); }
+
+    const double* g = grad->get_host_ptr();
+    double* t = target.get_host_ptr();
+    if (g == nullptr || t == nullptr) {
+        throw std::runtime_error("SparseMatrix::accumulateOuterProduct: Host data empty.");
+    }
+
+    const int* rp = row_ptr.data();
+    const int* ci = col_indices.data();
+    const double* vals = values.data();
+    for (int i = 0; i < m; ++i) {
+        double* t_row = t + static_cast<size_t>(i) * cols_val;
+        const double* g_row = g + static_cast<size_t>(i) * rows_val;
+        for (int b = 0; b < rows_val; ++b) {
+            double scale = g_row[b];
+            if (scale == 0.0) continue;
+            for (int p = rp[b]; p < rp[b + 1]; ++p) {
+                t_row[ci[p]] += scale * vals[p];
+            }
+        }
+    }
+}
@@ -0,0 +1,325 @@
+#include "SpatialLayer.h"
+#include "Layer.h"
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+double random_spatial_weight(double min, double max) {
+    return min + (static_cast<double>(rand()) / RAND_MAX) * (max - min);
+}
+
+int output_extent(int in, int kernel, int stride, int padding) {
+    int span = in + 2 * padding - kernel;
+    return span < 0 ? 0 : span / stride + 1;
+}
+
+} // namespace
+
+SpatialLayer::SpatialLayer(SpatialLayerType _type, const SpatialShape& input, int out_channels, int kernel_size,
+                           int _stride, int _padding, const std::string& activation)
+    : activationName(activation),
+      type(_type),
+      input_shape(input),
+      kernel(kernel_size),
+      stride(_stride),
+      padding(_padding)
+{
+    if (input.channels <= 0 || input.height <= 0 || input.width <= 0) {
+        throw std::invalid_argument("SpatialLayer: Input shape must be positive.");
+    }
+    if (kernel <= 0 || stride <= 0 || padding < 0 || out_channels <= 0) {
+        throw std::invalid_argument("SpatialLayer: Kernel, stride and channel count must be positive and padding non-negative.");
+    }
+    try {
+        activation_kind = activations::parse(activationName);
+    } catch (const std::invalid_argument&) {
+        throw std::invalid_argument("SpatialLayer: Unsupported activation function: " + activationName);
+    }
+
+    output_shape = SpatialShape(out_channels,
+                                output_extent(input.height, kernel, stride, padding),
+                                output_extent(input.width, kernel, stride, padding));
+    if (output_shape.height <= 0 || output_shape.width <= 0) {
+        throw std::invalid_argument("SpatialLayer: Kernel " + std::to_string(kernel) + " does not fit a " +
+                                    std::to_string(input.height) + "x" + std::to_string(input.width) + " input.");
+    }
+
+    if (type == SpatialLayerType::Conv2D) {
+        int fan_in = input.channels * kernel * kernel;
+        weights = Matrix(out_channels, fan_in);
+        biases = Matrix(out_channels, 1);
+        double limit = std::sqrt(6.0 / (static_cast<double>(fan_in) + static_cast<double>(out_channels * kernel * kernel)));
+        double* w = weights.get_host_ptr();
+        for (size_t i = 0; i < static_cast<size_t>(out_channels) * fan_in; ++i) {
+            w[i] = random_spatial_weight(-limit, limit);
+        }
+        double bias_init_val = (activationName == "relu") ? 0.01 : 0.0;
+        std::fill(biases.get_host_ptr(), biases.get_host_ptr() + out_channels, bias_init_val);
+    }
+    zero_deltas();
+}
+
+void SpatialLayer::initialize_parameters(const WeightInit& init, const WeightInitializer& rng, uint64_t stream) {
+    if (!has_parameters()) return;
+    int fan_in = weights.getCol();
+    int fan_out = weights.getRow() * kernel * kernel;
+    rng.fill(weights.get_host_ptr(), static_cast<size_t>(weights.getRow()) * fan_in, init, fan_in, fan_out, stream);
+    double bias_init_val = (activationName == "relu") ? 0.01 : 0.0;
+    std::fill(biases.get_host_ptr(), biases.get_host_ptr() + biases.getRow(), bias_init_val);
+}
+
+SpatialLayer SpatialLayer::conv2d(const SpatialShape& input, int out_channels, int kernel_size,
+                                  int stride, int padding, const std::string& activation) {
+    return SpatialLayer(SpatialLayerType::Conv2D, input, out_channels, kernel_size, stride, padding, activation);
+}
+
+SpatialLayer SpatialLayer::max_pool(const SpatialShape& input, int window, int stride) {
+    return SpatialLayer(SpatialLayerType::MaxPool2D, input, input.channels, window, stride == 0 ? window : stride, 0, "linear");
+}
+
+SpatialLayer SpatialLayer::avg_pool(const SpatialShape& input, int window, int stride) {
+    return SpatialLayer(SpatialLayerType::AvgPool2D, input, input.channels, window, stride == 0 ? window : stride, 0, "linear");
+}
+
+void SpatialLayer::im2col(const double* image, const SpatialShape& shape, int kernel, int stride, int padding,
+                          int out_h, int out_w, double* cols) {
+    size_t positions = static_cast<size_t>(out_h) * out_w;
+    for (int c = 0; c < shape.channels; ++c) {
+        const double* plane = image + static_cast<size_t>(c) * shape.height * shape.width;
+        for (int ky = 0; ky < kernel; ++ky) {
+            for (int kx = 0; kx < kernel; ++kx) {
+                double* col_row = cols + (static_cast<size_t>(c) * kernel * kernel + ky * kernel + kx) * positions;
+                for (int oy = 0; oy < out_h; ++oy) {
+                    int y = oy * stride + ky - padding;
+                    double* out = col_row + static_cast<size_t>(oy) * out_w;
+                    if (y < 0 || y >= shape.height) {
+                        std::fill(out, out + out_w, 0.0);
+                        continue;
+                    }
+                    const double* in_row = plane + static_cast<size_t>(y) * shape.width;
+                    for (int ox = 0; ox < out_w; ++ox) {
+                        int x = ox * stride + kx - padding;
+                        out[ox] = (x >= 0 && x < shape.width) ? in_row[x] : 0.0;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void SpatialLayer::col2im(const double* cols, const SpatialShape& shape, int kernel, int stride, int padding,
+                          int out_h, int out_w, double* image) {
+    size_t positions = static_cast<size_t>(out_h) * out_w;
+    for (int c = 0; c < shape.channels; ++c) {
+        double* plane = image + static_cast<size_t>(c) * shape.height * shape.width;
+        for (int ky = 0; ky < kernel; ++ky) {
+            for (int kx = 0; kx < kernel; ++kx) {
+                const double* col_row = cols + (static_cast<size_t>(c) * kernel * kernel + ky * kernel + kx) * positions;
+                for (int oy = 0; oy < out_h; ++oy) {
+                    int y = oy * stride + ky - padding;
+                    if (y < 0 || y >= shape.height) continue;
+                    double* in_row = plane + static_cast<size_t>(y) * shape.width;
+                    const double* src = col_row + static_cast<size_t>(oy) * out_w;
+                    for (int ox = 0; ox < out_w; ++ox) {
+                        int x = ox * stride + kx - padding;
+                        if (x >= 0 && x < shape.width) in_row[x] += src[ox];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void SpatialLayer::forward_sample(const double* image, double* output, Matrix* cols_out, Matrix* z_out,
+                                  std::vector<int>* argmax_out) const {
+    int out_h = output_shape.height;
+    int out_w = output_shape.width;
+    size_t positions = static_cast<size_t>(out_h) * out_w;
+
+    if (type == SpatialLayerType::Conv2D) {
+        Matrix cols(input_shape.channels * kernel * kernel, static_cast<int>(positions));
+        im2col(image, input_shape, kernel, stride, padding, out_h, out_w, cols.get_host_ptr());
+
+        Matrix z = Matrix::multiply(weights.view(), cols.view());
+        double* z_data = z.get_host_ptr();
+        const double* b = biases.get_host_ptr();
+        for (int oc = 0; oc < output_shape.channels; ++oc) {
+            double* z_row = z_data + static_cast<size_t>(oc) * positions;
+            for (size_t p = 0; p < positions; ++p) {
+                z_row[p] += b[oc];
+            }
+        }
+        activations::apply(activation_kind, z_data, output, static_cast<size_t>(output_shape.channels) * positions);
+        if (cols_out) *cols_out = std::move(cols);
+        if (z_out) *z_out = std::move(z);
+        return;
+    }
+
+    if (argmax_out) argmax_out->resize(static_cast<size_t>(output_shape.size()));
+    double inv_window = 1.0 / static_cast<double>(kernel * kernel);
+    for (int c = 0; c < input_shape.channels; ++c) {
+        size_t plane_offset = static_cast<size_t>(c) * input_shape.height * input_shape.width;
+        for (int oy = 0; oy < out_h; ++oy) {
+            for (int ox = 0; ox < out_w; ++ox) {
+                size_t out_index = static_cast<size_t>(c) * positions + static_cast<size_t>(oy) * out_w + ox;
+                double best = -std::numeric_limits<double>::infinity();
+                int best_index = -1;
+                double sum = 0.0;
+                for (int ky = 0; ky < kernel; ++ky) {
+                    for (int kx = 0; kx < kernel; ++kx) {
+                        int index = static_cast<int>(plane_offset) + (oy * stride + ky) * input_shape.width + ox * stride + kx;
+                        double v = image[index];
+                        sum += v;
+                        if (v > best) { best = v; best_index = index; }
+                    }
+                }
+                if (type == SpatialLayerType::MaxPool2D) {
+                    output[out_index] = best;
+                    if (argmax_out) (*argmax_out)[out_index] = best_index;
+                } else {
+                    output[out_index] = sum * inv_window;
+                }
+            }
+        }
+    }
+}
+
+Matrix SpatialLayer::forward(const MatrixView& input) {
+    if (input.getRow() != getInputSize() || input.getCol() != 1) {
+        throw std::invalid_argument("SpatialLayer::forward: Expected a " + std::to_string(getInputSize()) + "x1 sample, got " +
+                                    std::to_string(input.getRow()) + "x" + std::to_string(input.getCol()));
+    }
+    Matrix image = input.is_contiguous() ? Matrix() : Matrix(input);
+    const double* image_data = input.is_contiguous() ? input.data() : image.get_host_ptr();
+
+    Matrix output(getOutputSize(), 1);
+    if (type == SpatialLayerType::Conv2D) {
+        forward_sample(image_data, output.get_host_ptr(), &last_cols, &last_z, nullptr);
+    } else {
+        forward_sample(image_data, output.get_host_ptr(), nullptr, nullptr,
+                       type == SpatialLayerType::MaxPool2D ? &last_argmax : nullptr);
+        last_z = output;
+    }
+    return output;
+}
+
+Matrix SpatialLayer::infer(const MatrixView& input) const {
+    if (input.getRow() != getInputSize()) {
+        throw std::invalid_argument("SpatialLayer::infer: Expected " + std::to_string(getInputSize()) + " rows, got " +
+                                    std::to_string(input.getRow()));
+    }
+    int batch = input.getCol();
+    Matrix output(getOutputSize(), batch);
+    if (batch == 0) return output;
+
+    // Samples are columns; forward_sample wants each one packed.
+    Matrix samples = Matrix::transpose(input);
+    Matrix sample_output = (batch == 1) ? Matrix() : Matrix(getOutputSize(), 1);
+    double* out = output.get_host_ptr();
+    for (int b = 0; b < batch; ++b) {
+        const double* image = samples.get_host_ptr() + static_cast<size_t>(b) * getInputSize();
+        if (batch == 1) {
+            forward_sample(image, out, nullptr, nullptr, nullptr);
+            break;
+        }
+        forward_sample(image, sample_output.get_host_ptr(), nullptr, nullptr, nullptr);
+        const double* src = sample_output.get_host_ptr();
+        for (int r = 0; r < getOutputSize(); ++r) {
+            out[static_cast<size_t>(r) * batch + b] = src[r];
+        }
+    }
+    return output;
+}
+
+Matrix SpatialLayer::backward(const Matrix& d_output, bool accumulate) {
+    if (d_output.getRow() != getOutputSize() || d_output.getCol() != 1) {
+        throw std::invalid_argument("SpatialLayer::backward: Expected a " + std::to_string(getOutputSize()) + "x1 gradient, got " +
+                                    std::to_string(d_output.getRow()) + "x" + std::to_string(d_output.getCol()));
+    }
+    if (!has_cached_activations()) {
+        throw std::logic_error("SpatialLayer::backward: No cached forward pass.");
+    }
+    Matrix grad_host;
+    const Matrix* grad = &d_output;
+    if (d_output.is_on_device() && d_output.get_device_ptr()) { grad_host = d_output; grad_host.to_host(); grad = &grad_host; }
+    const double* g = grad->get_host_ptr();
+
+    Matrix d_input(getInputSize(), 1, 0.0);
+    double* d_in = d_input.get_host_ptr();
+    size_t positions = static_cast<size_t>(output_shape.height) * output_shape.width;
+
+    if (type == SpatialLayerType::MaxPool2D) {
+        for (size_t i = 0; i < last_argmax.size(); ++i) {
+            d_in[last_argmax[i]] += g[i];
+        }
+        return d_input;
+    }
+    if (type == SpatialLayerType::AvgPool2D) {
+        double inv_window = 1.0 / static_cast<double>(kernel * kernel);
+        for (int c = 0; c < input_shape.channels; ++c) {
+            size_t plane_offset = static_cast<size_t>(c) * input_shape.height * input_shape.width;
+            for (int oy = 0; oy < output_shape.height; ++oy) {
+                for (int ox = 0; ox < output_shape.width; ++ox) {
+                    double share = g[static_cast<size_t>(c) * positions + static_cast<size_t>(oy) * output_shape.width + ox] * inv_window;
+                    for (int ky = 0; ky < kernel; ++ky) {
+                        for (int kx = 0; kx < kernel; ++kx) {
+                            d_in[plane_offset + static_cast<size_t>(oy * stride + ky) * input_shape.width + ox * stride + kx] += share;
+                        }
+                    }
+                }
+            }
+        }
+        return d_input;
+    }
+
+    int out_channels = output_shape.channels;
+    Matrix d_z(out_channels, static_cast<int>(positions));
+    double* dz = d_z.get_host_ptr();
+    const double* z = last_z.get_host_ptr();
+    activations::gradient_from_input(activation_kind, z, g, dz, static_cast<size_t>(out_channels) * positions);
+
+    if (accumulate) {
+        Matrix grad_weights = Matrix::multiply(d_z.view(), last_cols.view().transpose());
+        double* dw = delta_weights.get_host_ptr();
+        const double* gw = grad_weights.get_host_ptr();
+        for (size_t i = 0; i < static_cast<size_t>(grad_weights.getRow()) * grad_weights.getCol(); ++i) {
+            dw[i] += gw[i];
+        }
+        double* db = delta_biases.get_host_ptr();
+        for (int oc = 0; oc < out_channels; ++oc) {
+            double sum = 0.0;
+            for (size_t p = 0; p < positions; ++p) sum += dz[static_cast<size_t>(oc) * positions + p];
+            db[oc] += sum;
+        }
+    }
+
+    Matrix d_cols = Matrix::multiply(weights.view().transpose(), d_z.view());
+    col2im(d_cols.get_host_ptr(), input_shape, kernel, stride, padding,
+           output_shape.height, output_shape.width, d_in);
+    return d_input;
+}
+
+void SpatialLayer::release_activations() {
+    last_cols = Matrix();
+    last_z = Matrix();
+    last_argmax.clear();
+}
+
+void SpatialLayer::zero_deltas() {
+    delta_weights = Matrix(weights.getRow(), weights.getCol(), 0.0);
+    delta_biases = Matrix(biases.getRow(), biases.getCol(), 0.0);
+}
+
+void SpatialLayer::update_parameters_from_deltas(double learning_rate, int batch_size) {
+    if (batch_size <= 0) {
+        throw std::invalid_argument("SpatialLayer::update_parameters_from_deltas: Batch size must be positive.");
+    }
+    if (!has_parameters()) return;
+    double scale = learning_rate / static_cast<double>(batch_size);
+    this->weights = this->weights.subtract(this->delta_weights.multiplyScalar(scale));
+    this->biases = this->biases.subtract(this->delta_biases.multiplyScalar(scale));
+}
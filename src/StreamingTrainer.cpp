@@ -0,0 +1,176 @@
+#include "StreamingTrainer.h"
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // namespace
+
+std::string StreamingStats::to_string() const {
+    std::ostringstream out;
+    out << "samples " << samples << ", batches " << batches
+        << ", loss " << std::fixed << std::setprecision(6) << window_loss
+        << ", " << std::setprecision(0) << samples_per_second() << " samples/s"
+        << ", waited " << std::setprecision(2) << wait_seconds << " s";
+    return out.str();
+}
+
+StreamingTrainer::StreamingTrainer(Network& _net, SampleSource& _source, const StreamingConfig& _config)
+    : net(_net), source(_source), config(_config), source_done(false), stop_requested(false), rng(_config.seed) {
+    if (config.batch_size <= 0 || config.prefetch <= 0 || config.shuffle_buffer < 0 ||
+        config.max_samples < 0 || config.report_every < 0) {
+        throw std::invalid_argument("StreamingTrainer: batch_size and prefetch must be positive, other limits non-negative.");
+    }
+    const std::vector<Layer>& layers = net.getLayers();
+    if (layers.empty() || layers.front().weights.getCol() != source.input_size() ||
+        layers.back().weights.getRow() != source.output_size()) {
+        throw std::invalid_argument("StreamingTrainer: Source produces " + std::to_string(source.input_size()) + " -> " +
+                                    std::to_string(source.output_size()) + " samples, which do not fit the network.");
+    }
+}
+
+StreamingTrainer::~StreamingTrainer() {
+    stop();
+    join_prefetch();
+}
+
+void StreamingTrainer::stop() {
+    stop_requested = true;
+    std::lock_guard<std::mutex> lock(mutex);
+    space_cv.notify_all();
+    ready_cv.notify_all();
+}
+
+void StreamingTrainer::join_prefetch() {
+    if (prefetcher.joinable()) prefetcher.join();
+}
+
+void StreamingTrainer::prefetch_loop() {
+    try {
+        long long read = 0;
+        while (!stop_requested && (config.max_samples == 0 || read < config.max_samples)) {
+            Sample sample;
+            if (!source.next(sample.input, sample.target)) break;
+            ++read;
+            std::unique_lock<std::mutex> lock(mutex);
+            space_cv.wait(lock, [this] { return stop_requested || queue.size() < static_cast<size_t>(config.prefetch); });
+            if (stop_requested) break;
+            queue.push_back(std::move(sample));
+            ready_cv.notify_one();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        source_error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    source_done = true;
+    ready_cv.notify_all();
+}
+
+bool StreamingTrainer::pop(Sample& sample, double& waited) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (queue.empty() && !source_done && !stop_requested) {
+        Clock::time_point start = Clock::now();
+        ready_cv.wait(lock, [this] { return !queue.empty() || source_done || stop_requested; });
+        waited += seconds_since(start);
+    }
+    if (queue.empty() || stop_requested) return false;
+    sample = std::move(queue.front());
+    queue.pop_front();
+    space_cv.notify_one();
+    return true;
+}
+
+bool StreamingTrainer::next_shuffled(Sample& sample, double& waited) {
+    if (config.shuffle_buffer == 0) return pop(sample, waited);
+
+    Sample incoming;
+    while (shuffle.size() < static_cast<size_t>(config.shuffle_buffer)) {
+        if (!pop(incoming, waited)) break;
+        shuffle.push_back(std::move(incoming));
+    }
+    if (shuffle.empty()) return false;
+
+    size_t slot = std::uniform_int_distribution<size_t>(0, shuffle.size() - 1)(rng);
+    sample = std::move(shuffle[slot]);
+    if (pop(incoming, waited)) {
+        shuffle[slot] = std::move(incoming);
+    } else {
+        // Source exhausted: drain the buffer in random order.
+        shuffle[slot] = std::move(shuffle.back());
+        shuffle.pop_back();
+    }
+    return true;
+}
+
+StreamingStats StreamingTrainer::run(const Reporter& on_report) {
+    if (prefetcher.joinable()) {
+        throw std::logic_error("StreamingTrainer::run: Already running.");
+    }
+    stop_requested = false;
+    source_done = false;
+    source_error = nullptr;
+    queue.clear();
+    shuffle.clear();
+    shuffle.reserve(static_cast<size_t>(config.shuffle_buffer));
+
+    StreamingStats stats;
+    Clock::time_point start = Clock::now();
+    prefetcher = std::thread(&StreamingTrainer::prefetch_loop, this);
+
+    std::vector<Matrix> inputs;
+    std::vector<Matrix> targets;
+    inputs.reserve(static_cast<size_t>(config.batch_size));
+    targets.reserve(static_cast<size_t>(config.batch_size));
+    double window_sum = 0.0;
+    long long window_batches = 0;
+
+    try {
+        Sample sample;
+        bool more = true;
+        while (more) {
+            more = next_shuffled(sample, stats.wait_seconds);
+            if (more) {
+                inputs.push_back(std::move(sample.input));
+                targets.push_back(std::move(sample.target));
+                if (inputs.size() < static_cast<size_t>(config.batch_size)) continue;
+            }
+            if (inputs.empty()) break;
+
+            window_sum += net.train_on_batch(inputs, targets, config.learning_rate);
+            ++window_batches;
+            stats.samples += static_cast<long long>(inputs.size());
+            ++stats.batches;
+            inputs.clear();
+            targets.clear();
+
+            if (on_report && config.report_every > 0 && stats.batches % config.report_every == 0) {
+                stats.window_loss = window_sum / window_batches;
+                stats.seconds = seconds_since(start);
+                on_report(stats);
+                window_sum = 0.0;
+                window_batches = 0;
+            }
+        }
+    } catch (...) {
+        stop();
+        join_prefetch();
+        throw;
+    }
+
+    stop();
+    join_prefetch();
+    if (source_error) std::rethrow_exception(source_error);
+
+    if (window_batches > 0) stats.window_loss = window_sum / window_batches;
+    stats.seconds = seconds_since(start);
+    return stats;
+}
@@ -0,0 +1,378 @@
+#include "SweepRunner.h"
+#include "BackgroundEvaluator.h"
+#include <stdexcept>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <chrono>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+std::string join(const std::vector<std::string>& parts, char sep) {
+    std::string out;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (i) out += sep;
+        out += parts[i];
+    }
+    return out;
+}
+
+} // namespace
+
+struct SweepRunner::Trial {
+    TrialResult result;
+    std::unique_ptr<Network> net;
+    std::default_random_engine rng;
+    std::vector<size_t> order;
+    double cost;        // seconds of the last epoch; the parameter count before the first
+    bool running;
+    bool done;
+
+    Trial() : cost(0.0), running(false), done(false) {}
+};
+
+std::string to_string(TrialStatus status) {
+    switch (status) {
+    case TrialStatus::Pending: return "pending";
+    case TrialStatus::Running: return "running";
+    case TrialStatus::Completed: return "completed";
+    case TrialStatus::Stopped: return "stopped";
+    case TrialStatus::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+std::string TrialConfig::layers_to_string() const {
+    std::string out;
+    for (size_t i = 0; i < layer_sizes.size(); ++i) {
+        if (i) out += "-";
+        out += std::to_string(layer_sizes[i]);
+    }
+    return out;
+}
+
+SweepRunner::SweepRunner(const std::vector<Matrix>& train_inputs, const std::vector<Matrix>& train_targets,
+                         const std::vector<Matrix>& val_inputs, const std::vector<Matrix>& val_targets)
+    : inputs(&train_inputs), sparse_inputs(nullptr), targets(train_targets),
+      validation_inputs(val_inputs), validation_targets(val_targets), sample_count(train_inputs.size()),
+      next_rung(0), running(0)
+{
+    if (train_inputs.size() != train_targets.size() || val_inputs.size() != val_targets.size()) {
+        throw std::invalid_argument("SweepRunner: Inputs and targets differ in length.");
+    }
+    if (train_inputs.empty() || val_inputs.empty()) {
+        throw std::invalid_argument("SweepRunner: Training and validation sets must not be empty.");
+    }
+}
+
+SweepRunner::SweepRunner(const SparseMatrix& train_inputs, const std::vector<Matrix>& train_targets,
+                         const std::vector<Matrix>& val_inputs, const std::vector<Matrix>& val_targets)
+    : inputs(nullptr), sparse_inputs(&train_inputs), targets(train_targets),
+      validation_inputs(val_inputs), validation_targets(val_targets), sample_count(static_cast<size_t>(train_inputs.getRow())),
+      next_rung(0), running(0)
+{
+    if (sample_count != train_targets.size() || val_inputs.size() != val_targets.size()) {
+        throw std::invalid_argument("SweepRunner: Inputs and targets differ in length.");
+    }
+    if (sample_count == 0 || val_inputs.empty()) {
+        throw std::invalid_argument("SweepRunner: Training and validation sets must not be empty.");
+    }
+}
+
+SweepRunner::~SweepRunner() {}
+
+void SweepRunner::validate(const TrialConfig& config) const {
+    int features = sparse_inputs ? sparse_inputs->getCol() : (*inputs)[0].getRow();
+    if (config.layer_sizes.size() < 2 || config.activations.size() + 1 != config.layer_sizes.size()) {
+        throw std::invalid_argument("needs one activation per layer after the input");
+    }
+    if (config.layer_sizes.front() != features || config.layer_sizes.back() != targets[0].getRow()) {
+        throw std::invalid_argument("layers " + config.layers_to_string() + " do not match " + std::to_string(features) +
+                                    " features and " + std::to_string(targets[0].getRow()) + " outputs");
+    }
+    if (!(config.learning_rate > 0.0) || config.batch_size <= 0 || config.epochs <= 0) {
+        throw std::invalid_argument("learning rate, batch size and epochs must be positive");
+    }
+}
+
+std::vector<TrialResult> SweepRunner::run(const std::vector<TrialConfig>& configs, ThreadPool& pool,
+                                          const EarlyStopping& early_stopping, const Callback& callback) {
+    if (early_stopping.first_rung < 0 || (early_stopping.first_rung > 0 && early_stopping.reduction < 2) ||
+        early_stopping.min_survivors < 1 || early_stopping.patience < 0) {
+        throw std::invalid_argument("SweepRunner::run: Early stopping needs first_rung >= 0, reduction >= 2, "
+                                    "min_survivors >= 1 and patience >= 0.");
+    }
+    trials.clear();
+    for (size_t i = 0; i < configs.size(); ++i) {
+        try {
+            validate(configs[i]);
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument("SweepRunner::run: Trial " + std::to_string(i) + ": " + e.what());
+        }
+        std::unique_ptr<Trial> trial(new Trial());
+        trial->result.index = static_cast<int>(i);
+        trial->result.config = configs[i];
+        for (size_t l = 1; l < configs[i].layer_sizes.size(); ++l) {
+            trial->cost += static_cast<double>(configs[i].layer_sizes[l - 1]) * configs[i].layer_sizes[l];
+        }
+        trials.push_back(std::move(trial));
+    }
+    stopping = early_stopping;
+    on_update = callback;
+    next_rung = stopping.first_rung;
+    running = 0;
+
+    pool.run([this](int) { worker_loop(); });
+
+    std::vector<TrialResult> results;
+    for (const std::unique_ptr<Trial>& trial : trials) results.push_back(trial->result);
+    trials.clear();
+    on_update = Callback();
+    return results;
+}
+
+bool SweepRunner::all_done() const {
+    for (const std::unique_ptr<Trial>& trial : trials) {
+        if (!trial->done) return false;
+    }
+    return true;
+}
+
+// Every surviving trial has reached the next cut and none is mid-epoch.
+bool SweepRunner::rung_reached() const {
+    if (next_rung <= 0 || running > 0) return false;
+    for (const std::unique_ptr<Trial>& trial : trials) {
+        if (!trial->done && trial->result.epochs_run() < next_rung) return false;
+    }
+    return true;
+}
+
+// Least-trained trial first, then the most expensive one, so the long epochs
+// start early and do not hold up the next cut.
+SweepRunner::Trial* SweepRunner::next_trial() {
+    Trial* best = nullptr;
+    for (const std::unique_ptr<Trial>& trial : trials) {
+        if (trial->done || trial->running) continue;
+        int epochs = trial->result.epochs_run();
+        if (next_rung > 0 && epochs >= next_rung) continue;
+        if (!best || epochs < best->result.epochs_run() ||
+            (epochs == best->result.epochs_run() && trial->cost > best->cost)) {
+            best = trial.get();
+        }
+    }
+    return best;
+}
+
+void SweepRunner::worker_loop() {
+    while (true) {
+        Trial* trial = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this, &trial] {
+                trial = next_trial();
+                return trial != nullptr || all_done();
+            });
+            if (!trial) return;
+            trial->running = true;
+            trial->result.status = TrialStatus::Running;
+            running++;
+        }
+
+        double train_loss = 0.0;
+        double validation_loss = 0.0;
+        double validation_accuracy = 0.0;
+        std::string error;
+        Clock::time_point start = Clock::now();
+        try {
+            train_epoch(*trial, train_loss, validation_loss, validation_accuracy);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::vector<TrialResult> updates;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            trial->running = false;
+            running--;
+            trial->cost = seconds;
+            trial->result.seconds += seconds;
+            if (error.empty()) {
+                finish_epoch(*trial, train_loss, validation_loss, validation_accuracy, updates);
+            } else {
+                trial->result.status = TrialStatus::Failed;
+                trial->result.note = error;
+                trial->done = true;
+                trial->net.reset();
+                updates.push_back(trial->result);
+            }
+            while (rung_reached()) resolve_rung(updates);
+        }
+        cv.notify_all();
+        report(updates);
+    }
+}
+
+// One shuffled pass over the shared training set, then the validation set.
+// Only the worker holding the trial touches its network.
+void SweepRunner::train_epoch(Trial& trial, double& train_loss, double& validation_loss, double& validation_accuracy) {
+    const TrialConfig& config = trial.result.config;
+    if (!trial.net) {
+        trial.net.reset(new Network(config.layer_sizes, config.activations, config.init, config.seed, 1));
+        trial.rng.seed(static_cast<unsigned int>(config.seed));
+        trial.order.resize(sample_count);
+    }
+    std::iota(trial.order.begin(), trial.order.end(), 0);
+    std::shuffle(trial.order.begin(), trial.order.end(), trial.rng);
+
+    double total_loss = 0.0;
+    size_t batch_size = static_cast<size_t>(config.batch_size);
+    for (size_t i = 0; i < sample_count; i += batch_size) {
+        size_t end = std::min(i + batch_size, sample_count);
+        std::vector<Matrix> batch_targets;
+        for (size_t j = i; j < end; ++j) batch_targets.push_back(targets[trial.order[j]]);
+        double batch_loss = 0.0;
+        if (sparse_inputs) {
+            SparseMatrix batch_inputs = sparse_inputs->gatherRows(trial.order, i, end);
+            batch_loss = trial.net->train_on_sparse_batch(batch_inputs, batch_targets, config.learning_rate);
+        } else {
+            std::vector<Matrix> batch_inputs;
+            for (size_t j = i; j < end; ++j) batch_inputs.push_back((*inputs)[trial.order[j]]);
+            batch_loss = trial.net->train_on_batch(batch_inputs, batch_targets, config.learning_rate);
+        }
+        total_loss += batch_loss * (end - i);
+    }
+    train_loss = total_loss / sample_count;
+
+    EvaluationResult evaluation = BackgroundEvaluator::evaluate(*trial.net, validation_inputs, validation_targets);
+    validation_loss = evaluation.loss;
+    validation_accuracy = evaluation.accuracy();
+}
+
+void SweepRunner::finish_epoch(Trial& trial, double train_loss, double validation_loss, double validation_accuracy,
+                               std::vector<TrialResult>& updates) {
+    TrialResult& result = trial.result;
+    result.train_loss.push_back(train_loss);
+    result.validation_loss.push_back(validation_loss);
+    result.validation_accuracy.push_back(validation_accuracy);
+    int epoch = result.epochs_run() - 1;
+    if (result.best_epoch < 0 || validation_accuracy > result.best_accuracy()) result.best_epoch = epoch;
+
+    result.status = TrialStatus::Pending;
+    if (result.epochs_run() >= result.config.epochs) {
+        result.status = TrialStatus::Completed;
+    } else if (stopping.patience > 0 && epoch - result.best_epoch >= stopping.patience) {
+        result.status = TrialStatus::Stopped;
+        result.note = "no improvement for " + std::to_string(stopping.patience) + " epochs";
+    }
+    if (result.status != TrialStatus::Pending) {
+        trial.done = true;
+        trial.net.reset();
+    }
+    updates.push_back(result);
+}
+
+void SweepRunner::resolve_rung(std::vector<TrialResult>& updates) {
+    std::vector<Trial*> survivors;
+    int longest = 0;
+    for (const std::unique_ptr<Trial>& trial : trials) {
+        if (!trial->done) {
+            survivors.push_back(trial.get());
+            longest = std::max(longest, trial->result.config.epochs);
+        }
+    }
+    std::sort(survivors.begin(), survivors.end(), [](const Trial* a, const Trial* b) {
+        if (a->result.best_accuracy() != b->result.best_accuracy()) return a->result.best_accuracy() > b->result.best_accuracy();
+        return a->result.index < b->result.index;
+    });
+    size_t keep = (survivors.size() + static_cast<size_t>(stopping.reduction) - 1) / static_cast<size_t>(stopping.reduction);
+    keep = std::max(keep, static_cast<size_t>(stopping.min_survivors));
+    for (size_t rank = keep; rank < survivors.size(); ++rank) {
+        Trial* trial = survivors[rank];
+        trial->result.status = TrialStatus::Stopped;
+        trial->result.note = "cut after epoch " + std::to_string(next_rung) + " (rank " + std::to_string(rank + 1) +
+                             " of " + std::to_string(survivors.size()) + ")";
+        trial->done = true;
+        trial->net.reset();
+        updates.push_back(trial->result);
+    }
+    next_rung *= stopping.reduction;
+    if (keep <= static_cast<size_t>(stopping.min_survivors) || next_rung >= longest) next_rung = 0;
+}
+
+void SweepRunner::report(const std::vector<TrialResult>& updates) {
+    if (!on_update || updates.empty()) return;
+    std::lock_guard<std::mutex> lock(callback_mutex);
+    for (const TrialResult& result : updates) on_update(result);
+}
+
+std::string SweepRunner::format_table(const std::vector<TrialResult>& results) {
+    std::vector<const TrialResult*> ranked;
+    for (const TrialResult& r : results) ranked.push_back(&r);
+    std::stable_sort(ranked.begin(), ranked.end(), [](const TrialResult* a, const TrialResult* b) {
+        return a->best_accuracy() > b->best_accuracy();
+    });
+
+    size_t layers_width = 6;
+    for (const TrialResult* r : ranked) layers_width = std::max(layers_width, r->config.layers_to_string().size());
+
+    std::ostringstream out;
+    out << std::setw(4) << "rank" << std::setw(6) << "trial" << "  " << std::left << std::setw(static_cast<int>(layers_width))
+        << "layers" << std::right << std::setw(10) << "lr" << std::setw(6) << "batch" << std::setw(8) << "epochs"
+        << std::setw(10) << "best acc" << std::setw(6) << "at" << std::setw(12) << "val loss" << std::setw(12)
+        << "train loss" << std::setw(10) << "seconds" << "  status" << "\n";
+    for (size_t rank = 0; rank < ranked.size(); ++rank) {
+        const TrialResult& r = *ranked[rank];
+        out << std::setw(4) << rank + 1 << std::setw(6) << r.index << "  " << std::left << std::setw(static_cast<int>(layers_width))
+            << r.config.layers_to_string() << std::right << std::setw(10) << r.config.learning_rate << std::setw(6)
+            << r.config.batch_size << std::setw(8) << (std::to_string(r.epochs_run()) + "/" + std::to_string(r.config.epochs));
+        if (r.best_epoch >= 0) {
+            out << std::fixed << std::setprecision(2) << std::setw(9) << r.best_accuracy() * 100.0 << "%" << std::setw(6) << r.best_epoch
+                << std::setprecision(6) << std::setw(12) << r.validation_loss[static_cast<size_t>(r.best_epoch)]
+                << std::setw(12) << r.train_loss.back();
+        } else {
+            out << std::setw(10) << "-" << std::setw(6) << "-" << std::setw(12) << "-" << std::setw(12) << "-";
+        }
+        out << std::fixed << std::setprecision(2) << std::setw(10) << r.seconds << "  " << to_string(r.status);
+        if (!r.note.empty()) out << ": " << r.note;
+        out << "\n";
+        out.unsetf(std::ios::floatfield);
+        out << std::setprecision(6);
+    }
+    return out.str();
+}
+
+void SweepRunner::write_csv(const std::string& path, const std::vector<TrialResult>& results) {
+    std::ofstream out(path.c_str());
+    if (!out) {
+        throw std::runtime_error("SweepRunner::write_csv: Cannot open " + path);
+    }
+    out << "trial,layers,activations,init,learning_rate,batch_size,epochs,seed,epochs_run,best_accuracy,best_epoch,"
+           "validation_loss,train_loss,seconds,status,note,validation_accuracy_per_epoch\n";
+    out << std::setprecision(10);
+    for (const TrialResult& r : results) {
+        std::string note = r.note;
+        std::replace(note.begin(), note.end(), '"', '\'');
+        std::vector<std::string> history;
+        for (double a : r.validation_accuracy) {
+            std::ostringstream v;
+            v << std::setprecision(10) << a;
+            history.push_back(v.str());
+        }
+        out << r.index << "," << r.config.layers_to_string() << "," << join(r.config.activations, ':') << ",\""
+            << r.config.init.to_string() << "\"," << r.config.learning_rate << "," << r.config.batch_size << ","
+            << r.config.epochs << "," << r.config.seed << "," << r.epochs_run() << "," << r.best_accuracy() << ","
+            << r.best_epoch << ",";
+        if (r.best_epoch >= 0) out << r.validation_loss[static_cast<size_t>(r.best_epoch)] << "," << r.train_loss.back();
+        else out << ",";
+        out << "," << r.seconds << "," << to_string(r.status) << ",\"" << note << "\"," << join(history, ';') << "\n";
+    }
+    if (!out) {
+        throw std::runtime_error("SweepRunner::write_csv: Failed writing " + path);
+    }
+}
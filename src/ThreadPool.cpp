@@ -0,0 +1,97 @@
+#include "ThreadPool.h"
+#include <stdexcept>
+#include <string>
+
+ThreadPool::ThreadPool(int num_threads, AffinityPolicy policy, const NumaTopology& topology)
+    : affinity(policy),
+      current_task(nullptr),
+      generation(0),
+      remaining(0),
+      stop_requested(false)
+{
+    if (num_threads <= 0) {
+        throw std::invalid_argument("ThreadPool: Thread count must be positive, got " + std::to_string(num_threads));
+    }
+
+    std::vector<int> compact_order;
+    for (int n = 0; n < topology.node_count(); ++n) {
+        compact_order.insert(compact_order.end(), topology.cpus_of(n).begin(), topology.cpus_of(n).end());
+    }
+    for (int w = 0; w < num_threads; ++w) {
+        int cpu = -1;
+        int node = -1;
+        if (policy == AffinityPolicy::Compact) {
+            cpu = compact_order[static_cast<size_t>(w) % compact_order.size()];
+            node = topology.node_of_cpu(cpu);
+        } else if (policy == AffinityPolicy::Scatter) {
+            node = w % topology.node_count();
+            const std::vector<int>& cpus = topology.cpus_of(node);
+            cpu = cpus[static_cast<size_t>(w / topology.node_count()) % cpus.size()];
+        }
+        worker_cpus.push_back(cpu);
+        worker_nodes.push_back(node);
+    }
+
+    for (int w = 0; w < num_threads; ++w) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, w);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_requested = true;
+    }
+    cv.notify_all();
+    for (std::thread& t : workers) {
+        t.join();
+    }
+}
+
+void ThreadPool::run(const std::function<void(int)>& task) {
+    std::unique_lock<std::mutex> lock(mutex);
+    current_task = &task;
+    remaining = size();
+    first_error = nullptr;
+    generation++;
+    cv.notify_all();
+    done_cv.wait(lock, [this] { return remaining == 0; });
+    current_task = nullptr;
+    if (first_error) {
+        std::exception_ptr error = first_error;
+        first_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::worker_loop(int index) {
+    int cpu = worker_cpus[static_cast<size_t>(index)];
+    if (cpu >= 0) {
+        thread_affinity::pin_current_thread(cpu);
+    }
+
+    unsigned long long seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this, seen] { return stop_requested || generation != seen; });
+        if (stop_requested) return;
+        seen = generation;
+        const std::function<void(int)>* task = current_task;
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            (*task)(index);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        if (error && !first_error) {
+            first_error = error;
+        }
+        if (--remaining == 0) {
+            done_cv.notify_all();
+        }
+    }
+}
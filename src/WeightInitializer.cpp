@@ -0,0 +1,181 @@
+#include "WeightInitializer.h"
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+const uint32_t PHILOX_M0 = 0xD2511F53u;
+const uint32_t PHILOX_M1 = 0xCD9E8D57u;
+const uint32_t PHILOX_W0 = 0x9E3779B9u;
+const uint32_t PHILOX_W1 = 0xBB67AE85u;
+
+// Below this many elements per thread, starting threads costs more than it saves.
+const size_t MIN_ELEMENTS_PER_THREAD = 1 << 16;
+
+const double TWO_PI = 6.283185307179586476925286766559;
+const double INV_2_53 = 1.0 / 9007199254740992.0;
+
+inline void philox_round(uint32_t& c0, uint32_t& c1, uint32_t& c2, uint32_t& c3, uint32_t k0, uint32_t k1) {
+    uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c0;
+    uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c2;
+    uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+    uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+    c1 = static_cast<uint32_t>(p1);
+    c3 = static_cast<uint32_t>(p0);
+    c0 = n0;
+    c2 = n2;
+}
+
+inline void philox(uint32_t& c0, uint32_t& c1, uint32_t& c2, uint32_t& c3, uint32_t k0, uint32_t k1) {
+    for (int round = 0; round < 10; ++round) {
+        philox_round(c0, c1, c2, c3, k0, k1);
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+// Uniform on [0, 1) from the top 53 bits of a 64-bit word.
+inline double to_unit(uint32_t hi, uint32_t lo) {
+    return static_cast<double>(((static_cast<uint64_t>(hi) << 32) | lo) >> 11) * INV_2_53;
+}
+
+struct Distribution {
+    bool normal;
+    double a;   // low bound or mean
+    double b;   // high bound or standard deviation
+};
+
+Distribution distribution_for(const WeightInit& init, int fan_in, int fan_out) {
+    if (fan_in <= 0 || fan_out <= 0) {
+        throw std::invalid_argument("WeightInitializer::fill: Fan-in and fan-out must be positive.");
+    }
+    double fans = static_cast<double>(fan_in) + static_cast<double>(fan_out);
+    switch (init.scheme) {
+    case InitScheme::Uniform:
+        if (!(init.b >= init.a)) throw std::invalid_argument("WeightInitializer::fill: Uniform needs a <= b.");
+        return Distribution{false, init.a, init.b};
+    case InitScheme::Normal:
+        if (!(init.b >= 0.0)) throw std::invalid_argument("WeightInitializer::fill: Normal needs a non-negative stddev.");
+        return Distribution{true, init.a, init.b};
+    case InitScheme::XavierUniform: {
+        double limit = std::sqrt(6.0 / fans);
+        return Distribution{false, -limit, limit};
+    }
+    case InitScheme::XavierNormal:
+        return Distribution{true, 0.0, std::sqrt(2.0 / fans)};
+    case InitScheme::HeUniform: {
+        double limit = std::sqrt(6.0 / fan_in);
+        return Distribution{false, -limit, limit};
+    }
+    case InitScheme::HeNormal:
+        return Distribution{true, 0.0, std::sqrt(2.0 / fan_in)};
+    }
+    throw std::invalid_argument("WeightInitializer::fill: Unknown scheme.");
+}
+
+// Elements [begin, end) of the tensor; block j yields elements 2j and 2j + 1.
+// Uniform uses one 64-bit word per element, Normal a Box-Muller pair per block.
+void fill_range(double* data, size_t begin, size_t end, const Distribution& d, uint64_t seed, uint64_t stream) {
+    uint32_t k0 = static_cast<uint32_t>(seed);
+    uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+    uint32_t s0 = static_cast<uint32_t>(stream);
+    uint32_t s1 = static_cast<uint32_t>(stream >> 32);
+    double scale = d.normal ? d.b : d.b - d.a;
+    for (size_t j = begin / 2; 2 * j < end; ++j) {
+        uint32_t c0 = static_cast<uint32_t>(j);
+        uint32_t c1 = static_cast<uint32_t>(static_cast<uint64_t>(j) >> 32);
+        uint32_t c2 = s0;
+        uint32_t c3 = s1;
+        philox(c0, c1, c2, c3, k0, k1);
+        double v[2];
+        if (d.normal) {
+            double u1 = 1.0 - to_unit(c0, c1);   // (0, 1], so the log is finite
+            double u2 = to_unit(c2, c3);
+            double r = std::sqrt(-2.0 * std::log(u1));
+            v[0] = d.a + scale * r * std::cos(TWO_PI * u2);
+            v[1] = d.a + scale * r * std::sin(TWO_PI * u2);
+        } else {
+            v[0] = d.a + scale * to_unit(c0, c1);
+            v[1] = d.a + scale * to_unit(c2, c3);
+        }
+        for (int e = 0; e < 2; ++e) {
+            size_t index = 2 * j + static_cast<size_t>(e);
+            if (index >= begin && index < end) data[index] = v[e];
+        }
+    }
+}
+
+bool parse_pair(const std::string& text, double& a, double& b) {
+    char* end = nullptr;
+    a = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || *end != ',') return false;
+    const char* second = end + 1;
+    b = std::strtod(second, &end);
+    return end != second && *end == '\0';
+}
+
+} // namespace
+
+WeightInit WeightInit::parse(const std::string& spec) {
+    if (spec == "xavier_uniform") return WeightInit(InitScheme::XavierUniform);
+    if (spec == "xavier_normal") return WeightInit(InitScheme::XavierNormal);
+    if (spec == "he_uniform") return WeightInit(InitScheme::HeUniform);
+    if (spec == "he_normal") return WeightInit(InitScheme::HeNormal);
+    double a = 0.0;
+    double b = 0.0;
+    if (spec.compare(0, 8, "uniform:") == 0 && parse_pair(spec.substr(8), a, b)) return WeightInit(InitScheme::Uniform, a, b);
+    if (spec.compare(0, 7, "normal:") == 0 && parse_pair(spec.substr(7), a, b)) return WeightInit(InitScheme::Normal, a, b);
+    throw std::invalid_argument("WeightInit::parse: Unknown initialization '" + spec +
+                                "' (xavier_uniform, xavier_normal, he_uniform, he_normal, uniform:A,B, normal:MEAN,STDDEV)");
+}
+
+std::string WeightInit::to_string() const {
+    std::ostringstream out;
+    switch (scheme) {
+    case InitScheme::Uniform: out << "uniform:" << a << "," << b; break;
+    case InitScheme::Normal: out << "normal:" << a << "," << b; break;
+    case InitScheme::XavierUniform: out << "xavier_uniform"; break;
+    case InitScheme::XavierNormal: out << "xavier_normal"; break;
+    case InitScheme::HeUniform: out << "he_uniform"; break;
+    case InitScheme::HeNormal: out << "he_normal"; break;
+    }
+    return out.str();
+}
+
+WeightInitializer::WeightInitializer(uint64_t seed, int threads) : key(seed), thread_count(threads) {
+    if (threads < 0) {
+        throw std::invalid_argument("WeightInitializer: Thread count cannot be negative.");
+    }
+    if (thread_count == 0) {
+        thread_count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+}
+
+void WeightInitializer::philox4x32_10(uint32_t counter[4], uint32_t key0, uint32_t key1) {
+    philox(counter[0], counter[1], counter[2], counter[3], key0, key1);
+}
+
+void WeightInitializer::fill(double* data, size_t n, const WeightInit& init, int fan_in, int fan_out, uint64_t stream) const {
+    Distribution d = distribution_for(init, fan_in, fan_out);
+    if (n == 0) return;
+    size_t workers = std::min(static_cast<size_t>(thread_count), std::max<size_t>(1, n / MIN_ELEMENTS_PER_THREAD));
+    if (workers == 1) {
+        fill_range(data, 0, n, d, key, stream);
+        return;
+    }
+    // Even chunk boundaries keep each Philox block within one thread.
+    size_t chunk = ((n + workers - 1) / workers + 1) / 2 * 2;
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < workers; ++t) {
+        size_t begin = std::min(n, t * chunk);
+        size_t end = std::min(n, begin + chunk);
+        if (begin < end) pool.push_back(std::thread(fill_range, data, begin, end, d, key, stream));
+    }
+    fill_range(data, 0, std::min(n, chunk), d, key, stream);
+    for (std::thread& t : pool) t.join();
+}
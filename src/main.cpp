@@ -8,14 +8,25 @@
 #include <numeric>   
 #include <algorithm> 
 #include <random>    
+#include <sstream>   
+#include <memory>    
+#include <chrono>    
 
 #include "Matrix.h"      
 #include "Network.h"     
 #include "MNISTLoader.h" 
+#include "Checkpointer.h" 
+#include "StaticNetwork.h" 
+#include "Pruner.h" 
+#include "PrunedNetwork.h" 
+#include "FusedNetwork.h"
+#include "GemmTuner.h"
+#include "BackgroundEvaluator.h"
 
-int get_prediction_digit(Network& net, Matrix& image_input_param) {
-    Matrix image_input = image_input_param; 
-    Matrix prediction_vector = net.predict(image_input);
+typedef StaticNetwork<784, Dense<100, ReLU>, Dense<10, Sigmoid>> MNISTStaticNetwork;
+
+int get_prediction_digit(const Network& net, const Matrix& image_input) {
+    Matrix prediction_vector = net.infer(image_input.view());
     
     int max_idx = 0;
     double max_val = -1.0;
@@ -35,6 +46,12 @@ int get_prediction_digit(Network& net, Matrix& image_input_param) {
     return max_idx;
 }
 
+void print_evaluation(const EvaluationResult& r) {
+    std::cout << "  Test Accuracy after Epoch " << r.epoch << ": "
+              << std::fixed << std::setprecision(4) << r.accuracy() * 100.0 << "%"
+              << " (" << r.correct << "/" << r.samples << "), loss " << std::setprecision(8) << r.loss
+              << " [step " << r.step << ", ready after " << std::setprecision(2) << r.seconds << " s]" << std::endl;
+}
 
 int main() {
     bool use_fixed_seed = true; 
@@ -43,6 +60,21 @@ int main() {
     double learning_rate = 0.01; 
     int epochs = 20; 
     int batch_size = 32; 
+    bool use_sparse_input = true; 
+    int activation_checkpoint_interval = 1; 
+
+    std::string checkpoint_path = "mnist_checkpoint.bin";
+    long long checkpoint_every_batches = 500; 
+    double checkpoint_every_seconds = 60.0; 
+    bool resume_from_checkpoint = false; // continue an interrupted run; a finished one is not resumed
+
+    double prune_sparsity = 0.8; 
+    int prune_fine_tune_epochs = 1; 
+
+    int evaluation_threads = 2; 
+
+    bool autotune_gemm = true; 
+    std::string gemm_tuning_cache = "gemm_tuning.cache";
 
 
     if (use_fixed_seed) {
@@ -64,11 +96,17 @@ int main() {
     int items_to_load_test = 10000;   
 
     MNISTDataset training_data;
+    MNISTSparseDataset sparse_training_data;
     MNISTDataset test_data;
 
     try {
         std::cout << "Loading Training Data..." << std::endl;
-        training_data = MNISTLoader::load(train_images_path, train_labels_path, items_to_load_train);
+        if (use_sparse_input) {
+            sparse_training_data = MNISTLoader::load_sparse(train_images_path, train_labels_path, items_to_load_train);
+            training_data.number_of_items = sparse_training_data.number_of_items;
+        } else {
+            training_data = MNISTLoader::load(train_images_path, train_labels_path, items_to_load_train);
+        }
         std::cout << "Loading Test Data..." << std::endl;
         test_data = MNISTLoader::load(test_images_path, test_labels_path, items_to_load_test);
     } catch (const std::exception& e) {
@@ -81,6 +119,16 @@ int main() {
 
     try {
         Network mnist_net(layer_sizes, activations);
+        mnist_net.set_activation_checkpoint_interval(activation_checkpoint_interval);
+
+        if (autotune_gemm) {
+            GemmTuner gemm_tuner(gemm_tuning_cache);
+            std::vector<GemmTuningResult> tuned = gemm_tuner.tune(GemmTuner::network_shapes(mnist_net, {1, batch_size}));
+            size_t cached = 0;
+            for (const GemmTuningResult& r : tuned) cached += r.from_cache ? 1 : 0;
+            std::cout << "GEMM blocking for " << tuned.size() << " shapes: " << cached << " from " << gemm_tuning_cache
+                      << ", " << (tuned.size() - cached) << " tuned now" << std::endl;
+        }
 
         std::cout << "\n--- Training Started (MNIST CPU-Centric - Full Dataset) ---" << std::endl;
         std::cout << "Network: Input(" << layer_sizes[0] << ")";
@@ -90,66 +138,121 @@ int main() {
         std::cout << std::endl;
         std::cout << "Learning Rate: " << learning_rate 
                   << ", Epochs: " << epochs 
-                  << ", Batch Size: " << batch_size << std::endl;
+                  << ", Batch Size: " << batch_size 
+                  << ", Input: " << (use_sparse_input ? "sparse (CSR)" : "dense") << std::endl;
         std::cout << "Training on " << training_data.number_of_items << " samples." << std::endl;
 
 
         std::vector<size_t> training_indices(training_data.number_of_items);
-        std::iota(training_indices.begin(), training_indices.end(), 0); 
 
-        for (int epoch = 0; epoch < epochs; ++epoch) {
+        // Test accuracy after each epoch is computed on a parameter snapshot by
+        // background threads, so training goes straight on to the next epoch.
+        std::unique_ptr<BackgroundEvaluator> evaluator;
+        EvaluationResult last_evaluation;
+        if (!test_data.images.empty()) {
+            evaluator.reset(new BackgroundEvaluator(mnist_net, test_data.images, test_data.labels, evaluation_threads));
+        }
+
+        Checkpointer checkpointer(checkpoint_path, checkpoint_every_batches, checkpoint_every_seconds);
+        TrainingState train_state;
+        train_state.learning_rate = learning_rate;
+        if (resume_from_checkpoint) {
+            Network restored = mnist_net;
+            TrainingState restored_state = train_state;
+            if (Checkpointer::load(checkpoint_path, restored, restored_state)) {
+                if (restored_state.epoch >= epochs) {
+                    std::cout << "Checkpoint " << checkpoint_path << " is from a finished run (epoch " << restored_state.epoch
+                              << "); training from scratch." << std::endl;
+                } else {
+                    mnist_net = restored;
+                    train_state = restored_state;
+                    std::istringstream rng_in(train_state.rng_state);
+                    rng_in >> rng;
+                    std::cout << "Resumed from checkpoint " << checkpoint_path << " at epoch " << train_state.epoch
+                              << ", sample " << train_state.next_sample << " (step " << train_state.step << ")" << std::endl;
+                }
+            }
+        }
+
+        for (int epoch = train_state.epoch; epoch < epochs; ++epoch) {
+            std::ostringstream rng_out;
+            rng_out << rng;
+            train_state.epoch = epoch;
+            train_state.rng_state = rng_out.str();
+
+            std::iota(training_indices.begin(), training_indices.end(), 0); 
             std::shuffle(training_indices.begin(), training_indices.end(), rng); 
             
             double epoch_total_loss = 0.0;
             int num_batches_processed = 0;
+            size_t epoch_start_sample = static_cast<size_t>(train_state.next_sample);
 
-            for (size_t i = 0; i < static_cast<size_t>(training_data.number_of_items); i += batch_size) {
+            for (size_t i = epoch_start_sample; i < static_cast<size_t>(training_data.number_of_items); i += batch_size) {
                 std::vector<Matrix> batch_inputs;  
                 std::vector<Matrix> batch_targets; 
                 
                 size_t current_batch_end = std::min(i + batch_size, static_cast<size_t>(training_data.number_of_items));
-                for (size_t j = i; j < current_batch_end; ++j) {
-                    batch_inputs.push_back(training_data.images[training_indices[j]]);
-                    batch_targets.push_back(training_data.labels[training_indices[j]]);
-                }
 
-                if (batch_inputs.empty()) continue;
+                double batch_loss = 0.0;
+                if (use_sparse_input) {
+                    SparseMatrix sparse_batch_inputs = sparse_training_data.images.gatherRows(training_indices, i, current_batch_end);
+                    for (size_t j = i; j < current_batch_end; ++j) {
+                        batch_targets.push_back(sparse_training_data.labels[training_indices[j]]);
+                    }
+                    if (batch_targets.empty()) continue;
+                    batch_loss = mnist_net.train_on_sparse_batch(sparse_batch_inputs, batch_targets, learning_rate);
+                } else {
+                    for (size_t j = i; j < current_batch_end; ++j) {
+                        batch_inputs.push_back(training_data.images[training_indices[j]]);
+                        batch_targets.push_back(training_data.labels[training_indices[j]]);
+                    }
+                    if (batch_inputs.empty()) continue;
+                    batch_loss = mnist_net.train_on_batch(batch_inputs, batch_targets, learning_rate);
+                }
 
-                double batch_loss = mnist_net.train_on_batch(batch_inputs, batch_targets, learning_rate);
-                epoch_total_loss += batch_loss * batch_inputs.size(); 
+                epoch_total_loss += batch_loss * batch_targets.size(); 
                 num_batches_processed++;
+
+                train_state.step++;
+                train_state.next_sample = static_cast<long long>(current_batch_end);
+                checkpointer.maybe_checkpoint(mnist_net, train_state);
             }
 
-            double average_epoch_loss = (training_data.number_of_items > 0) ? (epoch_total_loss / training_data.number_of_items) : 0.0;
+            std::ostringstream next_rng_out;
+            next_rng_out << rng;
+            train_state.epoch = epoch + 1;
+            train_state.next_sample = 0;
+            train_state.rng_state = next_rng_out.str();
+            checkpointer.checkpoint(mnist_net, train_state);
+
+            size_t epoch_samples = static_cast<size_t>(training_data.number_of_items) - epoch_start_sample;
+            double average_epoch_loss = (epoch_samples > 0) ? (epoch_total_loss / epoch_samples) : 0.0;
             std::cout << "Epoch " << std::setw(3) << epoch << "/" << epochs - 1
                       << ", Average Training Loss: " << std::fixed << std::setprecision(8)
                       << average_epoch_loss << std::endl;
 
-            if ((epoch % 1 == 0 || epoch == epochs -1) && !test_data.images.empty()) { 
-                int correct_predictions = 0;
-                for(size_t k=0; k < static_cast<size_t>(test_data.number_of_items); ++k) {
-                    int predicted_digit = get_prediction_digit(mnist_net, test_data.images[k]);
-                    
-                    Matrix actual_label_host = test_data.labels[k]; 
-
-                    int actual_digit = -1; 
-                    for(int l=0; l<actual_label_host.getRow(); ++l) {
-                        if(actual_label_host.getEntry(l,0) == 1.0) {
-                            actual_digit = l;
-                            break;
-                        }
-                    }
-                    if (predicted_digit == actual_digit) {
-                        correct_predictions++;
-                    }
+            if (evaluator) {
+                evaluator->submit(mnist_net, epoch, train_state.step);
+                for (const EvaluationResult& r : evaluator->take_completed()) {
+                    print_evaluation(r);
+                    last_evaluation = r;
                 }
-                double accuracy = (test_data.images.size() > 0) ? (static_cast<double>(correct_predictions) / test_data.images.size()) : 0.0;
-                std::cout << "  Test Accuracy after Epoch " << epoch << ": " 
-                          << std::fixed << std::setprecision(4) << accuracy * 100.0 << "%" 
-                          << " (" << correct_predictions << "/" << test_data.images.size() << ")" << std::endl;
             }
         }
-        std::cout << "--- Training Finished ---" << std::endl << std::endl;
+        if (evaluator) {
+            evaluator->wait();
+            for (const EvaluationResult& r : evaluator->take_completed()) {
+                print_evaluation(r);
+                last_evaluation = r;
+            }
+            if (last_evaluation.samples > 0) {
+                std::cout << "Confusion matrix after Epoch " << last_evaluation.epoch << ":\n"
+                          << last_evaluation.confusion_to_string();
+            }
+        }
+        checkpointer.flush();
+        std::cout << "--- Training Finished --- (" << checkpointer.checkpoints_written() << " checkpoints written to "
+                  << checkpoint_path << ")" << std::endl << std::endl;
 
         std::cout << "--- Final Test Set Evaluation ---" << std::endl;
         if (!test_data.images.empty()) {
@@ -171,8 +274,105 @@ int main() {
                 }
             }
             double accuracy = (test_data.images.size() > 0) ? (static_cast<double>(correct_predictions) / test_data.images.size()) : 0.0;
-            std::cout << "Final Test Accuracy: " << accuracy * 100.0 << "%" 
+            std::cout << "Final Test Accuracy: " << std::fixed << std::setprecision(4) << accuracy * 100.0 << "%" 
                       << " (" << correct_predictions << "/" << test_data.images.size() << ")" << std::endl;
+
+            std::unique_ptr<MNISTStaticNetwork> static_net(new MNISTStaticNetwork());
+            static_net->load_from(mnist_net);
+            int static_correct_predictions = 0;
+            auto static_start = std::chrono::steady_clock::now();
+            for(size_t k=0; k < static_cast<size_t>(test_data.number_of_items); ++k) {
+                Matrix prediction_vector = static_net->predict(test_data.images[k]);
+                int predicted_digit = 0;
+                for (int i = 1; i < prediction_vector.getRow(); ++i) {
+                    if (prediction_vector.getEntry(i, 0) > prediction_vector.getEntry(predicted_digit, 0)) {
+                        predicted_digit = i;
+                    }
+                }
+                if (test_data.labels[k].getEntry(predicted_digit, 0) == 1.0) {
+                    static_correct_predictions++;
+                }
+            }
+            std::chrono::duration<double, std::micro> static_elapsed = std::chrono::steady_clock::now() - static_start;
+            std::cout << "Static Network Test Accuracy: " << static_cast<double>(static_correct_predictions) / test_data.images.size() * 100.0 << "%"
+                      << " (" << std::setprecision(2) << static_elapsed.count() / test_data.images.size() << " us/sample)" << std::endl;
+
+            // The whole test set as one features x samples batch, run tile by tile.
+            FusedNetwork fused_net(mnist_net);
+            Matrix test_batch(layer_sizes.front(), static_cast<int>(test_data.images.size()));
+            for (size_t k = 0; k < test_data.images.size(); ++k) {
+                for (int i = 0; i < layer_sizes.front(); ++i) {
+                    test_batch.setEntry(i, static_cast<int>(k), test_data.images[k].getEntry(i, 0));
+                }
+            }
+            auto fused_start = std::chrono::steady_clock::now();
+            Matrix fused_predictions = fused_net.infer(test_batch.view());
+            std::chrono::duration<double, std::micro> fused_elapsed = std::chrono::steady_clock::now() - fused_start;
+            int fused_correct_predictions = 0;
+            for (size_t k = 0; k < test_data.images.size(); ++k) {
+                int predicted_digit = 0;
+                for (int i = 1; i < fused_predictions.getRow(); ++i) {
+                    if (fused_predictions.getEntry(i, static_cast<int>(k)) > fused_predictions.getEntry(predicted_digit, static_cast<int>(k))) {
+                        predicted_digit = i;
+                    }
+                }
+                if (test_data.labels[k].getEntry(predicted_digit, 0) == 1.0) {
+                    fused_correct_predictions++;
+                }
+            }
+            std::cout << "Fused Network Test Accuracy: " << std::setprecision(4)
+                      << static_cast<double>(fused_correct_predictions) / test_data.images.size() * 100.0 << "%"
+                      << " (" << std::setprecision(2) << fused_elapsed.count() / test_data.images.size() << " us/sample, tiles of "
+                      << fused_net.tile_size() << ")" << std::endl;
+
+            if (prune_sparsity > 0.0) {
+                Network pruned_net = mnist_net;
+                Pruner pruner(prune_sparsity, PruningScope::Global);
+                pruner.prune(pruned_net);
+                for (int epoch = 0; epoch < prune_fine_tune_epochs; ++epoch) {
+                    std::iota(training_indices.begin(), training_indices.end(), 0);
+                    std::shuffle(training_indices.begin(), training_indices.end(), rng);
+                    for (size_t i = 0; i < static_cast<size_t>(training_data.number_of_items); i += batch_size) {
+                        size_t current_batch_end = std::min(i + batch_size, static_cast<size_t>(training_data.number_of_items));
+                        std::vector<Matrix> batch_inputs;
+                        std::vector<Matrix> batch_targets;
+                        for (size_t j = i; j < current_batch_end; ++j) {
+                            if (!use_sparse_input) batch_inputs.push_back(training_data.images[training_indices[j]]);
+                            batch_targets.push_back(use_sparse_input ? sparse_training_data.labels[training_indices[j]]
+                                                                     : training_data.labels[training_indices[j]]);
+                        }
+                        if (use_sparse_input) {
+                            pruner.fine_tune_on_sparse_batch(pruned_net, sparse_training_data.images.gatherRows(training_indices, i, current_batch_end),
+                                                             batch_targets, learning_rate);
+                        } else {
+                            pruner.fine_tune_on_batch(pruned_net, batch_inputs, batch_targets, learning_rate);
+                        }
+                    }
+                }
+
+                PrunedNetwork sparse_net(pruned_net);
+                int pruned_correct_predictions = 0;
+                auto pruned_start = std::chrono::steady_clock::now();
+                for(size_t k=0; k < static_cast<size_t>(test_data.number_of_items); ++k) {
+                    Matrix prediction_vector = sparse_net.infer(test_data.images[k].view());
+                    int predicted_digit = 0;
+                    for (int i = 1; i < prediction_vector.getRow(); ++i) {
+                        if (prediction_vector.getEntry(i, 0) > prediction_vector.getEntry(predicted_digit, 0)) {
+                            predicted_digit = i;
+                        }
+                    }
+                    if (test_data.labels[k].getEntry(predicted_digit, 0) == 1.0) {
+                        pruned_correct_predictions++;
+                    }
+                }
+                std::chrono::duration<double, std::micro> pruned_elapsed = std::chrono::steady_clock::now() - pruned_start;
+                std::cout << "Pruned Network (" << std::setprecision(0) << Pruner::sparsity(pruned_net) * 100.0 << "% sparse, "
+                          << prune_fine_tune_epochs << " fine-tune epochs) Test Accuracy: " << std::setprecision(4)
+                          << static_cast<double>(pruned_correct_predictions) / test_data.images.size() * 100.0 << "%"
+                          << " (" << std::setprecision(2) << pruned_elapsed.count() / test_data.images.size() << " us/sample, "
+                          << sparse_net.storage_bytes() / 1024 << " KiB weights vs "
+                          << PrunedNetwork::dense_storage_bytes(mnist_net) / 1024 << " KiB dense)" << std::endl;
+            }
         }
 
 
@@ -0,0 +1,187 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <csignal>
+#include <ctime>
+#include <pthread.h>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "Checkpointer.h"
+#include "InferenceServer.h"
+
+// Serves a network over a Unix domain socket with dynamic batching until
+// SIGINT/SIGTERM, printing the server counters periodically. With --self-test
+// it instead starts the server, drives it from local client threads, checks
+// every answer against Network::infer and prints the counters.
+//
+//   inference_server --socket /tmp/nn.sock --checkpoint mnist_checkpoint.bin
+//   inference_server --socket /tmp/nn.sock --self-test 8 --requests 2000
+
+namespace {
+
+struct Options {
+    std::string socket_path = "/tmp/nn_inference.sock";
+    std::vector<int> layers = {784, 100, 10};
+    std::vector<std::string> activations = {"relu", "sigmoid"};
+    std::string checkpoint;
+    int max_batch = 32;
+    int max_delay_us = 2000;
+    int send_timeout_ms = 100;
+    double stats_interval = 10.0;
+    int self_test_clients = 0;
+    int requests_per_client = 1000;
+    unsigned int seed = 123;
+};
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--socket PATH] [--layers 784,100,10] [--activations relu,sigmoid]\n"
+              << "       [--checkpoint FILE] [--max-batch N] [--max-delay-us US] [--send-timeout-ms MS]\n"
+              << "       [--stats-interval S] [--self-test CLIENTS [--requests N]] [--seed S]" << std::endl;
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, sep)) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--socket" && has_value) opt.socket_path = argv[++i];
+        else if (arg == "--layers" && has_value) {
+            opt.layers.clear();
+            for (const std::string& n : split(argv[++i], ',')) opt.layers.push_back(std::atoi(n.c_str()));
+        }
+        else if (arg == "--activations" && has_value) opt.activations = split(argv[++i], ',');
+        else if (arg == "--checkpoint" && has_value) opt.checkpoint = argv[++i];
+        else if (arg == "--max-batch" && has_value) opt.max_batch = std::atoi(argv[++i]);
+        else if (arg == "--max-delay-us" && has_value) opt.max_delay_us = std::atoi(argv[++i]);
+        else if (arg == "--send-timeout-ms" && has_value) opt.send_timeout_ms = std::atoi(argv[++i]);
+        else if (arg == "--stats-interval" && has_value) opt.stats_interval = std::atof(argv[++i]);
+        else if (arg == "--self-test" && has_value) opt.self_test_clients = std::atoi(argv[++i]);
+        else if (arg == "--requests" && has_value) opt.requests_per_client = std::atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) opt.seed = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else return false;
+    }
+    return opt.layers.size() >= 2 && opt.activations.size() + 1 == opt.layers.size() &&
+           opt.max_batch > 0 && opt.max_delay_us >= 0 && opt.send_timeout_ms > 0 && opt.stats_interval > 0.0 && opt.requests_per_client > 0;
+}
+
+int self_test(const Options& opt, const Network& net, InferenceServer& server) {
+    std::atomic<long long> mismatches(0);
+    std::atomic<int> failed_clients(0);
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < opt.self_test_clients; ++c) {
+        clients.emplace_back([&, c]() {
+            try {
+                InferenceClient client(opt.socket_path);
+                unsigned int state = opt.seed + static_cast<unsigned int>(c);
+                for (int r = 0; r < opt.requests_per_client; ++r) {
+                    Matrix x(server.input_size(), 1, false);
+                    for (int i = 0; i < server.input_size(); ++i) {
+                        x.setEntry(i, 0, static_cast<double>(rand_r(&state)) / RAND_MAX);
+                    }
+                    Matrix served = client.predict(x);
+                    Matrix expected = net.infer(x.view());
+                    for (int i = 0; i < expected.getRow(); ++i) {
+                        if (std::fabs(served.getEntry(i, 0) - expected.getEntry(i, 0)) > 1e-12) {
+                            mismatches++;
+                            break;
+                        }
+                    }
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "client " << c << ": " << e.what() << std::endl;
+                failed_clients++;
+            }
+        });
+    }
+    for (std::thread& t : clients) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    InferenceClient observer(opt.socket_path);
+    InferenceServerStats s = observer.stats();
+    long long total = static_cast<long long>(opt.self_test_clients) * opt.requests_per_client;
+    std::cout << opt.self_test_clients << " clients x " << opt.requests_per_client << " requests: "
+              << std::fixed << std::setprecision(0) << total / seconds << " req/s, "
+              << mismatches.load() << " mismatches, " << failed_clients.load() << " failed clients" << std::endl;
+    std::cout << "server: " << s.to_string() << std::endl;
+    return (mismatches.load() == 0 && failed_clients.load() == 0) ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    try {
+        srand(opt.seed);
+        Network net(opt.layers, opt.activations);
+        if (!opt.checkpoint.empty()) {
+            TrainingState state;
+            if (!Checkpointer::load(opt.checkpoint, net, state)) {
+                std::cerr << "No checkpoint at " << opt.checkpoint << std::endl;
+                return 1;
+            }
+            std::cout << "Loaded " << opt.checkpoint << " (epoch " << state.epoch << ", step " << state.step << ")" << std::endl;
+        }
+
+        InferenceServerConfig config;
+        config.socket_path = opt.socket_path;
+        config.max_batch_size = opt.max_batch;
+        config.max_queue_delay_us = opt.max_delay_us;
+        config.send_timeout_ms = opt.send_timeout_ms;
+
+        // Block the stop signals before any thread starts so only sigtimedwait sees them.
+        sigset_t stop_signals;
+        sigemptyset(&stop_signals);
+        sigaddset(&stop_signals, SIGINT);
+        sigaddset(&stop_signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
+        InferenceServer server(net, config);
+        server.start();
+        std::cout << "Serving " << server.input_size() << " -> " << server.output_size() << " on " << opt.socket_path
+                  << " (max batch " << opt.max_batch << ", max delay " << opt.max_delay_us << " us)" << std::endl;
+
+        if (opt.self_test_clients > 0) {
+            int status = self_test(opt, net, server);
+            server.stop();
+            return status;
+        }
+
+        timespec interval;
+        interval.tv_sec = static_cast<time_t>(opt.stats_interval);
+        interval.tv_nsec = static_cast<long>((opt.stats_interval - static_cast<double>(interval.tv_sec)) * 1e9);
+        while (sigtimedwait(&stop_signals, nullptr, &interval) < 0) {
+            std::cout << server.stats().to_string() << std::endl;
+        }
+        std::cout << "Stopping: " << server.stats().to_string() << std::endl;
+        server.stop();
+    } catch (const std::exception& e) {
+        std::cerr << "inference_server: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "InferenceServer.h"
+#include "LatencyHistogram.h"
+
+// Open-loop latency load generator for a network topology. Each of the
+// --concurrency workers issues requests on its own Poisson schedule at
+// qps / concurrency, and latency is measured from the scheduled send time, so a
+// worker that falls behind reports the queueing delay rather than silently
+// slowing the offered load. Requests go straight to Network::infer on a shared
+// network (inproc) or through InferenceClient to an InferenceServer (socket),
+// which is started in-process unless --connect names a running one.
+//
+//   load_generator --layers 784,100,10 --qps 500,1000,2000 --concurrency 4
+//   load_generator --transport socket --max-batch 16 --qps 1000,4000 --duration 10
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::vector<int> layers = {784, 100, 10};
+    std::vector<std::string> activations = {"relu", "sigmoid"};
+    std::string transport = "inproc";
+    std::string socket_path = "/tmp/nn_loadgen.sock";
+    bool connect = false;
+    std::vector<double> qps = {250, 500, 1000, 2000};
+    int concurrency = 4;
+    double duration = 5.0;
+    int max_batch = 32;
+    int max_delay_us = 500;
+    unsigned int seed = 123;
+};
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--layers 784,100,10] [--activations relu,sigmoid]\n"
+              << "       [--transport inproc|socket] [--socket PATH] [--connect]\n"
+              << "       [--qps 250,500,1000] [--concurrency N] [--duration S]\n"
+              << "       [--max-batch N] [--max-delay-us US] [--seed S]" << std::endl;
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, sep)) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--layers" && has_value) {
+            opt.layers.clear();
+            for (const std::string& n : split(argv[++i], ',')) opt.layers.push_back(std::atoi(n.c_str()));
+        }
+        else if (arg == "--activations" && has_value) opt.activations = split(argv[++i], ',');
+        else if (arg == "--transport" && has_value) opt.transport = argv[++i];
+        else if (arg == "--socket" && has_value) opt.socket_path = argv[++i];
+        else if (arg == "--connect") opt.connect = true;
+        else if (arg == "--qps" && has_value) {
+            opt.qps.clear();
+            for (const std::string& q : split(argv[++i], ',')) opt.qps.push_back(std::atof(q.c_str()));
+        }
+        else if (arg == "--concurrency" && has_value) opt.concurrency = std::atoi(argv[++i]);
+        else if (arg == "--duration" && has_value) opt.duration = std::atof(argv[++i]);
+        else if (arg == "--max-batch" && has_value) opt.max_batch = std::atoi(argv[++i]);
+        else if (arg == "--max-delay-us" && has_value) opt.max_delay_us = std::atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) opt.seed = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else return false;
+    }
+    if (opt.transport != "inproc" && opt.transport != "socket") return false;
+    for (double q : opt.qps) {
+        if (q <= 0.0) return false;
+    }
+    return opt.layers.size() >= 2 && opt.activations.size() + 1 == opt.layers.size() && !opt.qps.empty() &&
+           opt.concurrency > 0 && opt.duration > 0.0 && opt.max_batch > 0 && opt.max_delay_us >= 0;
+}
+
+struct WorkerResult {
+    LatencyHistogram latencies;
+    long long late;          // sent more than 1 ms after their scheduled time
+    std::string error;
+    WorkerResult() : late(0) {}
+};
+
+void run_worker(const Options& opt, const Network& net, double worker_qps, Clock::time_point start,
+                Clock::time_point end, unsigned int seed, WorkerResult& result) {
+    try {
+        std::default_random_engine rng(seed);
+        std::uniform_real_distribution<double> pixel(0.0, 1.0);
+        std::vector<Matrix> inputs;
+        for (int s = 0; s < 32; ++s) {
+            Matrix x(opt.layers.front(), 1, false);
+            for (int i = 0; i < opt.layers.front(); ++i) x.setEntry(i, 0, pixel(rng));
+            inputs.push_back(x);
+        }
+        std::unique_ptr<InferenceClient> client;
+        if (opt.transport == "socket") client.reset(new InferenceClient(opt.socket_path));
+
+        std::exponential_distribution<double> gap(worker_qps);
+        Clock::time_point scheduled = start;
+        for (size_t n = 0;; ++n) {
+            scheduled += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap(rng)));
+            if (scheduled >= end) break;
+            std::this_thread::sleep_until(scheduled);
+            Clock::time_point sent = Clock::now();
+            if (sent - scheduled > std::chrono::milliseconds(1)) result.late++;
+
+            const Matrix& x = inputs[n % inputs.size()];
+            if (client) client->predict(x);
+            else net.infer(x.view());
+
+            result.latencies.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - scheduled).count()));
+        }
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+}
+
+std::string micros(uint64_t ns) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << static_cast<double>(ns) / 1000.0;
+    return out.str();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    try {
+        srand(opt.seed);
+        Network net(opt.layers, opt.activations);
+        std::unique_ptr<InferenceServer> server;
+        if (opt.transport == "socket" && !opt.connect) {
+            InferenceServerConfig config;
+            config.socket_path = opt.socket_path;
+            config.max_batch_size = opt.max_batch;
+            config.max_queue_delay_us = opt.max_delay_us;
+            server.reset(new InferenceServer(net, config));
+            server->start();
+        }
+
+        std::cout << "Topology ";
+        for (size_t i = 0; i < opt.layers.size(); ++i) std::cout << (i ? "-" : "") << opt.layers[i];
+        std::cout << ", " << opt.transport;
+        if (opt.transport == "socket") {
+            std::cout << " " << opt.socket_path;
+            if (server) std::cout << " (in-process server, max batch " << opt.max_batch << ", max delay " << opt.max_delay_us << " us)";
+        }
+        std::cout << ", " << opt.concurrency << " workers, " << opt.duration << " s per level" << std::endl;
+        std::cout << std::setw(10) << "offered" << std::setw(11) << "achieved" << std::setw(10) << "requests"
+                  << std::setw(8) << "late%" << std::setw(10) << "mean us" << std::setw(10) << "p50 us"
+                  << std::setw(10) << "p99 us" << std::setw(11) << "p999 us" << std::setw(11) << "max us" << std::endl;
+
+        for (double qps : opt.qps) {
+            std::vector<WorkerResult> results(static_cast<size_t>(opt.concurrency));
+            std::vector<std::thread> workers;
+            Clock::time_point start = Clock::now() + std::chrono::milliseconds(10);
+            Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.duration));
+            for (int w = 0; w < opt.concurrency; ++w) {
+                workers.emplace_back(run_worker, std::cref(opt), std::cref(net), qps / opt.concurrency, start, end,
+                                     opt.seed + 1000u * static_cast<unsigned int>(w + 1), std::ref(results[static_cast<size_t>(w)]));
+            }
+            for (std::thread& t : workers) {
+                t.join();
+            }
+            double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+            LatencyHistogram merged;
+            long long late = 0;
+            for (const WorkerResult& r : results) {
+                if (!r.error.empty()) throw std::runtime_error(r.error);
+                merged.merge(r.latencies);
+                late += r.late;
+            }
+            double n = static_cast<double>(merged.count());
+            std::cout << std::fixed << std::setprecision(0) << std::setw(10) << qps << std::setw(11) << n / elapsed
+                      << std::setw(10) << merged.count() << std::setprecision(1) << std::setw(8)
+                      << (n > 0 ? 100.0 * static_cast<double>(late) / n : 0.0)
+                      << std::setw(10) << merged.mean() / 1000.0 << std::setw(10) << micros(merged.percentile(50.0))
+                      << std::setw(10) << micros(merged.percentile(99.0)) << std::setw(11) << micros(merged.percentile(99.9))
+                      << std::setw(11) << micros(merged.max()) << std::endl;
+        }
+
+        if (server) {
+            std::cout << "server: " << server->stats().to_string() << std::endl;
+            server->stop();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "load_generator: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
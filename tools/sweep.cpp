@@ -0,0 +1,233 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <stdexcept>
+#include <sys/resource.h>
+
+#include "Matrix.h"
+#include "SparseMatrix.h"
+#include "MNISTLoader.h"
+#include "ThreadPool.h"
+#include "SweepRunner.h"
+
+// Hyperparameter sweep over MNIST in one process: the training set is loaded
+// once (CSR, as in main.cpp) and shared by every trial, which run concurrently
+// on a pinned ThreadPool. The grid is the product of the listed hidden layer
+// shapes, learning rates and batch sizes; poor trials are cut by successive
+// halving (see EarlyStopping).
+//
+//   sweep --hidden 50,100,200 --lr 0.005,0.01,0.05 --batch 16,32 --epochs 9
+//   sweep --hidden 100,256:64 --activation relu --rung 2 --reduction 2 --csv sweep.csv
+
+namespace {
+
+struct Options {
+    std::string data_dir = ".";
+    int train_items = 60000;
+    int holdout = 10000;
+    std::vector<std::string> hidden = {"100"};
+    std::vector<double> learning_rates = {0.01};
+    std::vector<int> batch_sizes = {32};
+    std::string activation = "relu";
+    std::string init = "xavier_uniform";
+    int epochs = 10;
+    unsigned long long seed = 123;
+    int threads = 0;
+    AffinityPolicy policy = AffinityPolicy::Scatter;
+    EarlyStopping stopping;
+    std::string csv;
+};
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--data DIR] [--train N] [--holdout N]\n"
+              << "       [--hidden 50,100,256:64] [--lr 0.005,0.01] [--batch 16,32] [--activation relu] [--init SPEC]\n"
+              << "       [--epochs N] [--seed S] [--threads N] [--affinity none|compact|scatter]\n"
+              << "       [--rung EPOCHS] [--reduction R] [--min-survivors N] [--patience N] [--csv FILE]\n"
+              << "  --holdout 0 validates on the t10k test files instead of the last N training samples;\n"
+              << "  --rung 0 disables successive halving." << std::endl;
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, sep)) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--data" && has_value) opt.data_dir = argv[++i];
+        else if (arg == "--train" && has_value) opt.train_items = std::atoi(argv[++i]);
+        else if (arg == "--holdout" && has_value) opt.holdout = std::atoi(argv[++i]);
+        else if (arg == "--hidden" && has_value) opt.hidden = split(argv[++i], ',');
+        else if (arg == "--lr" && has_value) {
+            opt.learning_rates.clear();
+            for (const std::string& v : split(argv[++i], ',')) opt.learning_rates.push_back(std::atof(v.c_str()));
+        }
+        else if (arg == "--batch" && has_value) {
+            opt.batch_sizes.clear();
+            for (const std::string& v : split(argv[++i], ',')) opt.batch_sizes.push_back(std::atoi(v.c_str()));
+        }
+        else if (arg == "--activation" && has_value) opt.activation = argv[++i];
+        else if (arg == "--init" && has_value) opt.init = argv[++i];
+        else if (arg == "--epochs" && has_value) opt.epochs = std::atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) opt.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && has_value) opt.threads = std::atoi(argv[++i]);
+        else if (arg == "--affinity" && has_value) {
+            std::string p = argv[++i];
+            if (p == "none") opt.policy = AffinityPolicy::None;
+            else if (p == "compact") opt.policy = AffinityPolicy::Compact;
+            else if (p == "scatter") opt.policy = AffinityPolicy::Scatter;
+            else return false;
+        }
+        else if (arg == "--rung" && has_value) opt.stopping.first_rung = std::atoi(argv[++i]);
+        else if (arg == "--reduction" && has_value) opt.stopping.reduction = std::atoi(argv[++i]);
+        else if (arg == "--min-survivors" && has_value) opt.stopping.min_survivors = std::atoi(argv[++i]);
+        else if (arg == "--patience" && has_value) opt.stopping.patience = std::atoi(argv[++i]);
+        else if (arg == "--csv" && has_value) opt.csv = argv[++i];
+        else return false;
+    }
+    return opt.train_items > 0 && opt.holdout >= 0 && opt.holdout < opt.train_items && opt.epochs > 0 &&
+           opt.threads >= 0 && !opt.hidden.empty() && !opt.learning_rates.empty() && !opt.batch_sizes.empty();
+}
+
+std::vector<TrialConfig> build_grid(const Options& opt, int inputs, int outputs) {
+    WeightInit init = WeightInit::parse(opt.init);
+    std::vector<TrialConfig> trials;
+    for (const std::string& shape : opt.hidden) {
+        for (double lr : opt.learning_rates) {
+            for (int batch : opt.batch_sizes) {
+                TrialConfig trial;
+                trial.layer_sizes.push_back(inputs);
+                for (const std::string& width : split(shape, ':')) {
+                    trial.layer_sizes.push_back(std::atoi(width.c_str()));
+                    trial.activations.push_back(opt.activation);
+                }
+                trial.layer_sizes.push_back(outputs);
+                trial.activations.push_back("sigmoid");
+                trial.learning_rate = lr;
+                trial.batch_size = batch;
+                trial.epochs = opt.epochs;
+                trial.seed = opt.seed + trials.size();
+                trial.init = init;
+                trials.push_back(trial);
+            }
+        }
+    }
+    return trials;
+}
+
+// Row r of a samples x features CSR matrix as a features x 1 column.
+Matrix dense_column(const SparseMatrix& m, int r) {
+    Matrix column(m.getCol(), 1, 0.0);
+    double* v = column.get_host_ptr();
+    for (int k = m.getRowPtr()[static_cast<size_t>(r)]; k < m.getRowPtr()[static_cast<size_t>(r) + 1]; ++k) {
+        v[m.getColIndices()[static_cast<size_t>(k)]] = m.getValues()[static_cast<size_t>(k)];
+    }
+    return column;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    try {
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point start = Clock::now();
+        std::string dir = opt.data_dir + "/";
+        MNISTSparseDataset train = MNISTLoader::load_sparse(dir + "train-images-idx3-ubyte", dir + "train-labels-idx1-ubyte",
+                                                            opt.train_items);
+        std::vector<Matrix> validation_inputs;
+        std::vector<Matrix> validation_targets;
+        if (opt.holdout > 0) {
+            if (train.number_of_items <= opt.holdout) {
+                throw std::invalid_argument("--holdout " + std::to_string(opt.holdout) + " leaves no training samples of " +
+                                            std::to_string(train.number_of_items));
+            }
+            size_t kept = static_cast<size_t>(train.number_of_items) - static_cast<size_t>(opt.holdout);
+            for (size_t r = kept; r < static_cast<size_t>(train.number_of_items); ++r) {
+                validation_inputs.push_back(dense_column(train.images, static_cast<int>(r)));
+                validation_targets.push_back(train.labels[r]);
+            }
+            std::vector<size_t> first(kept);
+            for (size_t r = 0; r < kept; ++r) first[r] = r;
+            train.images = train.images.gatherRows(first, 0, kept);
+            train.labels.resize(kept);
+            train.number_of_items = static_cast<int>(kept);
+        } else {
+            MNISTDataset test = MNISTLoader::load(dir + "t10k-images-idx3-ubyte", dir + "t10k-labels-idx1-ubyte");
+            validation_inputs.swap(test.images);
+            validation_targets.swap(test.labels);
+        }
+        double load_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        double shared_mb = (train.images.nonZeros() * (sizeof(double) + sizeof(int)) +
+                            validation_inputs.size() * validation_inputs[0].getRow() * sizeof(double)) / 1048576.0;
+
+        std::vector<TrialConfig> trials = build_grid(opt, train.images.getCol(), train.labels[0].getRow());
+        int threads = opt.threads > 0 ? opt.threads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        ThreadPool pool(threads, opt.policy);
+
+        std::cout << trials.size() << " trials on " << threads << " threads; " << train.number_of_items << " training and "
+                  << validation_inputs.size() << " validation samples (" << std::fixed << std::setprecision(1) << shared_mb
+                  << " MB, shared) loaded once in " << std::setprecision(2) << load_seconds << " s" << std::endl;
+        if (opt.stopping.first_rung > 0) {
+            std::cout << "Successive halving: keep 1/" << opt.stopping.reduction << " after epoch " << opt.stopping.first_rung
+                      << ", then every x" << opt.stopping.reduction << " epochs" << std::endl;
+        }
+
+        SweepRunner runner(train.images, train.labels, validation_inputs, validation_targets);
+        Clock::time_point sweep_start = Clock::now();
+        std::vector<TrialResult> results = runner.run(trials, pool, opt.stopping, [](const TrialResult& r) {
+            std::cout << "  trial " << std::setw(3) << r.index << " " << std::setw(14) << r.config.layers_to_string()
+                      << " lr " << std::setw(8) << std::defaultfloat << r.config.learning_rate << " batch " << std::setw(4)
+                      << r.config.batch_size;
+            if (r.epochs_run() > 0) {
+                std::cout << "  epoch " << std::setw(3) << r.epochs_run() - 1 << ": val acc " << std::fixed << std::setprecision(2)
+                          << r.validation_accuracy.back() * 100.0 << "%, train loss " << std::setprecision(6) << r.train_loss.back();
+            }
+            if (r.status == TrialStatus::Completed || r.status == TrialStatus::Stopped || r.status == TrialStatus::Failed) {
+                std::cout << "  [" << to_string(r.status) << (r.note.empty() ? "" : ": " + r.note) << "]";
+            }
+            std::cout << std::endl;
+        });
+        double sweep_seconds = std::chrono::duration<double>(Clock::now() - sweep_start).count();
+
+        double trial_seconds = 0.0;
+        int epochs_run = 0;
+        for (const TrialResult& r : results) {
+            trial_seconds += r.seconds;
+            epochs_run += r.epochs_run();
+        }
+        rusage usage_stats;
+        getrusage(RUSAGE_SELF, &usage_stats);
+
+        std::cout << "\n" << SweepRunner::format_table(results) << std::fixed << std::setprecision(2)
+                  << "\nSweep: " << sweep_seconds << " s wall, " << trial_seconds << " s of trial time ("
+                  << trial_seconds / sweep_seconds << "x concurrency), " << epochs_run << " of "
+                  << trials.size() * static_cast<size_t>(opt.epochs) << " epochs run, peak RSS "
+                  << std::setprecision(1) << usage_stats.ru_maxrss / 1024.0 << " MB" << std::endl;
+        if (!opt.csv.empty()) {
+            SweepRunner::write_csv(opt.csv, results);
+            std::cout << "Wrote " << opt.csv << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "sweep: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <numeric>
+#include <algorithm>
+#include <random>
+#include <memory>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "MNISTLoader.h"
+#include "Communicator.h"
+#include "DataParallelTrainer.h"
+
+// Data-parallel MNIST training. Without --rank the tool forks --ranks local
+// workers; with --rank and --endpoints it runs a single rank of a multi-host
+// job over TCP.
+//
+//   train_data_parallel --ranks 4 --transport shm
+//   train_data_parallel --ranks 2 --transport tcp --port 29500
+//   train_data_parallel --rank 1 --endpoints hostA:29500,hostB:29500
+
+namespace {
+
+struct Options {
+    int ranks = 2;
+    int rank = -1;
+    std::string transport = "shm";
+    std::vector<std::string> endpoints;
+    int base_port = 29500;
+    int epochs = 5;
+    int batch_size = 32;
+    double learning_rate = 0.01;
+    int train_items = 60000;
+    int test_items = 10000;
+    bool sparse = true;
+    bool overlap = true;
+    unsigned int seed = 123;
+    std::string data_dir = ".";
+};
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--ranks N] [--transport shm|tcp] [--port P] [--rank R --endpoints h:p,...]\n"
+              << "       [--epochs E] [--batch-size B] [--lr X] [--train-items N] [--test-items N]\n"
+              << "       [--dense] [--no-overlap] [--seed S] [--data-dir DIR]" << std::endl;
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, sep)) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--ranks" && has_value) opt.ranks = std::atoi(argv[++i]);
+        else if (arg == "--rank" && has_value) opt.rank = std::atoi(argv[++i]);
+        else if (arg == "--transport" && has_value) opt.transport = argv[++i];
+        else if (arg == "--endpoints" && has_value) opt.endpoints = split(argv[++i], ',');
+        else if (arg == "--port" && has_value) opt.base_port = std::atoi(argv[++i]);
+        else if (arg == "--epochs" && has_value) opt.epochs = std::atoi(argv[++i]);
+        else if (arg == "--batch-size" && has_value) opt.batch_size = std::atoi(argv[++i]);
+        else if (arg == "--lr" && has_value) opt.learning_rate = std::atof(argv[++i]);
+        else if (arg == "--train-items" && has_value) opt.train_items = std::atoi(argv[++i]);
+        else if (arg == "--test-items" && has_value) opt.test_items = std::atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) opt.seed = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--data-dir" && has_value) opt.data_dir = argv[++i];
+        else if (arg == "--dense") opt.sparse = false;
+        else if (arg == "--no-overlap") opt.overlap = false;
+        else return false;
+    }
+    if (!opt.endpoints.empty()) {
+        opt.ranks = static_cast<int>(opt.endpoints.size());
+        opt.transport = "tcp";
+    }
+    if (opt.ranks < 1 || opt.batch_size < 1 || (opt.transport != "shm" && opt.transport != "tcp")) return false;
+    if (opt.rank >= 0 && opt.endpoints.empty() && opt.transport == "tcp") {
+        opt.endpoints = TcpCommunicator::local_endpoints(opt.ranks, opt.base_port);
+    }
+    return true;
+}
+
+int argmax(const Matrix& m) {
+    int best = 0;
+    for (int i = 1; i < m.getRow(); ++i) {
+        if (m.getEntry(i, 0) > m.getEntry(best, 0)) best = i;
+    }
+    return best;
+}
+
+int run_rank(const Options& opt, int rank, const std::string& shm_name) {
+    std::unique_ptr<Communicator> comm;
+    if (opt.transport == "shm") {
+        comm.reset(new ShmCommunicator(rank, opt.ranks, shm_name));
+    } else {
+        std::vector<std::string> endpoints = opt.endpoints.empty()
+            ? TcpCommunicator::local_endpoints(opt.ranks, opt.base_port) : opt.endpoints;
+        comm.reset(new TcpCommunicator(rank, endpoints));
+    }
+
+    std::string dir = opt.data_dir + "/";
+    MNISTDataset train_data;
+    MNISTSparseDataset sparse_train_data;
+    MNISTDataset test_data;
+    if (opt.sparse) {
+        sparse_train_data = MNISTLoader::load_sparse(dir + "train-images-idx3-ubyte", dir + "train-labels-idx1-ubyte", opt.train_items);
+        train_data.number_of_items = sparse_train_data.number_of_items;
+    } else {
+        train_data = MNISTLoader::load(dir + "train-images-idx3-ubyte", dir + "train-labels-idx1-ubyte", opt.train_items);
+    }
+    if (rank == 0) {
+        test_data = MNISTLoader::load(dir + "t10k-images-idx3-ubyte", dir + "t10k-labels-idx1-ubyte", opt.test_items);
+    }
+
+    srand(opt.seed);
+    Network net({784, 100, 10}, {"relu", "sigmoid"});
+    DataParallelTrainer trainer(net, *comm, opt.overlap);
+    trainer.broadcast_parameters();
+
+    if (rank == 0) {
+        std::cout << "Data-parallel training: " << opt.ranks << " ranks over " << opt.transport
+                  << ", global batch " << opt.batch_size << ", " << (opt.sparse ? "sparse" : "dense") << " input"
+                  << (opt.overlap ? ", overlapped allreduce" : "") << std::endl;
+    }
+
+    // Every rank draws the same permutation, so the global batches agree and
+    // each rank only looks at its own shard of them.
+    std::default_random_engine rng(opt.seed);
+    std::vector<size_t> indices(static_cast<size_t>(train_data.number_of_items));
+    auto start = std::chrono::steady_clock::now();
+    for (int epoch = 0; epoch < opt.epochs; ++epoch) {
+        std::iota(indices.begin(), indices.end(), 0);
+        std::shuffle(indices.begin(), indices.end(), rng);
+
+        double epoch_loss = 0.0;
+        for (size_t i = 0; i < indices.size(); i += static_cast<size_t>(opt.batch_size)) {
+            size_t end = std::min(i + static_cast<size_t>(opt.batch_size), indices.size());
+            std::vector<Matrix> targets;
+            double batch_loss = 0.0;
+            if (opt.sparse) {
+                for (size_t j = i; j < end; ++j) targets.push_back(sparse_train_data.labels[indices[j]]);
+                batch_loss = trainer.train_on_sparse_batch(sparse_train_data.images.gatherRows(indices, i, end), targets, opt.learning_rate);
+            } else {
+                std::vector<Matrix> inputs;
+                for (size_t j = i; j < end; ++j) {
+                    inputs.push_back(train_data.images[indices[j]]);
+                    targets.push_back(train_data.labels[indices[j]]);
+                }
+                batch_loss = trainer.train_on_batch(inputs, targets, opt.learning_rate);
+            }
+            epoch_loss += batch_loss * static_cast<double>(end - i);
+        }
+        if (rank == 0) {
+            std::cout << "Epoch " << std::setw(3) << epoch << "/" << opt.epochs - 1
+                      << ", Average Training Loss: " << std::fixed << std::setprecision(8)
+                      << epoch_loss / static_cast<double>(indices.size()) << std::endl;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (rank == 0) {
+        int correct = 0;
+        for (size_t k = 0; k < test_data.images.size(); ++k) {
+            if (test_data.labels[k].getEntry(argmax(net.infer(test_data.images[k].view())), 0) == 1.0) {
+                correct++;
+            }
+        }
+        std::cout << "Test Accuracy: " << std::setprecision(4)
+                  << (test_data.images.empty() ? 0.0 : 100.0 * correct / test_data.images.size()) << "%"
+                  << " (" << correct << "/" << test_data.images.size() << "), training time "
+                  << std::setprecision(2) << elapsed.count() << " s" << std::endl;
+    }
+    comm->barrier();
+    return 0;
+}
+
+int run_rank_guarded(const Options& opt, int rank, const std::string& shm_name) {
+    try {
+        return run_rank(opt, rank, shm_name);
+    } catch (const std::exception& e) {
+        std::cerr << "Rank " << rank << ": " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::string shm_name = "/nn_data_parallel_" + std::to_string(getpid());
+    if (opt.rank >= 0) {
+        return run_rank_guarded(opt, opt.rank, shm_name);
+    }
+
+    std::vector<pid_t> children;
+    for (int r = 1; r < opt.ranks; ++r) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "fork failed" << std::endl;
+            return 1;
+        }
+        if (pid == 0) {
+            _exit(run_rank_guarded(opt, r, shm_name));
+        }
+        children.push_back(pid);
+    }
+    int status = run_rank_guarded(opt, 0, shm_name);
+    for (pid_t pid : children) {
+        int child_status = 0;
+        waitpid(pid, &child_status, 0);
+        if (!WIFEXITED(child_status) || WEXITSTATUS(child_status) != 0) {
+            status = 1;
+        }
+    }
+    return status;
+}
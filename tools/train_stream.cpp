@@ -0,0 +1,192 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <csignal>
+#include <pthread.h>
+#include <cstdlib>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "Checkpointer.h"
+#include "SampleSource.h"
+#include "StreamingTrainer.h"
+
+// Trains a network from a sample stream without loading the dataset first.
+// Text and binary sources accept "-" for stdin, so the data can come from a
+// pipe; "synthetic" draws an endless noisy linear-classification problem.
+//
+//   train_stream --source idx:train-images-idx3-ubyte.gz,train-labels-idx1-ubyte.gz --shuffle-buffer 4096
+//   producer | train_stream --source text:- --layers 4,16,3 --activations relu,sigmoid
+//   train_stream --source synthetic --max-samples 1000000 --report-every 500
+
+namespace {
+
+struct Options {
+    std::string source = "idx:train-images-idx3-ubyte,train-labels-idx1-ubyte";
+    std::vector<int> layers = {784, 100, 10};
+    std::vector<std::string> activations = {"relu", "sigmoid"};
+    StreamingConfig config;
+    std::string checkpoint;
+};
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--source idx:IMAGES,LABELS|text:PATH|binary:PATH|synthetic]\n"
+              << "       [--layers 784,100,10] [--activations relu,sigmoid] [--batch-size B] [--lr X]\n"
+              << "       [--shuffle-buffer N] [--prefetch N] [--max-samples N] [--report-every BATCHES]\n"
+              << "       [--seed S] [--checkpoint FILE]" << std::endl;
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, sep)) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--source" && has_value) opt.source = argv[++i];
+        else if (arg == "--layers" && has_value) {
+            opt.layers.clear();
+            for (const std::string& n : split(argv[++i], ',')) opt.layers.push_back(std::atoi(n.c_str()));
+        }
+        else if (arg == "--activations" && has_value) opt.activations = split(argv[++i], ',');
+        else if (arg == "--batch-size" && has_value) opt.config.batch_size = std::atoi(argv[++i]);
+        else if (arg == "--lr" && has_value) opt.config.learning_rate = std::atof(argv[++i]);
+        else if (arg == "--shuffle-buffer" && has_value) opt.config.shuffle_buffer = std::atoi(argv[++i]);
+        else if (arg == "--prefetch" && has_value) opt.config.prefetch = std::atoi(argv[++i]);
+        else if (arg == "--max-samples" && has_value) opt.config.max_samples = std::atoll(argv[++i]);
+        else if (arg == "--report-every" && has_value) opt.config.report_every = std::atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) opt.config.seed = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--checkpoint" && has_value) opt.checkpoint = argv[++i];
+        else return false;
+    }
+    for (int v : opt.layers) {
+        if (v <= 0) return false;
+    }
+    return opt.layers.size() >= 2 && opt.activations.size() + 1 == opt.layers.size() &&
+           opt.config.batch_size > 0 && opt.config.prefetch > 0 && opt.config.shuffle_buffer >= 0;
+}
+
+// Labels are the argmax of a fixed random projection of uniform inputs, with
+// a little label noise.
+std::unique_ptr<SampleSource> synthetic_source(int inputs, int classes, unsigned int seed) {
+    std::shared_ptr<std::mt19937> rng(new std::mt19937(seed));
+    std::shared_ptr<std::vector<double> > projection(new std::vector<double>(static_cast<size_t>(inputs) * classes));
+    std::normal_distribution<double> normal(0.0, 1.0);
+    for (double& w : *projection) w = normal(*rng);
+    GeneratorSampleSource::Generator generate = [rng, projection, inputs, classes](Matrix& x, Matrix& y) {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        x = Matrix(inputs, 1);
+        double* v = x.get_host_ptr();
+        for (int i = 0; i < inputs; ++i) v[i] = uniform(*rng);
+        int best = 0;
+        double best_score = 0.0;
+        for (int c = 0; c < classes; ++c) {
+            double score = 0.0;
+            for (int i = 0; i < inputs; ++i) score += (*projection)[static_cast<size_t>(c) * inputs + i] * (v[i] - 0.5);
+            if (c == 0 || score > best_score) {
+                best = c;
+                best_score = score;
+            }
+        }
+        if (uniform(*rng) < 0.05) best = static_cast<int>(uniform(*rng) * classes) % classes;
+        y = Matrix(classes, 1, 0.0);
+        y.setEntry(best, 0, 1.0);
+        return true;
+    };
+    return std::unique_ptr<SampleSource>(new GeneratorSampleSource(generate, inputs, classes));
+}
+
+std::unique_ptr<SampleSource> open_source(const Options& opt) {
+    std::string kind = opt.source.substr(0, opt.source.find(':'));
+    std::string arg = opt.source.find(':') == std::string::npos ? std::string() : opt.source.substr(opt.source.find(':') + 1);
+    int inputs = opt.layers.front();
+    int outputs = opt.layers.back();
+    if (kind == "idx") {
+        std::vector<std::string> paths = split(arg, ',');
+        if (paths.size() != 2) throw std::invalid_argument("--source idx:IMAGES,LABELS needs two paths");
+        return std::unique_ptr<SampleSource>(new IdxSampleSource(paths[0], paths[1], outputs));
+    }
+    if (kind == "text") return std::unique_ptr<SampleSource>(new TextSampleSource(arg, inputs, outputs));
+    if (kind == "binary") return std::unique_ptr<SampleSource>(new BinarySampleSource(arg, inputs, outputs));
+    if (kind == "synthetic") return synthetic_source(inputs, outputs, opt.config.seed);
+    throw std::invalid_argument("Unknown source " + opt.source);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    try {
+        // Block the stop signals before any thread starts (IDX sources start
+        // one) so only the watcher sees them; SIGINT/SIGTERM end the stream and
+        // keep what was trained.
+        sigset_t stop_signals;
+        sigemptyset(&stop_signals);
+        sigaddset(&stop_signals, SIGINT);
+        sigaddset(&stop_signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+        std::unique_ptr<SampleSource> source = open_source(opt);
+        srand(opt.config.seed);
+        Network net(opt.layers, opt.activations);
+        StreamingTrainer trainer(net, *source, opt.config);
+
+        std::cout << "Streaming from " << opt.source << ", batch " << opt.config.batch_size
+                  << ", shuffle buffer " << opt.config.shuffle_buffer << ", prefetch " << opt.config.prefetch << std::endl;
+        std::atomic<bool> finished(false);
+        std::thread watcher([&] {
+            timespec interval = {0, 200000000};
+            while (!finished) {
+                if (sigtimedwait(&stop_signals, nullptr, &interval) >= 0) {
+                    trainer.stop();
+                    return;
+                }
+            }
+        });
+        StreamingStats stats;
+        try {
+            stats = trainer.run([](const StreamingStats& s) {
+                std::cout << "  " << s.to_string() << std::endl;
+            });
+        } catch (...) {
+            finished = true;
+            watcher.join();
+            throw;
+        }
+        finished = true;
+        watcher.join();
+        std::cout << "Done: " << stats.to_string() << ", " << std::setprecision(2) << stats.seconds << " s" << std::endl;
+
+        if (!opt.checkpoint.empty()) {
+            ParameterSnapshot params;
+            net.snapshot_parameters(params);
+            TrainingState state;
+            state.step = stats.batches;
+            state.next_sample = stats.samples;
+            state.learning_rate = opt.config.learning_rate;
+            Checkpointer::save(opt.checkpoint, params, state);
+            std::cout << "Saved " << opt.checkpoint << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "train_stream: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+
+#include "Matrix.h"
+#include "Network.h"
+#include "GemmTuner.h"
+
+// Tunes Matrix::multiply blocking for the forward and backward GEMMs of a
+// topology at the given batch sizes and stores the winners in the cache file,
+// which Network users (main.cpp) load at startup. Shapes already cached for
+// this CPU are reported without benchmarking; delete the file to retune.
+//
+//   tune_gemm --layers 784,100,10 --batch-sizes 1,32,128,512 --cache gemm_tuning.cache
+
+namespace {
+
+struct Options {
+    std::vector<int> layers = {784, 100, 10};
+    std::vector<int> batch_sizes = {1, 32, 128, 512};
+    std::string cache_path = "gemm_tuning.cache";
+    double seconds_per_candidate = 0.01;
+};
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--layers 784,100,10] [--batch-sizes 1,32,128,512]\n"
+              << "       [--cache FILE] [--seconds-per-candidate S]" << std::endl;
+}
+
+std::vector<int> parse_ints(const std::string& s) {
+    std::vector<int> values;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (!part.empty()) values.push_back(std::atoi(part.c_str()));
+    }
+    return values;
+}
+
+bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--layers" && has_value) opt.layers = parse_ints(argv[++i]);
+        else if (arg == "--batch-sizes" && has_value) opt.batch_sizes = parse_ints(argv[++i]);
+        else if (arg == "--cache" && has_value) opt.cache_path = argv[++i];
+        else if (arg == "--seconds-per-candidate" && has_value) opt.seconds_per_candidate = std::atof(argv[++i]);
+        else return false;
+    }
+    for (int v : opt.layers) {
+        if (v <= 0) return false;
+    }
+    for (int v : opt.batch_sizes) {
+        if (v <= 0) return false;
+    }
+    return opt.layers.size() >= 2 && !opt.batch_sizes.empty() && opt.seconds_per_candidate > 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    try {
+        Network net(opt.layers, std::vector<std::string>(opt.layers.size() - 1, "linear"));
+        GemmTuner tuner(opt.cache_path, opt.seconds_per_candidate);
+        std::cout << "CPU: " << tuner.cpu() << std::endl;
+        std::cout << "  " << std::setw(18) << "m x k x n" << std::setw(18) << "block m/k/n"
+                  << std::setw(10) << "speedup" << "  source" << std::endl;
+        std::vector<GemmTuningResult> results = tuner.tune(GemmTuner::network_shapes(net, opt.batch_sizes));
+        for (const GemmTuningResult& r : results) {
+            std::ostringstream shape;
+            shape << r.shape.m << "x" << r.shape.k << "x" << r.shape.n;
+            std::ostringstream blocking;
+            blocking << (r.blocking.block_m ? std::to_string(r.blocking.block_m) : std::string("all")) << "/"
+                     << r.blocking.block_k << "/" << r.blocking.block_n;
+            std::cout << "  " << std::setw(18) << shape.str() << std::setw(18) << blocking.str()
+                      << std::fixed << std::setprecision(2) << std::setw(9) << r.speedup << "x"
+                      << "  " << (r.from_cache ? "cache" : "tuned") << std::endl;
+        }
+        std::cout << "Cache: " << opt.cache_path << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "tune_gemm: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}